@@ -18,6 +18,13 @@ if [[ $JOB_NAME != *"code-coverage" && $JOB_NAME != *"limited-build" ]]; then
     # Cleanup
     ./waf --color=yes distclean
 
+    # Build in release mode with benchmarks, which measure the library as it is shipped
+    ./waf --color=yes configure --with-benchmarks
+    ./waf --color=yes build
+
+    # Cleanup
+    ./waf --color=yes distclean
+
     # Build in release mode with examples
     ./waf --color=yes configure --with-examples
     ./waf --color=yes build
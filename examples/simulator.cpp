@@ -0,0 +1,394 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/validator-null.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/scheduler.hpp>
+
+#include "access-manager.hpp"
+#include "decryptor.hpp"
+#include "encryptor.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <set>
+
+// Enclosing code in ndn simplifies coding (can also use `using namespace ndn`)
+namespace ndn {
+namespace nac {
+// Additional nested namespaces should be used to prevent/limit name conflicts
+namespace examples {
+
+/**
+ * Load generator for the complete NAC pipeline.
+ *
+ * The data owner (AccessManager), the producer (M Encryptors, as in producer.cpp), and N consumers
+ * (Decryptors, as in consumer.cpp) run in one process and exchange KEK, CK, and KDK packets
+ * through in-process DummyClientFaces, which are interconnected by a simulated broadcast
+ * network with configurable one-way delay and loss.  Each stream periodically encrypts a
+ * packet that is handed to all consumers, and rotates its CK after a configurable number
+ * of packets.
+ */
+struct SimulatorOptions
+{
+  size_t nConsumers = 4;
+  size_t nStreams = 2;
+  size_t nPacketsPerStream = 1000;
+  size_t rotationInterval = 100;
+  size_t payloadSize = 1024;
+  time::milliseconds packetInterval = 1_ms;
+  time::milliseconds linkDelay = 5_ms;
+  double lossRate = 0.0;
+  unsigned int seed = 0;
+};
+
+class SimulatedNetwork
+{
+public:
+  SimulatedNetwork(boost::asio::io_context& io, const SimulatorOptions& options)
+    : m_scheduler(io)
+    , m_delay(options.linkDelay)
+    , m_loss(options.lossRate)
+    , m_rng(options.seed)
+  {
+  }
+
+  void
+  connect(DummyClientFace& face)
+  {
+    m_faces.push_back(&face);
+    face.onSendInterest.connect([this, &face] (const Interest& interest) {
+      if (!isLocalhost(interest.getName()))
+        broadcast(face, interest);
+    });
+    face.onSendData.connect([this, &face] (const Data& data) {
+      broadcast(face, data);
+    });
+    face.onSendNack.connect([this, &face] (const lp::Nack& nack) {
+      broadcast(face, nack);
+    });
+  }
+
+  size_t
+  getNDelivered() const
+  {
+    return m_nDelivered;
+  }
+
+  size_t
+  getNDropped() const
+  {
+    return m_nDropped;
+  }
+
+private:
+  static bool
+  isLocalhost(const Name& name)
+  {
+    static const Name LOCALHOST("/localhost");
+    return LOCALHOST.isPrefixOf(name);
+  }
+
+  template<typename Packet>
+  void
+  broadcast(DummyClientFace& origin, const Packet& packet)
+  {
+    for (auto* face : m_faces) {
+      if (face == &origin)
+        continue;
+
+      if (m_loss(m_rng)) {
+        ++m_nDropped;
+        continue;
+      }
+
+      ++m_nDelivered;
+      m_scheduler.schedule(m_delay, [face, packet] { face->receive(packet); });
+    }
+  }
+
+private:
+  Scheduler m_scheduler;
+  time::milliseconds m_delay;
+  std::bernoulli_distribution m_loss;
+  std::mt19937 m_rng;
+  std::vector<DummyClientFace*> m_faces;
+  size_t m_nDelivered = 0;
+  size_t m_nDropped = 0;
+};
+
+class Simulator
+{
+public:
+  explicit
+  Simulator(const SimulatorOptions& options)
+    : m_options(options)
+    , m_network(m_io, options)
+    , m_scheduler(m_io)
+  {
+    m_network.connect(m_managerFace);
+    m_network.connect(m_producerFace);
+
+    auto accessIdentity = m_keyChain.createIdentity("/nac/simulator");
+    m_accessManager = std::make_unique<AccessManager>(accessIdentity, "dataset", m_keyChain, m_managerFace);
+
+    for (size_t i = 0; i < m_options.nStreams; ++i) {
+      m_encryptors.push_back(std::make_unique<Encryptor>("/nac/simulator/NAC/dataset",
+                                                         Name("/nac/simulator/stream").appendNumber(i),
+                                                         signingWithSha256(),
+                                                         [] (const ErrorCode&, const std::string& error) {
+                                                           std::cerr << "Encryptor failure: " << error << std::endl;
+                                                         },
+                                                         m_validator, m_keyChain, m_producerFace));
+    }
+
+    for (size_t i = 0; i < m_options.nConsumers; ++i) {
+      auto identity = m_keyChain.createIdentity(Name("/nac/simulator/consumer").appendNumber(i), RsaKeyParams());
+      m_accessManager->addMember(identity.getDefaultKey().getDefaultCertificate());
+
+      auto consumer = std::make_unique<Consumer>(m_io, m_keyChain);
+      m_network.connect(consumer->face);
+      consumer->decryptor = std::make_unique<Decryptor>(identity.getDefaultKey(), m_validator,
+                                                        m_keyChain, consumer->face);
+      m_consumers.push_back(std::move(consumer));
+    }
+  }
+
+  void
+  run()
+  {
+    // wait until every stream has fetched the KEK and published its first CK
+    waitForKeks();
+
+    m_nExpected = m_options.nStreams * m_options.nPacketsPerStream * m_options.nConsumers;
+    m_startTime = time::steady_clock::now();
+    for (size_t i = 0; i < m_options.nStreams; ++i) {
+      produce(i, 0);
+    }
+    m_io.run();
+    auto duration = time::steady_clock::now() - m_startTime;
+
+    report(duration);
+  }
+
+private:
+  struct Consumer
+  {
+    Consumer(boost::asio::io_context& io, KeyChain& keyChain)
+      : face(io, keyChain, {false, true})
+    {
+    }
+
+    DummyClientFace face;
+    std::unique_ptr<Decryptor> decryptor;
+    std::set<Name> readyCks;
+  };
+
+  void
+  waitForKeks()
+  {
+    Scheduler scheduler(m_io);
+    std::function<void()> check = [&] {
+      bool isReady = std::all_of(m_encryptors.begin(), m_encryptors.end(),
+                                 [] (const auto& encryptor) { return encryptor->size() > 0; });
+      if (isReady) {
+        m_io.stop();
+      }
+      else {
+        scheduler.schedule(1_ms, check);
+      }
+    };
+    check();
+    m_io.run();
+    m_io.restart();
+  }
+
+  void
+  produce(size_t stream, size_t nProduced)
+  {
+    if (nProduced == m_options.nPacketsPerStream)
+      return;
+
+    auto& encryptor = *m_encryptors[stream];
+    if (nProduced > 0 && nProduced % m_options.rotationInterval == 0) {
+      encryptor.regenerateCk();
+      ++m_nRotations;
+    }
+
+    Buffer payload(m_options.payloadSize);
+    auto content = encryptor.encrypt(payload);
+    const Name& ckName = content.getKeyLocator();
+    const Block& wire = content.wireEncode();
+
+    for (auto& consumer : m_consumers) {
+      bool isCkCached = consumer->readyCks.count(ckName) > 0;
+      auto start = time::steady_clock::now();
+      consumer->decryptor->decrypt(wire,
+        [this, &consumer, ckName, isCkCached, start] (ConstBufferPtr) {
+          auto latency = time::duration_cast<time::microseconds>(time::steady_clock::now() - start);
+          if (isCkCached) {
+            m_steadyLatencies.push_back(latency);
+          }
+          else {
+            consumer->readyCks.insert(ckName);
+            m_firstLatencies.push_back(latency);
+          }
+          complete();
+        },
+        [this] (const ErrorCode&, const std::string&) {
+          ++m_nFailures;
+          complete();
+        });
+    }
+
+    m_scheduler.schedule(m_options.packetInterval, [=] { produce(stream, nProduced + 1); });
+  }
+
+  void
+  complete()
+  {
+    if (++m_nCompleted == m_nExpected) {
+      m_io.stop();
+    }
+  }
+
+  static time::microseconds
+  percentile(std::vector<time::microseconds>& samples, double p)
+  {
+    if (samples.empty())
+      return time::microseconds(0);
+    std::sort(samples.begin(), samples.end());
+    return samples[std::min(samples.size() - 1, static_cast<size_t>(samples.size() * p))];
+  }
+
+  void
+  report(time::nanoseconds duration)
+  {
+    auto seconds = time::duration_cast<time::duration<double>>(duration).count();
+    size_t nSuccesses = m_firstLatencies.size() + m_steadyLatencies.size();
+
+    std::cout << "Consumers x streams:             " << m_options.nConsumers << " x " << m_options.nStreams << "\n"
+              << "Packets per stream:              " << m_options.nPacketsPerStream << "\n"
+              << "CK rotations:                    " << m_nRotations << "\n"
+              << "Successful decrypts:             " << nSuccesses << "\n"
+              << "Failed decrypts:                 " << m_nFailures << "\n"
+              << "Throughput (decrypts/s):         " << (seconds > 0 ? nSuccesses / seconds : 0) << "\n"
+              << "First-decrypt latency p50 (us):  " << percentile(m_firstLatencies, 0.50).count() << "\n"
+              << "First-decrypt latency p99 (us):  " << percentile(m_firstLatencies, 0.99).count() << "\n"
+              << "Steady-state latency p50 (us):   " << percentile(m_steadyLatencies, 0.50).count() << "\n"
+              << "Steady-state latency p99 (us):   " << percentile(m_steadyLatencies, 0.99).count() << "\n"
+              << "Packets delivered / dropped:     " << m_network.getNDelivered() << " / "
+              << m_network.getNDropped() << std::endl;
+  }
+
+private:
+  SimulatorOptions m_options;
+  boost::asio::io_context m_io;
+  KeyChain m_keyChain{"pib-memory:", "tpm-memory:"};
+  security::ValidatorNull m_validator;
+  SimulatedNetwork m_network;
+  Scheduler m_scheduler;
+
+  DummyClientFace m_managerFace{m_io, m_keyChain, {false, true}};
+  DummyClientFace m_producerFace{m_io, m_keyChain, {false, true}};
+  std::unique_ptr<AccessManager> m_accessManager;
+  std::vector<std::unique_ptr<Encryptor>> m_encryptors;
+  std::vector<std::unique_ptr<Consumer>> m_consumers;
+
+  time::steady_clock::time_point m_startTime;
+  size_t m_nExpected = 0;
+  size_t m_nCompleted = 0;
+  size_t m_nFailures = 0;
+  size_t m_nRotations = 0;
+  std::vector<time::microseconds> m_firstLatencies;
+  std::vector<time::microseconds> m_steadyLatencies;
+};
+
+static void
+usage(std::ostream& os, const char* programName)
+{
+  os << "Usage: " << programName << " [options]\n"
+     << "\n"
+     << "Options:\n"
+     << "  --consumers N     number of consumers (default 4)\n"
+     << "  --streams M       number of producer streams, one Encryptor each (default 2)\n"
+     << "  --packets P       number of packets produced per stream (default 1000)\n"
+     << "  --rotation R      regenerate CK every R packets (default 100)\n"
+     << "  --payload BYTES   size of each plaintext payload (default 1024)\n"
+     << "  --interval MS     interval between packets of a stream (default 1)\n"
+     << "  --delay MS        one-way link delay (default 5)\n"
+     << "  --loss RATE       packet loss probability in [0, 1) (default 0)\n"
+     << "  --seed N          seed for the loss process (default 0)\n";
+}
+
+} // namespace examples
+} // namespace nac
+} // namespace ndn
+
+int
+main(int argc, char** argv)
+{
+  using ndn::nac::examples::usage;
+
+  ndn::nac::examples::SimulatorOptions options;
+  try {
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "-h" || arg == "--help") {
+        usage(std::cout, argv[0]);
+        return 0;
+      }
+      if (i + 1 >= argc) {
+        throw std::invalid_argument("missing value for " + arg);
+      }
+      std::string value = argv[++i];
+
+      if (arg == "--consumers")      { options.nConsumers = std::stoul(value); }
+      else if (arg == "--streams")   { options.nStreams = std::stoul(value); }
+      else if (arg == "--packets")   { options.nPacketsPerStream = std::stoul(value); }
+      else if (arg == "--rotation")  { options.rotationInterval = std::max(1UL, std::stoul(value)); }
+      else if (arg == "--payload")   { options.payloadSize = std::stoul(value); }
+      else if (arg == "--interval")  { options.packetInterval = ndn::time::milliseconds(std::stoul(value)); }
+      else if (arg == "--delay")     { options.linkDelay = ndn::time::milliseconds(std::stoul(value)); }
+      else if (arg == "--loss")      { options.lossRate = std::stod(value); }
+      else if (arg == "--seed")      { options.seed = std::stoul(value); }
+      else {
+        throw std::invalid_argument("unknown option " + arg);
+      }
+    }
+  }
+  catch (const std::logic_error& e) {
+    std::cerr << "ERROR: " << e.what() << "\n\n";
+    usage(std::cerr, argv[0]);
+    return 2;
+  }
+
+  try {
+    ndn::nac::examples::Simulator simulator(options);
+    simulator.run();
+    return 0;
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -18,76 +18,251 @@
  */
 
 #include "access-manager.hpp"
+#include "detail/ecies.hpp"
+#include "detail/key-tree.hpp"
+#include "detail/merkle-batch.hpp"
+#include "detail/probes.hpp"
+#include "detail/serving-index.hpp"
 #include "encrypted-content.hpp"
+#include "kdk-server.hpp"
+#include "secure-memory.hpp"
 
 #include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/util/exception.hpp>
 #include <ndn-cxx/util/logger.hpp>
 #include <ndn-cxx/util/random.hpp>
 
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
 namespace ndn::nac {
 
 NDN_LOG_INIT(nac.AccessManager);
 
+namespace {
+
+// a producer keeps using a KEK for its FreshnessPeriod, and consumers retrieve CKs encrypted with
+// it for the FreshnessPeriod of the CK
+constexpr time::seconds PREVIOUS_NAC_KEY_LIFETIME = DEFAULT_KEK_FRESHNESS_PERIOD + DEFAULT_CK_FRESHNESS_PERIOD;
+
+/**
+ * @brief Parameters for a key pair of the same type and size as @p key
+ */
+std::unique_ptr<KeyParams>
+makeKeyParams(const Key& key)
+{
+  auto publicKey = key.getPublicKey();
+  auto p = publicKey.data();
+  auto pkey = d2i_PUBKEY(nullptr, &p, static_cast<long>(publicKey.size()));
+  if (pkey == nullptr) {
+    NDN_THROW(Error("Failed to load public key of " + key.getName().toUri()));
+  }
+  auto size = static_cast<uint32_t>(EVP_PKEY_bits(pkey));
+  EVP_PKEY_free(pkey);
+
+  if (key.getKeyType() == KeyType::EC) {
+    return std::make_unique<EcKeyParams>(size);
+  }
+  return std::make_unique<RsaKeyParams>(size);
+}
+
+/**
+ * @brief Encrypt @p secret with the public key of @p memberCert
+ */
+ConstBufferPtr
+encryptForMember(const Certificate& memberCert, span<const uint8_t> secret)
+{
+  if (detail::isEciesKey(memberCert.getPublicKey())) {
+    return detail::eciesWrap(memberCert.getPublicKey(), secret);
+  }
+  PublicKey memberKey;
+  memberKey.loadPkcs8(memberCert.getPublicKey());
+  return memberKey.encrypt(secret);
+}
+
+Name
+getNodeKeyName(const Name& nacIdentity, const detail::KeyTree::Node& node)
+{
+  return Name(nacIdentity).append(NODE).appendNumber(node.id).appendVersion(node.version);
+}
+
+} // namespace
+
+AccessManager::Metrics::Metrics()
+  : nMembersAdded(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nMembersAdded"))
+  , nMembersRemoved(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nMembersRemoved"))
+  , nKekServed(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nKekServed"))
+  , nKdkServed(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nKdkServed"))
+  , nNotFound(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nNotFound"))
+  , nNodeKeysPublished(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nNodeKeysPublished"))
+  , nNacKeyRotations(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nNacKeyRotations"))
+  , nBatchSignedPackets(MetricsRegistry::getDefault().getCounter("nac.AccessManager.nBatchSignedPackets"))
+  , imsBytes(MetricsRegistry::getDefault().getGauge("nac.AccessManager.imsBytes"))
+  , nacKeySetupLatency(MetricsRegistry::getDefault().getHistogram("nac.AccessManager.nacKeySetupLatency"))
+  , addMemberLatency(MetricsRegistry::getDefault().getHistogram("nac.AccessManager.addMemberLatency"))
+  , publicKeyEncryptLatency(MetricsRegistry::getDefault().getHistogram("nac.AccessManager.publicKeyEncryptLatency"))
+  , signLatency(MetricsRegistry::getDefault().getHistogram("nac.AccessManager.signLatency"))
+{
+}
+
+AccessManager::Metrics&
+AccessManager::Metrics::get()
+{
+  static Metrics metrics;
+  return metrics;
+}
+
 AccessManager::AccessManager(const Identity& identity, const Name& dataset,
+                             KeyChain& keyChain, Face& face,
+                             const KeyParams& nacKeyParams)
+  : AccessManager(identity, getOrCreateNacKey(identity, dataset, keyChain, nacKeyParams), keyChain, face)
+{
+}
+
+AccessManager::AccessManager(const Identity& identity, const Key& nacKey,
                              KeyChain& keyChain, Face& face)
   : m_identity(identity)
+  , m_nacKey(nacKey)
   , m_keyChain(keyChain)
   , m_face(face)
+  , m_published(std::make_unique<detail::PublishedPackets>(m_ims, m_imsBytes))
+  , m_scheduler(face.getIoContext())
 {
-  // NAC Identity: <identity>/NAC/<dataset>
-  // generate NAC key
-  auto nacId = m_keyChain.createIdentity(Name(identity.getName()).append(NAC).append(dataset), RsaKeyParams());
-  m_nacKey = nacId.getDefaultKey();
-  if (m_nacKey.getKeyType() != KeyType::RSA) {
-    NDN_LOG_INFO("Cannot re-use existing KEK/KDK pair, as it is not an RSA key, regenerating");
-    m_nacKey = m_keyChain.createKey(nacId, RsaKeyParams());
+  publish(makeKek(m_identity, m_nacKey, m_keyChain));
+  registerPrefixes();
+}
+
+AccessManager::~AccessManager()
+{
+  if (m_nextNacKey) {
+    m_keyChain.deleteKey(m_keyChain.getPib().getIdentity(m_nextNacKey->getIdentity()), *m_nextNacKey);
   }
-  auto nacKeyId = m_nacKey.getName().at(-1);
+}
+
+void
+AccessManager::registerPrefixes()
+{
+  auto serve = [this] (const Name& filter, const Interest& interest) {
+    this->serve(filter, interest);
+  };
+  auto handleError = [] (const Name& prefix, const std::string& msg) {
+    NDN_LOG_ERROR("Failed to register prefix " << prefix << ": " << msg);
+  };
 
   auto kekPrefix = Name(m_nacKey.getIdentity()).append(KEK);
+  m_kekReg = m_face.setInterestFilter(kekPrefix, serve, handleError);
 
-  auto kek = std::make_shared<Data>(m_nacKey.getDefaultCertificate());
-  kek->setName(Name(kekPrefix).append(nacKeyId));
-  kek->setFreshnessPeriod(DEFAULT_KEK_FRESHNESS_PERIOD);
-  m_keyChain.sign(*kek, signingByIdentity(m_identity));
-  // kek looks like a cert, but doesn't have ValidityPeriod
-  m_ims.insert(*kek);
+  auto kdkPrefix = Name(m_nacKey.getIdentity()).append(KDK);
+  if (m_keyTree == nullptr) {
+    kdkPrefix.append(m_nacKey.getName().at(-1)); // key-id
+    m_nodeReg.unregister();
+  }
+  else {
+    // the NAC key pair is replaced whenever a member is removed
+    auto nodePrefix = Name(m_nacKey.getIdentity()).append(NODE);
+    m_nodeReg = m_face.setInterestFilter(nodePrefix, serve, handleError);
+  }
+  m_kdkReg = m_face.setInterestFilter(kdkPrefix, serve, handleError);
+}
 
-  auto serveFromIms = [this] (const Name&, const Interest& interest) {
-    auto data = m_ims.find(interest);
-    if (data != nullptr) {
-      NDN_LOG_DEBUG("Serving " << data->getName() << " from InMemoryStorage");
-      m_face.put(*data);
-    }
-    else {
-      NDN_LOG_DEBUG("Didn't find data for " << interest.getName());
-      // send NACK?
+void
+AccessManager::serve(const Name& filter, const Interest& interest)
+{
+  auto data = m_published->find(interest);
+  if (data != nullptr) {
+    NDN_LOG_TRACE("Serving " << data->getName());
+    NAC_PROBE(key_serve, detail::probeHash(interest.getName()), 1);
+    (filter.get(-1) == KEK ? m_metrics.nKekServed : m_metrics.nKdkServed).increment();
+    m_face.put(*data);
+  }
+  else {
+    NDN_LOG_TRACE("Didn't find data for " << interest.getName());
+    NAC_PROBE(key_serve, detail::probeHash(interest.getName()), 0);
+    m_metrics.nNotFound.increment();
+    if (m_isNackingUnpublished) {
+      m_face.put(detail::makeNack(interest, m_keyChain));
     }
-  };
+  }
+}
 
-  auto handleError = [] (const Name& prefix, const std::string& msg) {
-    NDN_LOG_ERROR("Failed to register prefix " << prefix << ": " << msg);
-  };
+void
+AccessManager::setKdkDistribution(KdkDistribution mode)
+{
+  if (mode == getKdkDistribution()) {
+    return;
+  }
+  if (m_nMemberKeys > 0) {
+    NDN_THROW(Error("KDK distribution cannot be changed after members have been added"));
+  }
+
+  if (mode == KdkDistribution::KeyTree) {
+    m_keyTree = std::make_unique<detail::KeyTree>();
+    m_nextNacKeyEvent = m_scheduler.schedule(0_ns, [this] { prepareNextNacKey(); });
+  }
+  else {
+    // previous NAC key pairs, if any, are still pruned once they expire
+    m_keyTree.reset();
+    m_nodeKeyNames.clear();
+  }
+  registerPrefixes();
+}
 
-  m_kekReg = m_face.setInterestFilter(kekPrefix, serveFromIms, handleError);
+Key
+AccessManager::getOrCreateNacKey(const Identity& identity, const Name& dataset, KeyChain& keyChain,
+                                 const KeyParams& nacKeyParams)
+{
+  auto startTime = time::steady_clock::now();
 
-  auto kdkPrefix = Name(m_nacKey.getIdentity()).append(KDK).append(nacKeyId);
-  m_kdkReg = m_face.setInterestFilter(kdkPrefix, serveFromIms, handleError);
+  // NAC Identity: <identity>/NAC/<dataset>
+  // generate NAC key, unless the identity already exists
+  auto nacId = keyChain.createIdentity(Name(identity.getName()).append(NAC).append(dataset), nacKeyParams);
+  auto nacKey = nacId.getDefaultKey();
+  if (nacKey.getKeyType() != nacKeyParams.getKeyType()) {
+    NDN_LOG_INFO("Cannot re-use existing KEK/KDK pair, as it is not an " << nacKeyParams.getKeyType() <<
+                 " key, regenerating");
+    nacKey = keyChain.createKey(nacId, nacKeyParams);
+  }
+  Metrics::get().nacKeySetupLatency.record(time::steady_clock::now() - startTime);
+  return nacKey;
 }
 
 Data
-AccessManager::addMember(const Certificate& memberCert)
+AccessManager::makeKek(const Identity& identity, const Key& nacKey, KeyChain& keyChain)
 {
-  Name kdkName(m_nacKey.getIdentity());
-  kdkName
-    .append(KDK)
-    .append(m_nacKey.getName().at(-1)) // key-id
-    .append(ENCRYPTED_BY)
-    .append(memberCert.getKeyName());
+  Data kek(nacKey.getDefaultCertificate());
+  kek.setName(Name(nacKey.getIdentity()).append(KEK).append(nacKey.getName().at(-1)));
+  kek.setFreshnessPeriod(DEFAULT_KEK_FRESHNESS_PERIOD);
+  auto signStartTime = time::steady_clock::now();
+  keyChain.sign(kek, signingByIdentity(identity));
+  Metrics::get().signLatency.record(time::steady_clock::now() - signStartTime);
+  // kek looks like a cert, but doesn't have ValidityPeriod
+  return kek;
+}
+
+Data
+AccessManager::makeKdk(const Identity& identity, const Key& nacKey, const Certificate& memberCert,
+                       KeyChain& keyChain)
+{
+  auto kdk = makeUnsignedKdk(nacKey, memberCert, keyChain);
+  auto signStartTime = time::steady_clock::now();
+  keyChain.sign(kdk, signingByIdentity(identity));
+  Metrics::get().signLatency.record(time::steady_clock::now() - signStartTime);
+  return kdk;
+}
 
+Data
+AccessManager::makeUnsignedKdk(const Key& nacKey, const Certificate& memberCert, KeyChain& keyChain)
+{
+  return makeUnsignedKdk(exportNacKey(nacKey, keyChain), memberCert.getKeyName(),
+                         [&] (span<const uint8_t> secret) { return encryptForMember(memberCert, secret); });
+}
+
+AccessManager::ExportedNacKey
+AccessManager::exportNacKey(const Key& nacKey, KeyChain& keyChain)
+{
   const size_t secretLength = 32;
-  uint8_t secret[secretLength + 1];
-  random::generateSecureBytes({secret, secretLength});
+  SecureBuffer secret(secretLength + 1);
+  random::generateSecureBytes({secret.data(), secretLength});
   // because of stupid bug in ndn-cxx, remove all \0 in generated secret, replace with 1
   for (size_t i = 0; i < secretLength; ++i) {
     if (secret[i] == 0) {
@@ -96,31 +271,438 @@ AccessManager::addMember(const Certificate& memberCert)
   }
   secret[secretLength] = 0;
 
-  auto kdkData = m_keyChain.exportSafeBag(m_nacKey.getDefaultCertificate(),
-                                          reinterpret_cast<const char*>(secret), secretLength);
+  ExportedNacKey exported;
+  exported.key = nacKey;
+  exported.safeBag = keyChain.exportSafeBag(nacKey.getDefaultCertificate(),
+                                            reinterpret_cast<const char*>(secret.data()), secretLength)
+                       ->wireEncode();
+  secret.shrink(secretLength);
+  exported.password = std::move(secret);
+  return exported;
+}
 
-  PublicKey memberKey;
-  memberKey.loadPkcs8(memberCert.getPublicKey());
+Data
+AccessManager::makeUnsignedKdk(const ExportedNacKey& nacKey, const Name& recipientKeyName,
+                               const std::function<ConstBufferPtr(span<const uint8_t>)>& encryptSecret)
+{
+  Name kdkName(nacKey.key.getIdentity());
+  kdkName
+    .append(KDK)
+    .append(nacKey.key.getName().at(-1)) // key-id
+    .append(ENCRYPTED_BY)
+    .append(recipientKeyName);
 
   EncryptedContent content;
-  content.setPayload(kdkData->wireEncode());
-  content.setPayloadKey(memberKey.encrypt({secret, secretLength}));
+  content.setPayload(nacKey.safeBag);
+  auto encryptStartTime = time::steady_clock::now();
+  content.setPayloadKey(encryptSecret({nacKey.password.data(), nacKey.password.size()}));
+  Metrics::get().publicKeyEncryptLatency.record(time::steady_clock::now() - encryptStartTime);
 
-  auto kdk = std::make_shared<Data>(kdkName);
-  kdk->setContent(content.wireEncode());
+  Data kdk(kdkName);
+  kdk.setContent(content.wireEncode());
   // FreshnessPeriod can serve as a soft access control for revoking access
-  kdk->setFreshnessPeriod(DEFAULT_KDK_FRESHNESS_PERIOD);
-  m_keyChain.sign(*kdk, signingByIdentity(m_identity));
+  kdk.setFreshnessPeriod(DEFAULT_KDK_FRESHNESS_PERIOD);
+  return kdk;
+}
+
+void
+AccessManager::sign(Data& data)
+{
+  auto signStartTime = time::steady_clock::now();
+  m_keyChain.sign(data, signingByIdentity(m_identity));
+  m_metrics.signLatency.record(time::steady_clock::now() - signStartTime);
+}
+
+void
+AccessManager::sign(const std::vector<Data*>& packets)
+{
+  if (!m_isBatchSigning) {
+    for (auto* data : packets) {
+      sign(*data);
+    }
+    return;
+  }
 
-  m_ims.insert(*kdk);
+  auto signStartTime = time::steady_clock::now();
+  detail::signBatch(packets, m_keyChain, signingByIdentity(m_identity));
+  m_metrics.signLatency.record(time::steady_clock::now() - signStartTime);
+  if (packets.size() > 1) {
+    m_metrics.nBatchSignedPackets.increment(packets.size());
+  }
+}
+
+void
+AccessManager::publish(const Data& data)
+{
+  m_published->publish(data);
+}
 
-  return *kdk;
+void
+AccessManager::unpublish(const Name& name)
+{
+  m_published->unpublish(name);
 }
 
 void
+AccessManager::exportBundle(std::ostream& os) const
+{
+  KdkServer::writeBundle(std::vector<Data>(m_ims.begin(), m_ims.end()), os);
+}
+
+Data
+AccessManager::addMember(const Certificate& memberCert)
+{
+  auto startTime = time::steady_clock::now();
+  NAC_PROBE(add_member_start, detail::probeHash(memberCert.getKeyName()));
+
+  auto identity = memberCert.getIdentity();
+  const MemberKdk* existing = nullptr;
+  auto member = m_members.find(identity);
+  if (member != m_members.end()) {
+    auto memberKey = member->second.find(memberCert.getKeyName());
+    if (memberKey != member->second.end()) {
+      existing = &memberKey->second;
+    }
+  }
+
+  Data kdk;
+  size_t leafSlot = 0;
+  if (m_keyTree == nullptr) {
+    kdk = makeKdk(m_identity, m_nacKey, memberCert, m_keyChain);
+  }
+  else {
+    // a member key that is added again keeps its leaf
+    detail::KeyTreeChanges changes;
+    const auto& leaf = existing != nullptr ? m_keyTree->getLeaf(existing->leafSlot) : m_keyTree->addLeaf(changes);
+    leafSlot = leaf.slot;
+    try {
+      auto encryptStartTime = time::steady_clock::now();
+      EncryptedContent content;
+      content.setPayload(encryptForMember(memberCert, leaf.key));
+      m_metrics.publicKeyEncryptLatency.record(time::steady_clock::now() - encryptStartTime);
+
+      kdk.setName(Name(m_nacKey.getIdentity()).append(NODE).append(ENCRYPTED_BY)
+                  .append(memberCert.getKeyName()).appendNumber(leaf.id).appendVersion(leaf.version));
+      kdk.setContent(content.wireEncode());
+      kdk.setFreshnessPeriod(DEFAULT_KDK_FRESHNESS_PERIOD);
+      sign(kdk);
+    }
+    catch (const std::exception&) {
+      if (existing == nullptr) {
+        m_keyTree->removeLeaf(leafSlot, changes);
+      }
+      publishKeyTreeChanges(changes);
+      throw;
+    }
+    publishKeyTreeChanges(changes);
+  }
+
+  publishMemberKdk(memberCert, kdk, leafSlot);
+  m_metrics.addMemberLatency.record(time::steady_clock::now() - startTime);
+  NAC_PROBE(add_member_done, detail::probeHash(memberCert.getKeyName()), kdk.wireEncode().size());
+  return kdk;
+}
+
+std::vector<Data>
+AccessManager::addMembers(const std::vector<Certificate>& memberCerts)
+{
+  std::vector<Data> kdks;
+  kdks.reserve(memberCerts.size());
+  if (m_keyTree != nullptr || !m_isBatchSigning) {
+    for (const auto& memberCert : memberCerts) {
+      kdks.push_back(addMember(memberCert));
+    }
+    return kdks;
+  }
+
+  auto startTime = time::steady_clock::now();
+  std::vector<Data*> packets;
+  packets.reserve(memberCerts.size());
+  for (const auto& memberCert : memberCerts) {
+    NAC_PROBE(add_member_start, detail::probeHash(memberCert.getKeyName()));
+    packets.push_back(&kdks.emplace_back(makeUnsignedKdk(m_nacKey, memberCert, m_keyChain)));
+  }
+  sign(packets);
+
+  // the latency of each member is the amortized cost of the whole batch
+  auto latency = (time::steady_clock::now() - startTime) / std::max<int64_t>(memberCerts.size(), 1);
+  for (size_t i = 0; i < memberCerts.size(); ++i) {
+    publishMemberKdk(memberCerts[i], kdks[i], 0);
+    m_metrics.addMemberLatency.record(latency);
+    NAC_PROBE(add_member_done, detail::probeHash(memberCerts[i].getKeyName()), kdks[i].wireEncode().size());
+  }
+  return kdks;
+}
+
+void
+AccessManager::publishMemberKdk(const Certificate& memberCert, const Data& kdk, size_t leafSlot)
+{
+  auto& memberKdk = m_members[memberCert.getIdentity()][memberCert.getKeyName()];
+  if (!memberKdk.kdkName.empty()) {
+    NDN_LOG_DEBUG("Replacing KDK " << memberKdk.kdkName);
+    unpublish(memberKdk.kdkName);
+  }
+  else {
+    ++m_nMemberKeys;
+  }
+  memberKdk = {kdk.getName(), leafSlot};
+  publish(kdk);
+  m_metrics.nMembersAdded.increment();
+}
+
+void
+AccessManager::removeMemberKdk(const MemberKdk& kdk, detail::KeyTreeChanges& changes)
+{
+  NDN_LOG_DEBUG("Removing KDK " << kdk.kdkName);
+  unpublish(kdk.kdkName);
+  if (m_keyTree != nullptr) {
+    m_keyTree->removeLeaf(kdk.leafSlot, changes);
+  }
+}
+
+size_t
 AccessManager::removeMember(const Name& identity)
 {
-  m_ims.erase(Name(m_nacKey.getName()).append(KDK).append(ENCRYPTED_BY).append(identity));
+  auto member = m_members.find(identity);
+  if (member == m_members.end()) {
+    NDN_LOG_DEBUG("Identity " << identity << " is not a member");
+    return 0;
+  }
+
+  size_t nKeys = member->second.size();
+  detail::KeyTreeChanges changes;
+  for (const auto& [keyName, kdk] : member->second) {
+    removeMemberKdk(kdk, changes);
+  }
+  m_members.erase(member);
+  m_nMemberKeys -= nKeys;
+  m_metrics.nMembersRemoved.increment(nKeys);
+  finishKeyTreeRemoval(changes);
+  return nKeys;
+}
+
+bool
+AccessManager::removeMemberKey(const Name& memberKeyName)
+{
+  if (!security::isValidKeyName(memberKeyName)) {
+    return false;
+  }
+  auto member = m_members.find(security::extractIdentityFromKeyName(memberKeyName));
+  if (member == m_members.end()) {
+    return false;
+  }
+  auto memberKey = member->second.find(memberKeyName);
+  if (memberKey == member->second.end()) {
+    return false;
+  }
+
+  detail::KeyTreeChanges changes;
+  removeMemberKdk(memberKey->second, changes);
+  member->second.erase(memberKey);
+  if (member->second.empty()) {
+    m_members.erase(member);
+  }
+  --m_nMemberKeys;
+  m_metrics.nMembersRemoved.increment();
+  finishKeyTreeRemoval(changes);
+  return true;
+}
+
+void
+AccessManager::finishKeyTreeRemoval(const detail::KeyTreeChanges& changes)
+{
+  if (m_keyTree == nullptr) {
+    return;
+  }
+  // the removed members know the current NAC private key
+  rotateNacKey();
+  publishKeyTreeChanges(changes);
+}
+
+void
+AccessManager::publishKeyTreeChanges(const detail::KeyTreeChanges& changes)
+{
+  const Name& nacIdentity = m_nacKey.getIdentity();
+
+  auto unpublishNodeKey = [this] (uint64_t id) {
+    auto it = m_nodeKeyNames.find(id);
+    if (it != m_nodeKeyNames.end()) {
+      unpublish(it->second);
+      m_nodeKeyNames.erase(it);
+    }
+  };
+
+  for (auto id : changes.removed) {
+    unpublishNodeKey(id);
+  }
+
+  // all packets are created first, so that they can be signed as one batch
+  std::vector<std::pair<uint64_t, Data>> nodeKeys;
+  for (auto id : changes.wrapping) {
+    const auto* node = m_keyTree->findNode(id);
+    if (node == nullptr || node->parent == nullptr) {
+      continue;
+    }
+    unpublishNodeKey(id);
+
+    const auto& parent = *node->parent;
+    EncryptedContent content;
+    content.setPayload(detail::aesWrapKey(node->key, parent.key));
+
+    Data data(Name(nacIdentity).append(NODE).append(ENCRYPTED_BY).append(getNodeKeyName(nacIdentity, *node))
+              .appendNumber(parent.id).appendVersion(parent.version));
+    data.setContent(content.wireEncode());
+    data.setFreshnessPeriod(DEFAULT_KDK_FRESHNESS_PERIOD);
+    nodeKeys.emplace_back(id, std::move(data));
+  }
+
+  // the KDK is wrapped with the root key and needs to be replaced whenever the root or the
+  // NAC key pair changes; so are the KDKs of the previous NAC key pairs, whose SafeBags are
+  // exported only once, so that only their passwords are wrapped again
+  std::vector<Data> kdks;
+  const auto* root = m_keyTree->getRoot();
+  Name rootKeyName = root == nullptr ? Name() : getNodeKeyName(nacIdentity, *root);
+  Name kdkName = Name(nacIdentity).append(KDK).append(m_nacKey.getName().at(-1))
+                   .append(ENCRYPTED_BY).append(rootKeyName);
+  if (root == nullptr || m_treeNacKeys.empty() || m_treeNacKeys.back().kdkName != kdkName) {
+    for (auto& nacKey : m_treeNacKeys) {
+      if (!nacKey.kdkName.empty()) {
+        unpublish(nacKey.kdkName);
+        nacKey.kdkName.clear();
+      }
+    }
+    if (root != nullptr) {
+      getExportedNacKey();
+      auto wrap = [root] (span<const uint8_t> secret) { return detail::aesWrapKey(root->key, secret); };
+      for (const auto& nacKey : m_treeNacKeys) {
+        kdks.push_back(makeUnsignedKdk(nacKey, rootKeyName, wrap));
+      }
+    }
+  }
+
+  std::vector<Data*> packets;
+  for (auto& [id, data] : nodeKeys) {
+    packets.push_back(&data);
+  }
+  for (auto& kdk : kdks) {
+    packets.push_back(&kdk);
+  }
+  sign(packets);
+
+  for (const auto& [id, data] : nodeKeys) {
+    publish(data);
+    m_nodeKeyNames[id] = data.getName();
+    m_metrics.nNodeKeysPublished.increment();
+  }
+  // the KDK of the current NAC key pair comes last
+  for (size_t i = 0; i < kdks.size(); ++i) {
+    publish(kdks[i]);
+    m_treeNacKeys[i].kdkName = kdks[i].getName();
+  }
+}
+
+void
+AccessManager::rotateNacKey()
+{
+  if (!m_nextNacKey) {
+    m_nextNacKeyEvent.cancel();
+    prepareNextNacKey();
+  }
+  auto nacIdentity = m_keyChain.getPib().getIdentity(m_nacKey.getIdentity());
+  auto nacKey = *m_nextNacKey;
+  m_nextNacKey.reset();
+  m_keyChain.setDefaultKey(nacIdentity, nacKey);
+  NDN_LOG_INFO("Replacing NAC key " << m_nacKey.getName() << " with " << nacKey.getName());
+
+  // producers must not pick up the previous KEK anymore, but the previous private key is still
+  // needed for CKs encrypted with it (see publishKeyTreeChanges())
+  unpublish(Name(nacIdentity.getName()).append(KEK).append(m_nacKey.getName().at(-1)));
+  auto now = time::steady_clock::now();
+  getExportedNacKey().expiry = now + PREVIOUS_NAC_KEY_LIFETIME;
+  m_nacKey = nacKey;
+  publish(makeKek(m_identity, m_nacKey, m_keyChain));
+  m_metrics.nNacKeyRotations.increment();
+
+  // all key pairs in m_treeNacKeys are previous ones now, the oldest of which expires first
+  m_pruneEvent = m_scheduler.schedule(m_treeNacKeys.front().expiry - now, [this] { prunePreviousNacKeys(); });
+  m_nextNacKeyEvent = m_scheduler.schedule(0_ns, [this] { prepareNextNacKey(); });
+}
+
+void
+AccessManager::prepareNextNacKey()
+{
+  auto nacIdentity = m_keyChain.getPib().getIdentity(m_nacKey.getIdentity());
+  m_nextNacKey = m_keyChain.createKey(nacIdentity, *makeKeyParams(m_nacKey));
+  // the prepared key pair becomes the default one only when it replaces m_nacKey
+  m_keyChain.setDefaultKey(nacIdentity, m_nacKey);
+}
+
+void
+AccessManager::prunePreviousNacKeys()
+{
+  auto now = time::steady_clock::now();
+  while (!m_treeNacKeys.empty() && m_treeNacKeys.front().expiry <= now) {
+    const auto& nacKey = m_treeNacKeys.front();
+    NDN_LOG_INFO("Deleting NAC key " << nacKey.key.getName() << ", as no CK can be encrypted with it anymore");
+    if (!nacKey.kdkName.empty()) {
+      unpublish(nacKey.kdkName);
+    }
+    m_keyChain.deleteKey(m_keyChain.getPib().getIdentity(nacKey.key.getIdentity()), nacKey.key);
+    m_treeNacKeys.pop_front();
+  }
+
+  // only the current NAC key pair, if any, does not expire
+  if (!m_treeNacKeys.empty() && m_treeNacKeys.front().expiry != time::steady_clock::time_point::max()) {
+    m_pruneEvent = m_scheduler.schedule(m_treeNacKeys.front().expiry - now, [this] { prunePreviousNacKeys(); });
+  }
+}
+
+AccessManager::ExportedNacKey&
+AccessManager::getExportedNacKey()
+{
+  if (m_treeNacKeys.empty() || m_treeNacKeys.back().key.getName() != m_nacKey.getName()) {
+    m_treeNacKeys.push_back(exportNacKey(m_nacKey, m_keyChain));
+  }
+  return m_treeNacKeys.back();
+}
+
+const Name*
+AccessManager::findKdk(const Name& memberKeyName) const
+{
+  if (!security::isValidKeyName(memberKeyName)) {
+    return nullptr;
+  }
+  auto member = m_members.find(security::extractIdentityFromKeyName(memberKeyName));
+  if (member == m_members.end()) {
+    return nullptr;
+  }
+  auto memberKey = member->second.find(memberKeyName);
+  return memberKey == member->second.end() ? nullptr : &memberKey->second.kdkName;
+}
+
+std::vector<Name>
+AccessManager::getMembers() const
+{
+  std::vector<Name> members;
+  members.reserve(m_members.size());
+  for (const auto& [identity, keys] : m_members) {
+    members.push_back(identity);
+  }
+  return members;
+}
+
+std::vector<Name>
+AccessManager::getMemberKeys(const Name& identity) const
+{
+  std::vector<Name> keyNames;
+  auto member = m_members.find(identity);
+  if (member != m_members.end()) {
+    keyNames.reserve(member->second.size());
+    for (const auto& [keyName, kdk] : member->second) {
+      keyNames.push_back(keyName);
+    }
+  }
+  return keyNames;
 }
 
 } // namespace ndn::nac
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -21,11 +21,23 @@
 #define NDN_NAC_ACCESS_MANAGER_HPP
 
 #include "common.hpp"
+#include "metrics.hpp"
+#include "secure-memory.hpp"
 
 #include <ndn-cxx/face.hpp>
 
+#include <deque>
+#include <map>
+#include <optional>
+
 namespace ndn::nac {
 
+namespace detail {
+class KeyTree;
+struct KeyTreeChanges;
+class PublishedPackets;
+} // namespace detail
+
 /**
  * @brief Access Manager
  *
@@ -50,6 +62,11 @@ public:
    * @param dataset Name of dataset that this manager is controlling
    * @param keyChain KeyChain
    * @param face Face that will be used to publish KEK and KDKs
+   * @param nacKeyParams Type of the KEK/KDK key pair.  With RsaKeyParams (the default), CKs
+   *                     are encrypted using RSA-OAEP; with EcKeyParams, using the hybrid
+   *                     ECDH-based scheme described in the NAC specification, which makes
+   *                     key generation and CK decryption considerably cheaper.  An existing
+   *                     key pair of a different type is not re-used.
    *
    * KEK and KDK naming:
    *
@@ -63,18 +80,112 @@ public:
    *
    * AccessManager serves NAC public key for data producers to fetch and encrypted versions of
    * private keys (as safe bags) for authorized consumers to fetch.
+   *
+   * The NAC key pair is obtained with getOrCreateNacKey(), i.e., it is generated (synchronously)
+   * only when the KeyChain does not have one yet.
    */
   AccessManager(const Identity& identity, const Name& dataset,
+                KeyChain& keyChain, Face& face,
+                const KeyParams& nacKeyParams = RsaKeyParams());
+
+  /**
+   * @brief Create AccessManager for an existing NAC key pair, without any key generation
+   *
+   * @param identity Data owner's namespace identity (will be used to sign KEK and KDK)
+   * @param nacKey KEK/KDK key pair `[identity]/NAC/[dataset]/KEY/[key-id]`, e.g., generated
+   *               in advance with getOrCreateNacKey()
+   * @param keyChain KeyChain
+   * @param face Face that will be used to publish KEK and KDKs
+   */
+  AccessManager(const Identity& identity, const Key& nacKey,
                 KeyChain& keyChain, Face& face);
 
+  ~AccessManager();
+
+  /**
+   * @brief Select how the KDK is distributed to members
+   *
+   * With KdkDistribution::KeyTree, members are placed in a logical key hierarchy:
+   *
+   *     [nac-identity]/NODE/ENCRYPTED-BY/[user]/KEY/[key-id]/[node-id]/[version]
+   *         (== leaf node key, encrypted with the member key)
+   *
+   *     [nac-identity]/NODE/ENCRYPTED-BY/[nac-identity]/NODE/[node-id]/[version]/[parent-id]/[version]
+   *         (== parent node key, wrapped with the node key)
+   *
+   *     [nac-identity]/KDK/[key-id]/ENCRYPTED-BY/[nac-identity]/NODE/[root-id]/[version]
+   *         (== KDK, encrypted private key whose password is wrapped with the root node key)
+   *
+   * Every key wraps exactly one other key, so a member walks up from its key to the root
+   * with Interests for `[nac-identity]/NODE/ENCRYPTED-BY/[key-name]` that can be prefixes.
+   *
+   * @throw Error members have already been added
+   */
+  void
+  setKdkDistribution(KdkDistribution mode);
+
+  KdkDistribution
+  getKdkDistribution() const
+  {
+    return m_keyTree == nullptr ? KdkDistribution::Direct : KdkDistribution::KeyTree;
+  }
+
+  /**
+   * @brief Enable or disable batch signing (disabled by default)
+   *
+   * With batch signing, the packets published together, i.e., the KDKs of addMembers() and
+   * the node keys and KDK published after a change of the key tree, are signed with a single
+   * signature over the root of a Merkle tree of the packets, and each packet carries its
+   * inclusion proof instead of its own signature (see detail::signBatch()).  Decryptor
+   * validates such packets transparently.  Packets that are published alone, such as the KEK,
+   * are always signed individually.
+   */
+  void
+  setBatchSigning(bool isEnabled)
+  {
+    m_isBatchSigning = isEnabled;
+  }
+
+  /**
+   * @brief Enable or disable application-level NACKs (disabled by default)
+   *
+   * If enabled, Interests for KEK, KDK, or node keys that are not published are answered with
+   * an application-level NACK (see detail::makeNack()), so that consumers need not wait for
+   * them to time out.  A NACK can be cached by the network, and then answers Interests without
+   * MustBeFresh even after the packet is published, so enable this only if this AccessManager
+   * is the only producer under its prefixes and its consumers set MustBeFresh, as Decryptor does.
+   */
+  void
+  setNackUnpublished(bool isEnabled)
+  {
+    m_isNackingUnpublished = isEnabled;
+  }
+
   /**
    * @brief Authorize a member identified by its certificate @p memberCert to decrypt data
    *        under the policy
-   * @return published KDK
+   *
+   * The KDK password (or, with KdkDistribution::KeyTree, the leaf node key of the member) is
+   * encrypted using RSA-OAEP if the member key is an RSA key, or using the hybrid ECDH-based
+   * scheme if it is an EC key.  If the member key was already added, the new
+   * packet replaces the previous one.
+   *
+   * @return published KDK, or the packet with the leaf node key of the member
    */
   Data
   addMember(const Certificate& memberCert);
 
+  /**
+   * @brief Authorize several members at once, as with addMember() for each of @p memberCerts
+   *
+   * With batch signing (see setBatchSigning()) and KdkDistribution::Direct, all KDKs are
+   * signed as one batch, i.e., with a single signature.
+   *
+   * @return published KDKs (or packets with leaf node keys), in the order of @p memberCerts
+   */
+  std::vector<Data>
+  addMembers(const std::vector<Certificate>& memberCerts);
+
   // void
   // addMemberWithKey(const Name& keyName);
 
@@ -82,11 +193,106 @@ public:
   // addMemberWithIdentity(const Name& identityName);
 
   /**
-   * @brief Remove member with name @p identity from the group
+   * @brief Remove member with name @p identity from the group, i.e., the KDKs of all its keys
+   *
+   * With KdkDistribution::KeyTree, the node keys known to the removed member are replaced,
+   * and a new NAC key pair is generated, whose KEK Encryptors retrieve once their KEK is no
+   * longer fresh.  The previous NAC key pairs are kept in the KeyChain, and their KDKs are
+   * published wrapped by the new root key, so that the remaining members can still decrypt CKs
+   * encrypted before the removal or by Encryptors that have not yet moved to the new KEK.
+   *
+   * @return number of removed member keys
    */
-  void
+  size_t
   removeMember(const Name& identity);
 
+  /**
+   * @brief Remove the KDK of a single member key @p memberKeyName
+   *
+   * With KdkDistribution::KeyTree, this replaces keys in the same way as removeMember().
+   *
+   * @return whether the key was a member
+   */
+  bool
+  removeMemberKey(const Name& memberKeyName);
+
+public: // membership queries, answered from the member index without scanning the storage
+  /**
+   * @brief Check whether any key of @p identity is a member
+   */
+  bool
+  hasMember(const Name& identity) const
+  {
+    return m_members.count(identity) > 0;
+  }
+
+  /**
+   * @brief Get the name of the KDK published for @p memberKeyName
+   * @return KDK name, or nullptr if the key is not a member
+   */
+  const Name*
+  findKdk(const Name& memberKeyName) const;
+
+  /**
+   * @brief Get the names of all member identities, in canonical order
+   */
+  std::vector<Name>
+  getMembers() const;
+
+  /**
+   * @brief Get the names of all member keys of @p identity, in canonical order
+   */
+  std::vector<Name>
+  getMemberKeys(const Name& identity) const;
+
+  /**
+   * @brief Get the number of member identities
+   */
+  size_t
+  getNMembers() const
+  {
+    return m_members.size();
+  }
+
+  /**
+   * @brief Get the number of member keys, i.e., published KDKs or leaf node keys
+   */
+  size_t
+  getNMemberKeys() const
+  {
+    return m_nMemberKeys;
+  }
+
+public: // stateless operations, e.g., for command-line tools
+  /**
+   * @brief Get the NAC key pair of @p dataset from @p keyChain, generating it if necessary
+   *
+   * A new key pair is generated if `[identity]/NAC/[dataset]` identity does not exist or its
+   * default key is not of the type requested by @p nacKeyParams.
+   */
+  static Key
+  getOrCreateNacKey(const Identity& identity, const Name& dataset, KeyChain& keyChain,
+                    const KeyParams& nacKeyParams = RsaKeyParams());
+
+  /**
+   * @brief Create KEK for @p nacKey, signed by @p identity
+   *
+   * Does not require an AccessManager instance, i.e., neither registers prefixes nor stores
+   * the packet.
+   */
+  static Data
+  makeKek(const Identity& identity, const Key& nacKey, KeyChain& keyChain);
+
+  /**
+   * @brief Create KDK of @p nacKey for the member @p memberCert, signed by @p identity
+   *
+   * Does not require an AccessManager instance, i.e., neither registers prefixes nor stores
+   * the packet.
+   */
+  static Data
+  makeKdk(const Identity& identity, const Key& nacKey, const Certificate& memberCert,
+          KeyChain& keyChain);
+
 public: // accessor interface for published data packets
 
   /** @return{ number of packets stored in in-memory storage }
@@ -119,6 +325,165 @@ public: // accessor interface for published data packets
     return m_ims.end();
   }
 
+  /**
+   * @brief Write all published packets, i.e., the KEK and the KDKs (and node keys), into a
+   *        bundle that KdkServer can serve on another host
+   *
+   * This allows the data owner's keys to stay on an offline host, see KdkServer::writeBundle().
+   */
+  void
+  exportBundle(std::ostream& os) const;
+
+private:
+  void
+  registerPrefixes();
+
+  /**
+   * @brief Answer @p interest from the serving index, or with an application-level NACK
+   */
+  void
+  serve(const Name& filter, const Interest& interest);
+
+  void
+  publish(const Data& data);
+
+  /**
+   * @brief Erase the packet with name @p name from the storage
+   */
+  void
+  unpublish(const Name& name);
+
+  struct MemberKdk
+  {
+    Name kdkName; // KDK, or leaf node key with KdkDistribution::KeyTree
+    size_t leafSlot = 0; // only with KdkDistribution::KeyTree
+  };
+
+  // member identity => member key name => KDK
+  using MemberIndex = std::map<Name, std::map<Name, MemberKdk>>;
+
+  /**
+   * @brief Remove the KDK of one member key, collecting the changes to the key tree
+   */
+  void
+  removeMemberKdk(const MemberKdk& kdk, detail::KeyTreeChanges& changes);
+
+  /**
+   * @brief After members have been removed from the key tree, replace the NAC key pair and
+   *        publish the new node keys and KDK
+   */
+  void
+  finishKeyTreeRemoval(const detail::KeyTreeChanges& changes);
+
+  /**
+   * @brief Publish the node keys affected by @p changes and, if needed, a new KDK for the root
+   */
+  void
+  publishKeyTreeChanges(const detail::KeyTreeChanges& changes);
+
+  /**
+   * @brief Replace the NAC key pair by the one prepared in advance, or a new one of the same
+   *        type and size, and publish its KEK
+   *
+   * The previous key pair is kept in the KeyChain and in m_treeNacKeys until no CK can be
+   * encrypted with it anymore (see prunePreviousNacKeys()).
+   */
+  void
+  rotateNacKey();
+
+  /**
+   * @brief Generate the key pair for the next rotateNacKey(), so that removing a member does
+   *        not wait for a key pair to be generated
+   */
+  void
+  prepareNextNacKey();
+
+  /**
+   * @brief Withdraw the KDKs of the previous NAC key pairs that have expired, and delete the
+   *        key pairs from the KeyChain
+   */
+  void
+  prunePreviousNacKeys();
+
+  struct ExportedNacKey
+  {
+    Key key;
+    Block safeBag; // encrypted with password
+    SecureBuffer password;
+    Name kdkName; // published KDK wrapped by the root key, only with KdkDistribution::KeyTree
+    time::steady_clock::time_point expiry = time::steady_clock::time_point::max(); // once replaced
+  };
+
+  /**
+   * @brief Get the current NAC key pair in m_treeNacKeys, exporting it if needed
+   */
+  ExportedNacKey&
+  getExportedNacKey();
+
+  /**
+   * @brief Add (or replace) the KDK of @p memberCert to the member index and publish it
+   */
+  void
+  publishMemberKdk(const Certificate& memberCert, const Data& kdk, size_t leafSlot);
+
+  /**
+   * @brief Sign @p data with the identity of the data owner
+   */
+  void
+  sign(Data& data);
+
+  /**
+   * @brief Sign @p packets with the identity of the data owner, as one batch if batch signing
+   *        is enabled
+   */
+  void
+  sign(const std::vector<Data*>& packets);
+
+  static Data
+  makeUnsignedKdk(const Key& nacKey, const Certificate& memberCert, KeyChain& keyChain);
+
+  /**
+   * @brief Export @p nacKey into a SafeBag, encrypted with a new random password
+   */
+  static ExportedNacKey
+  exportNacKey(const Key& nacKey, KeyChain& keyChain);
+
+  /**
+   * @brief Create unsigned KDK of @p nacKey whose password is encrypted by @p encryptSecret,
+   *        for the holder of @p recipientKeyName
+   */
+  static Data
+  makeUnsignedKdk(const ExportedNacKey& nacKey, const Name& recipientKeyName,
+                  const std::function<ConstBufferPtr(span<const uint8_t>)>& encryptSecret);
+
+  /**
+   * @brief Operational metrics, reported into MetricsRegistry::getDefault() under `nac.AccessManager.`
+   */
+  struct Metrics
+  {
+    Metrics();
+
+    /**
+     * @brief Get the instance shared by all AccessManagers and the static operations
+     */
+    static Metrics&
+    get();
+
+    Counter& nMembersAdded;
+    Counter& nMembersRemoved;
+    Counter& nKekServed;
+    Counter& nKdkServed;
+    Counter& nNotFound;
+    Counter& nNodeKeysPublished;
+    Counter& nNacKeyRotations;
+    Counter& nBatchSignedPackets;
+    Gauge& imsBytes;
+    LatencyHistogram& nacKeySetupLatency;
+    LatencyHistogram& addMemberLatency;
+    LatencyHistogram& publicKeyEncryptLatency;
+    LatencyHistogram& signLatency;
+  };
+
 private:
   Identity m_identity;
   Key m_nacKey;
@@ -126,8 +491,28 @@ private:
   Face& m_face;
 
   InMemoryStoragePersistent m_ims; // for KEK and KDKs
+  std::unique_ptr<detail::PublishedPackets> m_published; // serves the packets in m_ims
   ScopedRegisteredPrefixHandle m_kekReg;
   ScopedRegisteredPrefixHandle m_kdkReg;
+
+  MemberIndex m_members;
+  size_t m_nMemberKeys = 0;
+  bool m_isBatchSigning = false;
+  bool m_isNackingUnpublished = false;
+
+  // only with KdkDistribution::KeyTree
+  std::unique_ptr<detail::KeyTree> m_keyTree;
+  std::map<uint64_t, Name> m_nodeKeyNames; // node ID => published packet with its parent's key
+  // replaced NAC key pairs, oldest first, then m_nacKey once it has been exported
+  std::deque<ExportedNacKey> m_treeNacKeys;
+  std::optional<Key> m_nextNacKey;
+  ScopedRegisteredPrefixHandle m_nodeReg;
+  Scheduler m_scheduler;
+  scheduler::ScopedEventId m_nextNacKeyEvent;
+  scheduler::ScopedEventId m_pruneEvent;
+
+  Metrics& m_metrics = Metrics::get();
+  Gauge m_imsBytes{m_metrics.imsBytes}; // contribution of this instance
 };
 
 } // namespace ndn::nac
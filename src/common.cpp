@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -19,8 +19,98 @@
 
 #include "common.hpp"
 
+#include <ndn-cxx/util/random.hpp>
+
+#include <random>
+
 namespace ndn::nac {
 
+namespace {
+
+class NacErrorCategory : public boost::system::error_category
+{
+public:
+  const char*
+  name() const noexcept final
+  {
+    return "ndn-nac";
+  }
+
+  std::string
+  message(int code) const final
+  {
+    switch (static_cast<ErrorCode>(code)) {
+      case ErrorCode::KekRetrievalFailure:
+        return "KEK retrieval failure";
+      case ErrorCode::KekRetrievalTimeout:
+        return "KEK retrieval timeout";
+      case ErrorCode::KekInvalidName:
+        return "invalid KEK name";
+      case ErrorCode::KekValidationFailure:
+        return "KEK validation failure";
+      case ErrorCode::KdkRetrievalFailure:
+        return "KDK retrieval failure";
+      case ErrorCode::KdkRetrievalTimeout:
+        return "KDK retrieval timeout";
+      case ErrorCode::KdkInvalidName:
+        return "invalid KDK name";
+      case ErrorCode::KdkDecryptionFailure:
+        return "KDK decryption failure";
+      case ErrorCode::KdkValidationFailure:
+        return "KDK validation failure";
+      case ErrorCode::CkRetrievalFailure:
+        return "CK retrieval failure";
+      case ErrorCode::CkRetrievalTimeout:
+        return "CK retrieval timeout";
+      case ErrorCode::CkInvalidName:
+        return "invalid CK name";
+      case ErrorCode::CkDecryptionFailure:
+        return "CK decryption failure";
+      case ErrorCode::CkValidationFailure:
+        return "CK validation failure";
+      case ErrorCode::MissingRequiredKeyLocator:
+        return "missing required KeyLocator or InitializationVector";
+      case ErrorCode::TpmKeyNotFound:
+        return "key not found in TPM";
+      case ErrorCode::EncryptionFailure:
+        return "encryption failure";
+      case ErrorCode::PendingDecryptsOverflow:
+        return "too many pending decrypts";
+      case ErrorCode::MalformedEncryptedContent:
+        return "malformed EncryptedContent";
+      case ErrorCode::PayloadDecryptionFailure:
+        return "payload decryption failure";
+    }
+    return "unknown error " + std::to_string(code);
+  }
+};
+
+} // namespace
+
+const boost::system::error_category&
+getErrorCategory() noexcept
+{
+  static const NacErrorCategory category;
+  return category;
+}
+
+time::milliseconds
+RetryPolicy::getDelay(size_t nFailures) const
+{
+  auto delay = static_cast<double>(initialDelay.count());
+  auto max = static_cast<double>(maxDelay.count());
+  for (size_t i = 1; i < nFailures && multiplier > 1.0 && delay < max; ++i) {
+    delay *= multiplier;
+  }
+  delay = std::min(delay, max);
+
+  if (jitter > 0.0) {
+    std::uniform_real_distribution<double> dist(0.0, std::min(jitter, 1.0));
+    delay -= delay * dist(random::getRandomNumberEngine());
+  }
+  return time::milliseconds(static_cast<int64_t>(delay));
+}
+
 Name
 convertKekNameToKdkPrefix(const Name& kekName, const ErrorCallback& onFailure)
 {
@@ -33,6 +123,17 @@ convertKekNameToKdkPrefix(const Name& kekName, const ErrorCallback& onFailure)
   return kekName.getPrefix(-2).append(KDK).append(kekName.get(-1));
 }
 
+std::pair<Name, Name>
+splitDerivedKekName(const Name& kekName)
+{
+  for (size_t i = 0; i + 2 < kekName.size(); ++i) {
+    if (kekName.get(i) == KEK && kekName.get(i + 2) == DERIVED) {
+      return {kekName.getPrefix(i + 2), kekName.getSubName(i + 3)};
+    }
+  }
+  return {kekName, Name()};
+}
+
 std::tuple<Name, Name, Name>
 extractKdkInfoFromCkName(const Name& ckDataName, const Name& ckName, const ErrorCallback& onFailure)
 {
@@ -45,7 +146,7 @@ extractKdkInfoFromCkName(const Name& ckDataName, const Name& ckName, const Error
     return {};
   }
 
-  auto kekName = ckDataName.getSubName(ckName.size() + 1);
+  auto kekName = splitDerivedKekName(ckDataName.getSubName(ckName.size() + 1)).first;
   return {convertKekNameToKdkPrefix(kekName, onFailure),
           kekName.getPrefix(-2),
           kekName.getPrefix(-2).append("KEY").append(kekName.get(-1))};
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2023, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -51,6 +51,7 @@
 #include <ndn-cxx/security/validator.hpp>
 
 #include <boost/assert.hpp>
+#include <boost/system/error_code.hpp>
 
 namespace ndn::nac {
 
@@ -66,6 +67,10 @@ using security::Validator;
 using security::extractKeyNameFromCertName;
 using security::transform::PublicKey;
 
+namespace tests {
+class BenchmarkAccess; // lets the benchmarks measure internal stages of the library
+} // namespace tests
+
 namespace tlv {
 
 using namespace ndn::tlv;
@@ -75,8 +80,19 @@ enum {
   EncryptedPayload = 132,
   InitializationVector = 133,
   EncryptedPayloadKey = 134,
+  BatchLeafIndex = 135,
+  BatchTreeSize = 136,
+  BatchProofHash = 137,
+  KdkBundleIndex = 138,
+  KdkBundleEntry = 139,
+  KdkBundleOffset = 140,
 };
 
+/**
+ * @brief SignatureType of packets signed with detail::signBatch()
+ */
+inline constexpr uint32_t SignatureSha256MerkleBatch = 200;
+
 } // namespace tlv
 
 inline const name::Component ENCRYPTED_BY{"ENCRYPTED-BY"};
@@ -84,6 +100,9 @@ inline const name::Component NAC{"NAC"};
 inline const name::Component KEK{"KEK"};
 inline const name::Component KDK{"KDK"};
 inline const name::Component CK{"CK"};
+inline const name::Component NODE{"NODE"};
+inline const name::Component DERIVED{"DERIVED"};
+inline const name::Component BATCH{"BATCH"};
 
 inline constexpr size_t AES_KEY_SIZE = 32;
 inline constexpr size_t AES_IV_SIZE = 16;
@@ -91,6 +110,9 @@ inline constexpr size_t AES_IV_SIZE = 16;
 inline constexpr time::seconds DEFAULT_KEK_FRESHNESS_PERIOD = 1_h;
 inline constexpr time::seconds DEFAULT_KDK_FRESHNESS_PERIOD = 1_h;
 inline constexpr time::seconds DEFAULT_CK_FRESHNESS_PERIOD = 1_h;
+// application-level NACKs turn stale quickly, so that cached ones do not answer MustBeFresh
+// Interests for packets that are published later
+inline constexpr time::seconds NACK_FRESHNESS_PERIOD = 1_s;
 
 inline constexpr time::seconds RETRY_DELAY_AFTER_NACK = 1_s;
 inline constexpr time::seconds RETRY_DELAY_KEK_RETRIEVAL = 60_s;
@@ -99,29 +121,103 @@ enum class ErrorCode {
   KekRetrievalFailure = 1,
   KekRetrievalTimeout = 2,
   KekInvalidName = 3,
+  KekValidationFailure = 4,
 
   KdkRetrievalFailure = 11,
   KdkRetrievalTimeout = 12,
   KdkInvalidName = 13,
   KdkDecryptionFailure = 14,
+  KdkValidationFailure = 15,
 
   CkRetrievalFailure = 21,
   CkRetrievalTimeout = 22,
   CkInvalidName = 23,
+  CkDecryptionFailure = 24,
+  CkValidationFailure = 25,
 
   MissingRequiredKeyLocator = 101,
   TpmKeyNotFound = 102,
-  EncryptionFailure = 103
+  EncryptionFailure = 103,
+  PendingDecryptsOverflow = 104,
+  MalformedEncryptedContent = 105,
+  PayloadDecryptionFailure = 106
 };
 
 using ErrorCallback = std::function<void(const ErrorCode&, const std::string&)>;
 
+/**
+ * @brief How AccessManager distributes the KDK to members, and how Decryptor retrieves it
+ *
+ * Both sides of a dataset must use the same mode.
+ */
+enum class KdkDistribution {
+  /**
+   * @brief The KDK is encrypted separately for every member key
+   *
+   * Adding a member costs one public-key encryption.  Excluding a member requires a new NAC
+   * key pair and a new KDK for every remaining member.
+   */
+  Direct,
+  /**
+   * @brief The KDK is encrypted once, under the root of a logical key hierarchy (LKH)
+   *
+   * Every member holds the symmetric node keys on the path from its leaf to the root of a
+   * binary tree, and retrieves them one level at a time.  Removing a member replaces the node
+   * keys on its path and the NAC key pair, which costs O(log n) symmetric key wraps and
+   * packets instead of O(n) public-key encryptions.
+   */
+  KeyTree,
+};
+
+/**
+ * @brief Error category of ErrorCode, used to report errors as `boost::system::error_code`
+ *        in asynchronous operations with completion tokens
+ */
+const boost::system::error_category&
+getErrorCategory() noexcept;
+
+inline boost::system::error_code
+make_error_code(ErrorCode code) noexcept
+{
+  return {static_cast<int>(code), getErrorCategory()};
+}
+
 class Error : public std::runtime_error
 {
 public:
   using std::runtime_error::runtime_error;
 };
 
+/**
+ * @brief Delays before retrying a failed retrieval: exponential backoff with a cap and jitter
+ *
+ * The delay after `n` consecutive failures is `initialDelay * multiplier^(n-1)`, capped at
+ * `maxDelay` and then shortened by a random fraction of up to `jitter`, so that consumers
+ * that failed at the same time do not retry in lockstep.
+ */
+struct RetryPolicy
+{
+  time::milliseconds initialDelay = 1_s;
+  time::milliseconds maxDelay = 60_s;
+  double multiplier = 2.0;
+  double jitter = 0.2;
+
+  /**
+   * @brief Get the delay after @p nFailures (>= 1) consecutive failures
+   */
+  time::milliseconds
+  getDelay(size_t nFailures) const;
+
+  /**
+   * @brief Policy with the same delay after every failure
+   */
+  static RetryPolicy
+  fixed(time::milliseconds delay)
+  {
+    return {delay, delay, 1.0, 0.0};
+  }
+};
+
 /**
  * @brief Convert KEK name to KDK prefix:
  *
@@ -130,9 +226,23 @@ public:
 Name
 convertKekNameToKdkPrefix(const Name& kekName, const ErrorCallback& onFailure);
 
+/**
+ * @brief Split the name of a KEK derived for a sub-dataset:
+ *
+ * `<identity>/NAC/KEK/<key-id>/DERIVED/<sub-dataset>`  =>>  (`<identity>/NAC/KEK/<key-id>`, `<sub-dataset>`)
+ *
+ * @return pair of (name of the KEK it is derived from, sub-dataset), or (@p kekName, empty name)
+ *         if @p kekName is not derived
+ */
+std::pair<Name, Name>
+splitDerivedKekName(const Name& kekName);
+
 /**
  * @brief Extract KDK information from name of CK data packet name
  *
+ * If the CK is encrypted with a KEK derived for a sub-dataset, the information is that of
+ * the KDK it is derived from.
+ *
  * @return tuple of (KDK prefix, KDK identity, and KDK key id).  The last two identify
  *         KDK private/key pair in KeyChain
  */
@@ -141,4 +251,13 @@ extractKdkInfoFromCkName(const Name& ckDataName, const Name& ckName, const Error
 
 } // namespace ndn::nac
 
+namespace boost::system {
+
+template<>
+struct is_error_code_enum<ndn::nac::ErrorCode> : std::true_type
+{
+};
+
+} // namespace boost::system
+
 #endif // NDN_NAC_COMMON_HPP
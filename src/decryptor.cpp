@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -18,12 +18,15 @@
  */
 
 #include "decryptor.hpp"
+#include "detail/aes-cbc-cipher.hpp"
+#include "detail/ecies.hpp"
+#include "detail/probes.hpp"
+#include "detail/validation-cache.hpp"
 
-#include <ndn-cxx/security/transform/block-cipher.hpp>
-#include <ndn-cxx/security/transform/buffer-source.hpp>
-#include <ndn-cxx/security/transform/stream-sink.hpp>
+#include <ndn-cxx/security/transform/private-key.hpp>
 #include <ndn-cxx/util/exception.hpp>
 #include <ndn-cxx/util/logger.hpp>
+#include <ndn-cxx/util/random.hpp>
 
 #include <boost/lexical_cast.hpp>
 
@@ -33,20 +36,52 @@ NDN_LOG_INIT(nac.Decryptor);
 
 constexpr size_t N_RETRIES = 3;
 
+Decryptor::Metrics::Metrics()
+  : nCkFetches(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkFetches"))
+  , nCkRetries(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkRetries"))
+  , nCkNacks(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkNacks"))
+  , nCkTimeouts(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkTimeouts"))
+  , nKdkFetches(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkFetches"))
+  , nKdkRetries(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkRetries"))
+  , nKdkNacks(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkNacks"))
+  , nKdkTimeouts(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkTimeouts"))
+  , nNodeKeyFetches(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nNodeKeyFetches"))
+  , nKdkDerivations(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkDerivations"))
+  , nCkCacheHits(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkCacheHits"))
+  , nCkCacheMisses(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkCacheMisses"))
+  , nKdkCacheHits(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkCacheHits"))
+  , nKdkCacheMisses(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nKdkCacheMisses"))
+  , nPendingDecrypts(MetricsRegistry::getDefault().getGauge("nac.Decryptor.nPendingDecrypts"))
+  , nPendingDecryptOverflows(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nPendingDecryptOverflows"))
+  , nCkNegativeCacheHits(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nCkNegativeCacheHits"))
+  , nValidations(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nValidations"))
+  , nValidationCacheHits(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nValidationCacheHits"))
+  , nValidationFailures(MetricsRegistry::getDefault().getCounter("nac.Decryptor.nValidationFailures"))
+  , ckFetchLatency(MetricsRegistry::getDefault().getHistogram("nac.Decryptor.ckFetchLatency"))
+  , kdkFetchLatency(MetricsRegistry::getDefault().getHistogram("nac.Decryptor.kdkFetchLatency"))
+  , kdkUnwrapLatency(MetricsRegistry::getDefault().getHistogram("nac.Decryptor.kdkUnwrapLatency"))
+  , ckUnwrapLatency(MetricsRegistry::getDefault().getHistogram("nac.Decryptor.ckUnwrapLatency"))
+  , decryptLatency(MetricsRegistry::getDefault().getHistogram("nac.Decryptor.decryptLatency"))
+{
+}
+
 Decryptor::Decryptor(const Key& credentialsKey, Validator& validator, KeyChain& keyChain, Face& face)
   : m_credentialsKey(credentialsKey)
-  // , m_validator(validator)
   , m_face(face)
   , m_keyChain(keyChain)
   , m_internalKeyChain("pib-memory:", "tpm-memory:")
+  , m_validationCache(std::make_unique<detail::ValidationCache>(validator, m_metrics.nValidationCacheHits,
+                                                                m_metrics.nValidations))
 {
 }
 
 Decryptor::~Decryptor()
 {
   for (auto& i : m_cks) {
-    if (i.second.pendingInterest) {
-      i.second.pendingInterest->cancel();
+    if (i.second.isBeingRetrieved()) {
+      if (i.second.pendingInterest) {
+        i.second.pendingInterest->cancel();
+      }
       for (const auto& p : i.second.pendingDecrypts) {
         p.onFailure(ErrorCode::CkRetrievalFailure,
                     "Cancel pending decrypt as ContentKey is being destroyed");
@@ -60,7 +95,16 @@ Decryptor::decrypt(const Block& encryptedContent,
                    const DecryptSuccessCallback& onSuccess,
                    const ErrorCallback& onFailure)
 {
-  EncryptedContent ec(encryptedContent);
+  EncryptedContent ec;
+  try {
+    ec.wireDecode(encryptedContent);
+  }
+  catch (const tlv::Error& e) {
+    NDN_LOG_INFO("Malformed EncryptedContent block: " << e.what());
+    return onFailure(ErrorCode::MalformedEncryptedContent,
+                     std::string("Malformed EncryptedContent block: ") + e.what());
+  }
+
   if (!ec.hasKeyLocator()) {
     NDN_LOG_INFO("Missing required KeyLocator in the supplied EncryptedContent block");
     return onFailure(ErrorCode::MissingRequiredKeyLocator,
@@ -73,23 +117,260 @@ Decryptor::decrypt(const Block& encryptedContent,
                      "Missing required InitialVector in the supplied EncryptedContent block");
   }
 
+  NAC_PROBE(decrypt_start, detail::probeHash(ec.getKeyLocator()), ec.getPayload().value_size());
+
   auto [ck, isNew] = m_cks.emplace(ec.getKeyLocator(), ContentKey{});
 
   if (ck->second.isRetrieved) {
-    doDecrypt(ec, ck->second.bits, onSuccess, onFailure);
+    m_metrics.nCkCacheHits.increment();
+    decryptAndNotify(ec, *ck->second.cipher, onSuccess, onFailure);
+  }
+  else if (ck->second.nFailures > 0 && !ck->second.isBeingRetrieved() &&
+           time::steady_clock::now() < ck->second.retryAfter) {
+    NDN_LOG_DEBUG("Retrieval of CK " << ec.getKeyLocator() << " recently failed, failing decrypt");
+    m_metrics.nCkNegativeCacheHits.increment();
+    return onFailure(ck->second.lastErrorCode, ck->second.lastErrorMessage);
   }
   else {
     NDN_LOG_DEBUG("CK " << ec.getKeyLocator() << " not yet available, adding decrypt to the pending queue");
-    ck->second.pendingDecrypts.push_back({ec, onSuccess, onFailure});
+    m_metrics.nCkCacheMisses.increment();
+    if (!enqueuePendingDecrypt(ck, {encryptedContent, onSuccess, onFailure, m_nextPendingDecryptSeqNo++})) {
+      if (isNew) {
+        // nobody is waiting for this CK, do not start retrieving it
+        m_cks.erase(ck);
+      }
+      return;
+    }
+    NAC_PROBE(decrypt_queued, detail::probeHash(ec.getKeyLocator()), ck->second.pendingDecrypts.size());
+  }
+
+  // new CK, or the previous retrieval failed long enough ago
+  if (!ck->second.isRetrieved && !ck->second.isBeingRetrieved()) {
+    fetchCk(ck, N_RETRIES);
+  }
+}
+
+namespace {
+
+struct EncryptedContentView
+{
+  span<const uint8_t> keyLocator; // wire encoding of the Name
+  span<const uint8_t> iv;
+  span<const uint8_t> payload;
+};
+
+// unlike EncryptedContent::wireDecode(), does not allocate memory
+EncryptedContentView
+parseEncryptedContent(const Block& block)
+{
+  if (!block.hasWire() || block.type() != tlv::EncryptedContent) {
+    NDN_THROW(Error("Expecting EncryptedContent element"));
+  }
+
+  EncryptedContentView view;
+  auto value = block.value_bytes();
+  const uint8_t* pos = value.data();
+  const uint8_t* end = pos + value.size();
+  while (pos != end) {
+    const uint8_t* elementBegin = pos;
+    uint32_t type = 0;
+    uint64_t length = 0;
+    if (!ndn::tlv::readType(pos, end, type) || !ndn::tlv::readVarNumber(pos, end, length) ||
+        length > static_cast<uint64_t>(end - pos)) {
+      NDN_THROW(Error("Malformed EncryptedContent element"));
+    }
+    switch (type) {
+      case tlv::EncryptedPayload:
+        view.payload = {pos, static_cast<size_t>(length)};
+        break;
+      case tlv::InitializationVector:
+        view.iv = {pos, static_cast<size_t>(length)};
+        break;
+      case tlv::Name:
+        view.keyLocator = {elementBegin, static_cast<size_t>(pos + length - elementBegin)};
+        break;
+    }
+    pos += length;
   }
+  return view;
+}
+
+} // namespace
+
+std::optional<size_t>
+Decryptor::tryDecrypt(const Block& encryptedContent, span<uint8_t> plaintext)
+{
+  auto view = parseEncryptedContent(encryptedContent);
+  if (view.keyLocator.empty()) {
+    NDN_THROW(Error("Missing required KeyLocator in the supplied EncryptedContent block"));
+  }
+  if (view.iv.empty()) {
+    NDN_THROW(Error("Missing required InitialVector in the supplied EncryptedContent block"));
+  }
+
+  auto ck = findRetrievedCk(view.keyLocator);
+  if (ck == nullptr) {
+    return std::nullopt;
+  }
+
+  auto startTime = time::steady_clock::now();
+  auto size = ck->cipher->process(view.iv, view.payload, plaintext);
+  m_metrics.nCkCacheHits.increment();
+  m_metrics.decryptLatency.record(time::steady_clock::now() - startTime);
+  return size;
+}
 
-  if (isNew) {
-    fetchCk(ck, onFailure, N_RETRIES);
+ConstBufferPtr
+Decryptor::tryDecrypt(const Block& encryptedContent)
+{
+  auto plaintext = std::make_shared<Buffer>(parseEncryptedContent(encryptedContent).payload.size());
+  auto size = tryDecrypt(encryptedContent, *plaintext);
+  if (!size) {
+    return nullptr;
   }
+  plaintext->resize(*size);
+  return plaintext;
+}
+
+const Decryptor::ContentKey*
+Decryptor::findRetrievedCk(span<const uint8_t> ckNameWire)
+{
+  if (m_hotCk != m_cks.end() &&
+      std::equal(ckNameWire.begin(), ckNameWire.end(), m_hotCkNameWire.begin(), m_hotCkNameWire.end())) {
+    return &m_hotCk->second;
+  }
+
+  ContentKeys::iterator ck;
+  try {
+    ck = m_cks.find(Name(Block(ckNameWire)));
+  }
+  catch (const tlv::Error&) {
+    NDN_THROW_NESTED(Error("Malformed KeyLocator in the supplied EncryptedContent block"));
+  }
+  if (ck == m_cks.end() || !ck->second.isRetrieved) {
+    return nullptr;
+  }
+
+  m_hotCk = ck;
+  m_hotCkNameWire.assign(ckNameWire.begin(), ckNameWire.end());
+  return &ck->second;
+}
+
+Decryptor::PendingDecryptDepth
+Decryptor::getPendingDecryptDepth(const Name& ckName) const
+{
+  auto ck = m_cks.find(ckName);
+  if (ck == m_cks.end()) {
+    return {};
+  }
+  return {ck->second.pendingDecrypts.size(), ck->second.nPendingDecryptBytes};
+}
+
+static bool
+exceedsLimit(size_t current, size_t added, size_t limit)
+{
+  return current > limit || added > limit - current;
+}
+
+bool
+Decryptor::enqueuePendingDecrypt(ContentKeys::iterator ck, ContentKey::PendingDecrypt&& item)
+{
+  const auto& limits = m_pendingDecryptLimits;
+  auto& contentKey = ck->second;
+  size_t nBytes = parseEncryptedContent(item.encryptedContent).payload.size();
+
+  auto exceedsCkLimits = [&] {
+    return exceedsLimit(contentKey.pendingDecrypts.size(), 1, limits.maxEntriesPerCk) ||
+           exceedsLimit(contentKey.nPendingDecryptBytes, nBytes, limits.maxBytesPerCk);
+  };
+  auto exceedsGlobalLimits = [&] {
+    return exceedsLimit(m_pendingDecryptDepth.nEntries, 1, limits.maxEntries) ||
+           exceedsLimit(m_pendingDecryptDepth.nBytes, nBytes, limits.maxBytes);
+  };
+
+  // dropping is pointless if the new decrypt would not fit even into empty queues
+  bool canFit = limits.maxEntriesPerCk > 0 && limits.maxEntries > 0 &&
+                nBytes <= limits.maxBytesPerCk && nBytes <= limits.maxBytes;
+  if (limits.overflowPolicy == PendingDecryptLimits::OverflowPolicy::DropOldest && canFit) {
+    while (exceedsCkLimits()) {
+      dropOldestPendingDecrypt(ck);
+    }
+    while (exceedsGlobalLimits()) {
+      dropOldestPendingDecrypt(findOldestPendingDecrypt());
+    }
+  }
+
+  if (exceedsCkLimits() || exceedsGlobalLimits()) {
+    NDN_LOG_DEBUG("Too many pending decrypts, rejecting decrypt of " << ck->first);
+    m_metrics.nPendingDecryptOverflows.increment();
+    item.onFailure(ErrorCode::PendingDecryptsOverflow,
+                   "Too many decrypts waiting for retrieval of CK [" + ck->first.toUri() + "]");
+    return false;
+  }
+
+  if (contentKey.pendingDecrypts.full()) {
+    auto capacity = std::max<size_t>(contentKey.pendingDecrypts.capacity() * 2, 4);
+    contentKey.pendingDecrypts.set_capacity(std::min(capacity, limits.maxEntriesPerCk));
+  }
+
+  // keep the stale entries in m_pendingDecryptOrder proportional to the live ones
+  if (m_pendingDecryptDepth.nEntries == 0) {
+    m_pendingDecryptOrder.clear();
+  }
+  else if (m_pendingDecryptOrder.size() > 2 * m_pendingDecryptDepth.nEntries + 16) {
+    m_pendingDecryptOrder.erase(std::remove_if(m_pendingDecryptOrder.begin(), m_pendingDecryptOrder.end(),
+                                               [] (const auto& entry) { return !isPending(entry); }),
+                                m_pendingDecryptOrder.end());
+  }
+  m_pendingDecryptOrder.emplace_back(item.seqNo, ck);
+
+  contentKey.pendingDecrypts.push_back(std::move(item));
+  contentKey.nPendingDecryptBytes += nBytes;
+  m_pendingDecryptDepth.nEntries += 1;
+  m_pendingDecryptDepth.nBytes += nBytes;
+  m_metrics.nPendingDecrypts.increment();
+  return true;
+}
+
+bool
+Decryptor::isPending(const std::pair<uint64_t, ContentKeys::iterator>& entry)
+{
+  // each CK queue is ordered by seqNo and only loses entries at the front
+  const auto& queue = entry.second->second.pendingDecrypts;
+  return !queue.empty() && queue.front().seqNo <= entry.first;
+}
+
+Decryptor::ContentKeys::iterator
+Decryptor::findOldestPendingDecrypt()
+{
+  while (!isPending(m_pendingDecryptOrder.front())) {
+    m_pendingDecryptOrder.pop_front();
+  }
+  return m_pendingDecryptOrder.front().second;
 }
 
 void
-Decryptor::fetchCk(ContentKeys::iterator ck, const ErrorCallback& onFailure, size_t nTriesLeft)
+Decryptor::dropOldestPendingDecrypt(ContentKeys::iterator ck)
+{
+  auto& contentKey = ck->second;
+  BOOST_ASSERT(!contentKey.pendingDecrypts.empty());
+
+  auto item = std::move(contentKey.pendingDecrypts.front());
+  contentKey.pendingDecrypts.pop_front();
+  size_t nBytes = parseEncryptedContent(item.encryptedContent).payload.size();
+  contentKey.nPendingDecryptBytes -= nBytes;
+  m_pendingDecryptDepth.nEntries -= 1;
+  m_pendingDecryptDepth.nBytes -= nBytes;
+  m_metrics.nPendingDecrypts.decrement();
+  m_metrics.nPendingDecryptOverflows.increment();
+
+  NDN_LOG_DEBUG("Too many pending decrypts, dropping oldest decrypt of " << ck->first);
+  item.onFailure(ErrorCode::PendingDecryptsOverflow,
+                 "Dropped as too many decrypts are waiting for retrieval of CKs");
+}
+
+void
+Decryptor::fetchCk(ContentKeys::iterator ck, size_t nTriesLeft)
 {
   // full name of CK is
 
@@ -101,44 +382,67 @@ Decryptor::fetchCk(ContentKeys::iterator ck, const ErrorCallback& onFailure, siz
 
   const Name& ckName = ck->first;
   NDN_LOG_DEBUG("Fetching CK " << ckName);
+  auto onFailure = [this, ck] (const ErrorCode& code, const std::string& msg) { failCk(ck, code, msg); };
+
+  m_metrics.nCkFetches.increment();
+  NAC_PROBE(ck_fetch_start, detail::probeHash(ckName), nTriesLeft);
+  auto sendTime = time::steady_clock::now();
 
   ck->second.pendingInterest = m_face.expressInterest(Interest(ckName)
-                                                       .setMustBeFresh(false) // ?
+                                                       .setMustBeFresh(true)
                                                        .setCanBePrefix(true),
     [=] (const Interest& ckInterest, const Data& ckData) {
       ck->second.pendingInterest = std::nullopt;
-      // TODO: verify that the key is legit
-      auto [kdkPrefix, kdkIdentity, kdkKeyName] =
-        extractKdkInfoFromCkName(ckData.getName(), ckInterest.getName(), onFailure);
-      if (kdkPrefix.empty()) {
-        return; // error has been already reported
+      if (ckData.getContentType() == tlv::ContentType_Nack) {
+        m_metrics.nCkNacks.increment();
+        NAC_PROBE(ck_fetch_fail, detail::probeHash(ck->first), static_cast<int>(ErrorCode::CkRetrievalFailure));
+        return onFailure(ErrorCode::CkRetrievalFailure,
+                         "Retrieval of CK [" + ckInterest.getName().toUri() + "] failed. Got application NACK");
       }
+      m_metrics.ckFetchLatency.record(time::steady_clock::now() - sendTime);
+      NAC_PROBE(ck_fetch_done, detail::probeHash(ck->first), ckData.wireEncode().size());
+      validateKeyData(ck, ckData, ErrorCode::CkValidationFailure, onFailure, [=] {
+        auto [kdkPrefix, kdkIdentity, kdkKeyName] =
+          extractKdkInfoFromCkName(ckData.getName(), ckInterest.getName(), onFailure);
+        if (kdkPrefix.empty()) {
+          return; // error has been already reported
+        }
 
-      // check if KDK already exists (there is a corresponding
-      auto kdkIdentityIt = m_internalKeyChain.getPib().getIdentities().find(kdkIdentity);
-      if (kdkIdentityIt != m_internalKeyChain.getPib().getIdentities().end()) {
-        auto kdkKeyIt = (*kdkIdentityIt).getKeys().find(kdkKeyName);
-        if (kdkKeyIt != (*kdkIdentityIt).getKeys().end()) {
+        // check if KDK already exists (there is a corresponding
+        bool hasKdk = m_eciesKdks.count(kdkKeyName) > 0;
+        auto kdkIdentityIt = m_internalKeyChain.getPib().getIdentities().find(kdkIdentity);
+        if (!hasKdk && kdkIdentityIt != m_internalKeyChain.getPib().getIdentities().end()) {
+          auto kdkKeyIt = (*kdkIdentityIt).getKeys().find(kdkKeyName);
+          hasKdk = kdkKeyIt != (*kdkIdentityIt).getKeys().end();
+        }
+        if (hasKdk) {
           // KDK was already fetched and imported
           NDN_LOG_DEBUG("KDK " << kdkKeyName << " already exists, directly using it to decrypt CK");
+          m_metrics.nKdkCacheHits.increment();
           return decryptCkAndProcessPendingDecrypts(ck, ckData, kdkKeyName, onFailure);
         }
-      }
 
-      fetchKdk(ck, kdkPrefix, ckData, onFailure, N_RETRIES);
+        m_metrics.nKdkCacheMisses.increment();
+        fetchKdk(ck, kdkPrefix, ckData, N_RETRIES);
+      });
     },
     [=] (const Interest& i, const lp::Nack& nack) {
       ck->second.pendingInterest = std::nullopt;
+      m_metrics.nCkNacks.increment();
+      NAC_PROBE(ck_fetch_fail, detail::probeHash(ck->first), static_cast<int>(ErrorCode::CkRetrievalFailure));
       onFailure(ErrorCode::CkRetrievalFailure,
                 "Retrieval of CK [" + i.getName().toUri() + "] failed. "
                 "Got NACK (" + boost::lexical_cast<std::string>(nack.getReason()) + ")");
     },
     [=] (const Interest& i) {
       ck->second.pendingInterest = std::nullopt;
+      m_metrics.nCkTimeouts.increment();
       if (nTriesLeft > 1) {
-        fetchCk(ck, onFailure, nTriesLeft - 1);
+        m_metrics.nCkRetries.increment();
+        fetchCk(ck, nTriesLeft - 1);
       }
       else {
+        NAC_PROBE(ck_fetch_fail, detail::probeHash(ck->first), static_cast<int>(ErrorCode::CkRetrievalTimeout));
         onFailure(ErrorCode::CkRetrievalTimeout,
                   "Retrieval of CK [" + i.getName().toUri() + "] timed out");
       }
@@ -146,69 +450,273 @@ Decryptor::fetchCk(ContentKeys::iterator ck, const ErrorCallback& onFailure, siz
 }
 
 void
-Decryptor::fetchKdk(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData,
-                    const ErrorCallback& onFailure, size_t nTriesLeft)
+Decryptor::validateKeyData(ContentKeys::iterator ck, const Data& data, ErrorCode errorCode,
+                           const ErrorCallback& onFailure, const std::function<void()>& onValidated)
+{
+  ck->second.isValidating = true;
+  m_validationCache->validate(data,
+    [=] (const Data&) {
+      ck->second.isValidating = false;
+      onValidated();
+    },
+    [=] (const Data& invalidData, const security::ValidationError& error) {
+      ck->second.isValidating = false;
+      NDN_LOG_DEBUG("Validation of " << invalidData.getName() << " failed: " << error);
+      m_metrics.nValidationFailures.increment();
+      onFailure(errorCode, "Validation of [" + invalidData.getName().toUri() + "] failed: " +
+                boost::lexical_cast<std::string>(error));
+    });
+}
+
+void
+Decryptor::fetchKdk(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData, size_t nTriesLeft)
 {
   // <kdk-prefix>/KDK/<kdk-id>    /ENCRYPTED-BY  /<credential-identity>/KEY/<key-id>
   // \                          /                \                                /
   //  -----------  -------------                  ---------------  ---------------
   //             \/                                              \/
   //     from the CK data                                from configuration
-
+  //
+  // or, with KdkDistribution::KeyTree
+  //
+  // <kdk-prefix>/KDK/<kdk-id>    /ENCRYPTED-BY  /<kdk-prefix>/NODE/<root-id>/<version>
+  //                                             \              /   \                /
+  //                                              ------  ------     -------  -------
+  //                                                    \/                  \/
+  //                                              from the CK data    from the KDK data
+
+  bool isKeyTree = m_kdkDistribution == KdkDistribution::KeyTree;
   Name kdkName = kdkPrefix;
-  kdkName
-    .append(ENCRYPTED_BY)
-    .append(m_credentialsKey.getName());
+  kdkName.append(ENCRYPTED_BY);
+  if (isKeyTree) {
+    kdkName.append(kdkPrefix.getPrefix(-2)).append(NODE);
+  }
+  else {
+    kdkName.append(m_credentialsKey.getName());
+  }
 
   NDN_LOG_DEBUG("Fetching KDK " << kdkName);
+  auto onFailure = [this, ck] (const ErrorCode& code, const std::string& msg) { failCk(ck, code, msg); };
+
+  m_metrics.nKdkFetches.increment();
+  NAC_PROBE(kdk_fetch_start, detail::probeHash(kdkName), detail::probeHash(ck->first), nTriesLeft);
+  auto sendTime = time::steady_clock::now();
 
-  ck->second.pendingInterest = m_face.expressInterest(Interest(kdkName).setMustBeFresh(true),
-    [=] (const Interest&, const Data& kdkData) {
+  ck->second.pendingInterest = m_face.expressInterest(Interest(kdkName)
+                                                       .setMustBeFresh(true)
+                                                       .setCanBePrefix(isKeyTree),
+    [=] (const Interest& i, const Data& kdkData) {
       ck->second.pendingInterest = std::nullopt;
-      // TODO: verify that the key is legit
-
-      bool isOk = decryptAndImportKdk(kdkData, onFailure);
-      if (!isOk)
-        return;
-      decryptCkAndProcessPendingDecrypts(ck, ckData,
-                                         kdkPrefix.getPrefix(-2).append("KEY").append(kdkPrefix.get(-1)), // a bit hacky
-                                         onFailure);
+      if (kdkData.getContentType() == tlv::ContentType_Nack) {
+        m_metrics.nKdkNacks.increment();
+        NAC_PROBE(kdk_fetch_fail, detail::probeHash(kdkName), detail::probeHash(ck->first),
+                  static_cast<int>(ErrorCode::KdkRetrievalFailure));
+        return onFailure(ErrorCode::KdkRetrievalFailure,
+                         "Retrieval of KDK [" + i.getName().toUri() + "] failed. Got application NACK");
+      }
+      m_metrics.kdkFetchLatency.record(time::steady_clock::now() - sendTime);
+      NAC_PROBE(kdk_fetch_done, detail::probeHash(kdkName), detail::probeHash(ck->first),
+                kdkData.wireEncode().size());
+      validateKeyData(ck, kdkData, ErrorCode::KdkValidationFailure, onFailure, [=] {
+        if (isKeyTree) {
+          auto rootKeyName = kdkData.getName().getSubName(kdkPrefix.size() + 1);
+          auto leaf = m_leafKeys.find(kdkPrefix.getPrefix(-2));
+          return fetchNodeKey(ck, kdkPrefix, ckData, kdkData, rootKeyName,
+                              leaf == m_leafKeys.end() ? nullptr : leaf->second, N_RETRIES);
+        }
+
+        bool isOk = decryptAndImportKdk(kdkData, onFailure);
+        if (!isOk)
+          return;
+        decryptCkAndProcessPendingDecrypts(ck, ckData,
+                                           kdkPrefix.getPrefix(-2).append("KEY").append(kdkPrefix.get(-1)), // a bit hacky
+                                           onFailure);
+      });
     },
     [=] (const Interest& i, const lp::Nack& nack) {
       ck->second.pendingInterest = std::nullopt;
+      m_metrics.nKdkNacks.increment();
+      NAC_PROBE(kdk_fetch_fail, detail::probeHash(kdkName), detail::probeHash(ck->first),
+                static_cast<int>(ErrorCode::KdkRetrievalFailure));
       onFailure(ErrorCode::KdkRetrievalFailure,
                 "Retrieval of KDK [" + i.getName().toUri() + "] failed. "
                 "Got NACK (" + boost::lexical_cast<std::string>(nack.getReason()) + ")");
     },
     [=] (const Interest& i) {
       ck->second.pendingInterest = std::nullopt;
+      m_metrics.nKdkTimeouts.increment();
       if (nTriesLeft > 1) {
-        fetchKdk(ck, kdkPrefix, ckData, onFailure, nTriesLeft - 1);
+        m_metrics.nKdkRetries.increment();
+        fetchKdk(ck, kdkPrefix, ckData, nTriesLeft - 1);
       }
       else {
+        NAC_PROBE(kdk_fetch_fail, detail::probeHash(kdkName), detail::probeHash(ck->first),
+                  static_cast<int>(ErrorCode::KdkRetrievalTimeout));
         onFailure(ErrorCode::KdkRetrievalTimeout,
                   "Retrieval of KDK [" + i.getName().toUri() + "] timed out");
       }
     });
 }
 
+void
+Decryptor::fetchNodeKey(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData, const Data& kdkData,
+                        const Name& rootKeyName, std::shared_ptr<const NodeKey> current, size_t nTriesLeft)
+{
+  // <nac-identity>/NODE/ENCRYPTED-BY/<current-key-name>  /<node-id>/<version>
+  // \                                                 /  \                 /
+  //  -----------------------  ------------------------    --------  -------
+  //                         \/                                    \/
+  //     credentials key or the previously retrieved node key     from the data
+
+  auto onFailure = [this, ck] (const ErrorCode& code, const std::string& msg) { failCk(ck, code, msg); };
+
+  if (current != nullptr && current->name == rootKeyName) {
+    if (!decryptAndImportKdk(kdkData, onFailure, current.get())) {
+      return;
+    }
+    return decryptCkAndProcessPendingDecrypts(ck, ckData,
+                                              kdkPrefix.getPrefix(-2).append("KEY").append(kdkPrefix.get(-1)),
+                                              onFailure);
+  }
+
+  auto nacIdentity = kdkPrefix.getPrefix(-2);
+  Name nodeKeyName = nacIdentity;
+  nodeKeyName
+    .append(NODE)
+    .append(ENCRYPTED_BY)
+    .append(current == nullptr ? m_credentialsKey.getName() : current->name);
+
+  // a leaf that cannot lead to the root anymore (e.g., its member was removed and added again)
+  // is retrieved again with the next KDK
+  auto onNodeKeyFailure = [this, nacIdentity, current, onFailure] (const ErrorCode& code, const std::string& msg) {
+    auto leaf = m_leafKeys.find(nacIdentity);
+    if (leaf != m_leafKeys.end() && (current == nullptr || leaf->second == current)) {
+      m_leafKeys.erase(leaf);
+    }
+    onFailure(code, msg);
+  };
+
+  NDN_LOG_DEBUG("Fetching node key " << nodeKeyName);
+  m_metrics.nNodeKeyFetches.increment();
+
+  ck->second.pendingInterest = m_face.expressInterest(Interest(nodeKeyName)
+                                                       .setMustBeFresh(true)
+                                                       .setCanBePrefix(true),
+    [=] (const Interest& i, const Data& nodeKeyData) {
+      ck->second.pendingInterest = std::nullopt;
+      if (nodeKeyData.getContentType() == tlv::ContentType_Nack) {
+        m_metrics.nKdkNacks.increment();
+        return onNodeKeyFailure(ErrorCode::KdkRetrievalFailure,
+                                "Retrieval of node key [" + i.getName().toUri() + "] failed. Got application NACK");
+      }
+      validateKeyData(ck, nodeKeyData, ErrorCode::KdkValidationFailure, onNodeKeyFailure, [=] {
+        const Name& dataName = nodeKeyData.getName();
+        auto next = std::make_shared<NodeKey>();
+        try {
+          if (dataName.size() != nodeKeyName.size() + 2) {
+            NDN_THROW(Error("Unexpected name of node key"));
+          }
+          next->name = Name(nacIdentity).append(NODE)
+                         .appendNumber(dataName.get(-2).toNumber())
+                         .appendVersion(dataName.get(-1).toVersion());
+
+          EncryptedContent content(nodeKeyData.getContent().blockFromValue());
+          if (current == nullptr) {
+            next->bits = decryptWithCredentials(content.getPayload().value_bytes());
+            if (next->bits.empty()) {
+              return onNodeKeyFailure(ErrorCode::TpmKeyNotFound, "Could not decrypt secret, " +
+                                      m_credentialsKey.getName().toUri() + " not found in TPM");
+            }
+          }
+          else {
+            next->bits = detail::aesUnwrapKey(current->bits, content.getPayload().value_bytes());
+          }
+        }
+        catch (const std::runtime_error& e) {
+          return onNodeKeyFailure(ErrorCode::KdkDecryptionFailure,
+                                  "Failed to decrypt node key [" + dataName.toUri() + "]: " + e.what());
+        }
+
+        if (current == nullptr) {
+          m_leafKeys[nacIdentity] = next;
+        }
+        fetchNodeKey(ck, kdkPrefix, ckData, kdkData, rootKeyName, std::move(next), N_RETRIES);
+      });
+    },
+    [=] (const Interest& i, const lp::Nack& nack) {
+      ck->second.pendingInterest = std::nullopt;
+      m_metrics.nKdkNacks.increment();
+      onNodeKeyFailure(ErrorCode::KdkRetrievalFailure,
+                       "Retrieval of node key [" + i.getName().toUri() + "] failed. "
+                       "Got NACK (" + boost::lexical_cast<std::string>(nack.getReason()) + ")");
+    },
+    [=] (const Interest& i) {
+      ck->second.pendingInterest = std::nullopt;
+      m_metrics.nKdkTimeouts.increment();
+      if (nTriesLeft > 1) {
+        m_metrics.nKdkRetries.increment();
+        fetchNodeKey(ck, kdkPrefix, ckData, kdkData, rootKeyName, current, nTriesLeft - 1);
+      }
+      else {
+        onNodeKeyFailure(ErrorCode::KdkRetrievalTimeout,
+                         "Retrieval of node key [" + i.getName().toUri() + "] timed out");
+      }
+    });
+}
+
+void
+Decryptor::failCk(ContentKeys::iterator ck, const ErrorCode& code, const std::string& msg)
+{
+  auto& contentKey = ck->second;
+  contentKey.nFailures += 1;
+  contentKey.retryAfter = time::steady_clock::now() + m_retryPolicy.getDelay(contentKey.nFailures);
+  contentKey.lastErrorCode = code;
+  contentKey.lastErrorMessage = msg;
+  NDN_LOG_DEBUG("Retrieval of CK " << ck->first << " failed " << contentKey.nFailures << " time(s), failing "
+                << contentKey.pendingDecrypts.size() << " pending decrypts");
+
+  auto pendingDecrypts = std::move(contentKey.pendingDecrypts);
+  m_pendingDecryptDepth.nEntries -= pendingDecrypts.size();
+  m_pendingDecryptDepth.nBytes -= contentKey.nPendingDecryptBytes;
+  contentKey.nPendingDecryptBytes = 0;
+  m_metrics.nPendingDecrypts.decrement(static_cast<int64_t>(pendingDecrypts.size()));
+  for (const auto& item : pendingDecrypts) {
+    item.onFailure(code, msg);
+  }
+}
+
 bool
-Decryptor::decryptAndImportKdk(const Data& kdkData, const ErrorCallback& onFailure)
+Decryptor::decryptAndImportKdk(const Data& kdkData, const ErrorCallback& onFailure, const NodeKey* rootKey)
 {
+  auto startTime = time::steady_clock::now();
   try {
     NDN_LOG_DEBUG("Decrypting and importing KDK " << kdkData.getName());
     EncryptedContent content(kdkData.getContent().blockFromValue());
 
     SafeBag safeBag(content.getPayload().blockFromValue());
-    auto secret = m_keyChain.getTpm().decrypt(content.getPayloadKey().value_bytes(),
-                                              m_credentialsKey.getName());
-    if (secret == nullptr) {
-      onFailure(ErrorCode::TpmKeyNotFound,
-                "Could not decrypt secret, " + m_credentialsKey.getName().toUri() + " not found in TPM");
-      return false;
+    SecureBuffer secret;
+    if (rootKey != nullptr) {
+      secret = detail::aesUnwrapKey(rootKey->bits, content.getPayloadKey().value_bytes());
+    }
+    else {
+      secret = decryptWithCredentials(content.getPayloadKey().value_bytes());
+      if (secret.empty()) {
+        onFailure(ErrorCode::TpmKeyNotFound,
+                  "Could not decrypt secret, " + m_credentialsKey.getName().toUri() + " not found in TPM");
+        return false;
+      }
     }
 
-    m_internalKeyChain.importSafeBag(safeBag, reinterpret_cast<const char*>(secret->data()), secret->size());
+    Certificate kdkCert{Data(safeBag.getCertificate())};
+    if (detail::isEciesKey(kdkCert.getPublicKey())) {
+      security::transform::PrivateKey kdk;
+      kdk.loadPkcs8(safeBag.getEncryptedKey(), reinterpret_cast<const char*>(secret.data()), secret.size());
+      m_eciesKdks[kdkCert.getKeyName()] = std::make_unique<detail::EciesPrivateKey>(kdk);
+    }
+    else {
+      m_internalKeyChain.importSafeBag(safeBag, reinterpret_cast<const char*>(secret.data()), secret.size());
+    }
+    m_metrics.kdkUnwrapLatency.record(time::steady_clock::now() - startTime);
     return true;
   }
   catch (const std::runtime_error& e) {
@@ -219,6 +727,54 @@ Decryptor::decryptAndImportKdk(const Data& kdkData, const ErrorCallback& onFailu
   }
 }
 
+SecureBuffer
+Decryptor::decryptWithCredentials(span<const uint8_t> ciphertext)
+{
+  if (m_credentialsKey.getKeyType() == KeyType::EC) {
+    return getCredentialsEciesKey().unwrap(ciphertext);
+  }
+  auto decrypted = m_keyChain.getTpm().decrypt(ciphertext, m_credentialsKey.getName());
+  if (decrypted == nullptr) {
+    return {};
+  }
+  return SecureBuffer(*decrypted);
+}
+
+const detail::EciesPrivateKey&
+Decryptor::getDerivedKdk(const Name& kdkKeyName, const Name& subDataset)
+{
+  auto derivedKeyName = Name(kdkKeyName).append(DERIVED).append(subDataset);
+  auto derived = m_eciesKdks.find(derivedKeyName);
+  if (derived == m_eciesKdks.end()) {
+    NDN_LOG_DEBUG("Deriving KDK " << derivedKeyName);
+    derived = m_eciesKdks.emplace(derivedKeyName, m_eciesKdks.at(kdkKeyName)->derive(subDataset)).first;
+    m_metrics.nKdkDerivations.increment();
+  }
+  return *derived->second;
+}
+
+const detail::EciesPrivateKey&
+Decryptor::getCredentialsEciesKey()
+{
+  if (m_credentialsEciesKey == nullptr) {
+    NDN_LOG_DEBUG("Exporting credentials key " << m_credentialsKey.getName() << " for ECDH");
+    // the one-time export password lives in secure memory and is wiped when it goes out of scope
+    SecureBuffer password(16);
+    random::generateSecureBytes(password);
+    for (auto& c : password) {
+      c = static_cast<uint8_t>('a' + (c & 0x0f));
+    }
+    auto passwordChars = reinterpret_cast<const char*>(password.data());
+    auto safeBag = m_keyChain.exportSafeBag(m_credentialsKey.getDefaultCertificate(),
+                                            passwordChars, password.size());
+
+    security::transform::PrivateKey key;
+    key.loadPkcs8(safeBag->getEncryptedKey(), passwordChars, password.size());
+    m_credentialsEciesKey = std::make_unique<detail::EciesPrivateKey>(key);
+  }
+  return *m_credentialsEciesKey;
+}
+
 void
 Decryptor::decryptCkAndProcessPendingDecrypts(ContentKeys::iterator ck, const Data& ckData, const Name& kdkKeyName,
                                               const ErrorCallback& onFailure)
@@ -227,38 +783,123 @@ Decryptor::decryptCkAndProcessPendingDecrypts(ContentKeys::iterator ck, const Da
 
   EncryptedContent content(ckData.getContent().blockFromValue());
 
-  auto ckBits = m_internalKeyChain.getTpm().decrypt(content.getPayload().value_bytes(), kdkKeyName);
-  if (ckBits == nullptr) {
-    onFailure(ErrorCode::TpmKeyNotFound, "Could not decrypt secret, " + kdkKeyName.toUri() + " not found in TPM");
+  auto startTime = time::steady_clock::now();
+  SecureBuffer ckBits;
+  // the CK of a sub-dataset is encrypted with a KEK derived from that of the dataset
+  auto subDataset = splitDerivedKekName(ckData.getName().getSubName(ck->first.size() + 1)).second;
+  auto eciesKdk = m_eciesKdks.find(kdkKeyName);
+  if (!subDataset.empty() && eciesKdk == m_eciesKdks.end()) {
+    onFailure(ErrorCode::CkDecryptionFailure,
+              "Failed to decrypt CK [" + ckData.getName().toUri() + "]: only EC KDKs can be derived");
     return;
   }
+  if (eciesKdk != m_eciesKdks.end()) {
+    try {
+      const auto& kdk = subDataset.empty() ? *eciesKdk->second : getDerivedKdk(kdkKeyName, subDataset);
+      ckBits = kdk.unwrap(content.getPayload().value_bytes());
+    }
+    catch (const Error& e) {
+      onFailure(ErrorCode::CkDecryptionFailure,
+                "Failed to decrypt CK [" + ckData.getName().toUri() + "]: " + e.what());
+      return;
+    }
+  }
+  else {
+    auto decrypted = m_internalKeyChain.getTpm().decrypt(content.getPayload().value_bytes(), kdkKeyName);
+    if (decrypted == nullptr) {
+      onFailure(ErrorCode::TpmKeyNotFound, "Could not decrypt secret, " + kdkKeyName.toUri() + " not found in TPM");
+      return;
+    }
+    ckBits = SecureBuffer(*decrypted);
+  }
+  m_metrics.ckUnwrapLatency.record(time::steady_clock::now() - startTime);
 
-  ck->second.bits = *ckBits;
+  try {
+    ck->second.cipher = std::make_shared<detail::AesCbcCipher>(ckBits, CipherOperator::DECRYPT);
+  }
+  catch (const Error& e) {
+    onFailure(ErrorCode::CkDecryptionFailure,
+              "Failed to decrypt CK [" + ckData.getName().toUri() + "]: " + e.what());
+    return;
+  }
   ck->second.isRetrieved = true;
-
-  for (const auto& item : ck->second.pendingDecrypts) {
-    doDecrypt(item.encryptedContent, ck->second.bits, item.onSuccess, item.onFailure);
+  ck->second.nFailures = 0;
+
+  // the queue is no longer needed once the CK is retrieved
+  auto pendingDecrypts = std::move(ck->second.pendingDecrypts);
+  m_pendingDecryptDepth.nEntries -= pendingDecrypts.size();
+  m_pendingDecryptDepth.nBytes -= ck->second.nPendingDecryptBytes;
+  ck->second.nPendingDecryptBytes = 0;
+  m_metrics.nPendingDecrypts.decrement(static_cast<int64_t>(pendingDecrypts.size()));
+  for (const auto& item : pendingDecrypts) {
+    decryptAndNotify(EncryptedContent(item.encryptedContent), *ck->second.cipher, item.onSuccess, item.onFailure);
   }
-  ck->second.pendingDecrypts.clear();
 }
 
 void
-Decryptor::doDecrypt(const EncryptedContent& content, const Buffer& ckBits,
-                     const DecryptSuccessCallback& onSuccess,
-                     const ErrorCallback& onFailure)
+Decryptor::decryptAndNotify(const EncryptedContent& content, detail::AesCbcCipher& cipher,
+                            const DecryptSuccessCallback& onSuccess, const ErrorCallback& onFailure)
+{
+  auto startTime = time::steady_clock::now();
+  ConstBufferPtr plaintext;
+  try {
+    plaintext = doDecrypt(content, cipher);
+  }
+  catch (const Error& e) {
+    // corrupted payload or IV, or a payload not encrypted with this CK
+    NDN_LOG_INFO("Cannot decrypt payload with CK " << content.getKeyLocator() << ": " << e.what());
+    return onFailure(ErrorCode::PayloadDecryptionFailure,
+                     "Failed to decrypt payload with CK [" + content.getKeyLocator().toUri() + "]: " +
+                     e.what());
+  }
+  m_metrics.decryptLatency.record(time::steady_clock::now() - startTime);
+  onSuccess(plaintext);
+}
+
+ConstBufferPtr
+Decryptor::doDecrypt(const EncryptedContent& content, detail::AesCbcCipher& cipher)
 {
   if (!content.hasIv()) {
     NDN_THROW(Error("Expecting Initialization Vector in the encrypted content, but it is not present"));
   }
 
-  OBufferStream os;
-  security::transform::bufferSource(content.getPayload().value_bytes())
-    >> security::transform::blockCipher(BlockCipherAlgorithm::AES_CBC,
-                                        CipherOperator::DECRYPT,
-                                        ckBits, content.getIv().value_bytes())
-    >> security::transform::streamSink(os);
+  NAC_PROBE(payload_decrypt_start, detail::probeHash(content.getKeyLocator()), content.getPayload().value_size());
 
-  onSuccess(os.buf());
+  auto plaintext = cipher.process(content.getIv().value_bytes(), content.getPayload().value_bytes());
+  NAC_PROBE(payload_decrypt_done, detail::probeHash(content.getKeyLocator()), plaintext->size());
+  return plaintext;
+}
+
+Decryptor::MetricsSnapshot
+Decryptor::getMetrics() const
+{
+  MetricsSnapshot snapshot;
+  snapshot.nCkFetches = m_metrics.nCkFetches.get();
+  snapshot.nCkRetries = m_metrics.nCkRetries.get();
+  snapshot.nCkNacks = m_metrics.nCkNacks.get();
+  snapshot.nCkTimeouts = m_metrics.nCkTimeouts.get();
+  snapshot.nKdkFetches = m_metrics.nKdkFetches.get();
+  snapshot.nKdkRetries = m_metrics.nKdkRetries.get();
+  snapshot.nKdkNacks = m_metrics.nKdkNacks.get();
+  snapshot.nKdkTimeouts = m_metrics.nKdkTimeouts.get();
+  snapshot.nNodeKeyFetches = m_metrics.nNodeKeyFetches.get();
+  snapshot.nKdkDerivations = m_metrics.nKdkDerivations.get();
+  snapshot.nCkCacheHits = m_metrics.nCkCacheHits.get();
+  snapshot.nCkCacheMisses = m_metrics.nCkCacheMisses.get();
+  snapshot.nKdkCacheHits = m_metrics.nKdkCacheHits.get();
+  snapshot.nKdkCacheMisses = m_metrics.nKdkCacheMisses.get();
+  snapshot.nPendingDecrypts = m_metrics.nPendingDecrypts.get();
+  snapshot.nPendingDecryptOverflows = m_metrics.nPendingDecryptOverflows.get();
+  snapshot.nCkNegativeCacheHits = m_metrics.nCkNegativeCacheHits.get();
+  snapshot.nValidations = m_metrics.nValidations.get();
+  snapshot.nValidationCacheHits = m_metrics.nValidationCacheHits.get();
+  snapshot.nValidationFailures = m_metrics.nValidationFailures.get();
+  snapshot.ckFetchLatency = m_metrics.ckFetchLatency.getSnapshot();
+  snapshot.kdkFetchLatency = m_metrics.kdkFetchLatency.getSnapshot();
+  snapshot.kdkUnwrapLatency = m_metrics.kdkUnwrapLatency.getSnapshot();
+  snapshot.ckUnwrapLatency = m_metrics.ckUnwrapLatency.getSnapshot();
+  snapshot.decryptLatency = m_metrics.decryptLatency.getSnapshot();
+  return snapshot;
 }
 
 } // namespace ndn::nac
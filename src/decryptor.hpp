@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -22,12 +22,28 @@
 
 #include "common.hpp"
 #include "encrypted-content.hpp"
+#include "metrics.hpp"
+#include "secure-memory.hpp"
 
-#include <list>
+#include <deque>
+#include <limits>
 #include <map>
 
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/circular_buffer.hpp>
+
 namespace ndn::nac {
 
+namespace detail {
+class AesCbcCipher;
+class EciesPrivateKey;
+class ValidationCache;
+} // namespace detail
+
 /**
  * @brief NAC Decryptor
  *
@@ -36,13 +52,17 @@ namespace ndn::nac {
  */
 class Decryptor
 {
+  friend tests::BenchmarkAccess;
+
 public:
   using DecryptSuccessCallback = std::function<void(ConstBufferPtr)>;
 
   /**
    * @brief Constructor
    * @param credentialsKey Credentials key to be used to retrieve and decrypt KDK
-   * @param validator Validation policy to ensure validity of KDK and CK
+   * @param validator Validation policy to ensure validity of KDK and CK; successful validations
+   *                  are remembered, so that a packet (or a batch of packets) is validated only
+   *                  once
    * @param keyChain  KeyChain
    * @param face      Face that will be used to fetch CK and KDK
    */
@@ -52,62 +72,438 @@ public:
 
   /**
    * @brief Asynchronously decrypt @p encryptedContent
+   *
+   * A malformed @p encryptedContent, or a payload that cannot be decrypted with its CK, is
+   * reported to @p onFailure rather than thrown.
    */
   void
   decrypt(const Block& encryptedContent,
           const DecryptSuccessCallback& onSuccess, const ErrorCallback& onFailure);
 
-private:
+  /**
+   * @brief Asynchronously decrypt @p encryptedContent, with completion token @p token
+   *
+   * The completion signature is `void(boost::system::error_code, ConstBufferPtr)`, where errors
+   * are ErrorCode values (see getErrorCategory()).  The handler is invoked through its associated
+   * executor, by default that of the Face's io_context; it is never invoked from within this
+   * call.  For example, in a C++20 coroutine:
+   * @code
+   * ConstBufferPtr plaintext = co_await decryptor.decrypt(block, boost::asio::use_awaitable);
+   * @endcode
+   *
+   * If the CK has already been retrieved, decryption happens right away as with tryDecrypt().
+   */
+  template<typename CompletionToken>
+  auto
+  decrypt(const Block& encryptedContent, CompletionToken&& token)
+  {
+    return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, ConstBufferPtr)>(
+      [this] (auto&& handler, const Block& block) {
+        initiateDecrypt(std::forward<decltype(handler)>(handler), block);
+      }, token, encryptedContent);
+  }
+
+  /**
+   * @brief Synchronously decrypt @p encryptedContent if its CK has already been retrieved
+   *
+   * Unlike decrypt(), this method never initiates retrieval of the CK.  Decrypting content
+   * encrypted with the same CK as in the previous call does not allocate memory.
+   *
+   * @param encryptedContent EncryptedContent element
+   * @param[out] plaintext buffer for the plaintext, at least as large as the encrypted payload
+   * @return size of the plaintext, or std::nullopt if the CK has not been retrieved (yet)
+   * @throw Error @p encryptedContent is malformed, @p plaintext is too small, or decryption failed
+   */
+  std::optional<size_t>
+  tryDecrypt(const Block& encryptedContent, span<uint8_t> plaintext);
+
+  /**
+   * @brief Synchronously decrypt @p encryptedContent if its CK has already been retrieved
+   * @return the plaintext, or nullptr if the CK has not been retrieved (yet)
+   * @throw Error @p encryptedContent is malformed or decryption failed
+   */
+  ConstBufferPtr
+  tryDecrypt(const Block& encryptedContent);
+
+  /**
+   * @brief Limits on decrypts waiting for retrieval of their CK
+   *
+   * Sizes are counted in octets of the encrypted payload.
+   */
+  struct PendingDecryptLimits
+  {
+    enum class OverflowPolicy {
+      Reject,     ///< fail the new decrypt with ErrorCode::PendingDecryptsOverflow
+      DropOldest, ///< fail the oldest pending decrypts (of the same CK for the per-CK limits)
+                  ///< with ErrorCode::PendingDecryptsOverflow to make room for the new one
+    };
+
+    size_t maxEntriesPerCk = std::numeric_limits<size_t>::max();
+    size_t maxBytesPerCk = std::numeric_limits<size_t>::max();
+    size_t maxEntries = std::numeric_limits<size_t>::max();
+    size_t maxBytes = std::numeric_limits<size_t>::max();
+    OverflowPolicy overflowPolicy = OverflowPolicy::Reject;
+  };
+
+  /**
+   * @brief Set limits on pending decrypts (unlimited by default)
+   *
+   * The new limits apply to subsequent decrypts; already pending decrypts are not affected.
+   */
+  void
+  setPendingDecryptLimits(const PendingDecryptLimits& limits)
+  {
+    m_pendingDecryptLimits = limits;
+  }
+
+  struct PendingDecryptDepth
+  {
+    size_t nEntries = 0;
+    size_t nBytes = 0;
+  };
+
+  /**
+   * @brief Get the number and total size of decrypts waiting for retrieval of their CK
+   */
+  PendingDecryptDepth
+  getPendingDecryptDepth() const
+  {
+    return m_pendingDecryptDepth;
+  }
+
+  /**
+   * @brief Get the number and total size of decrypts waiting for retrieval of CK @p ckName
+   */
+  PendingDecryptDepth
+  getPendingDecryptDepth(const Name& ckName) const;
+
+  /**
+   * @brief Set how long a failed CK retrieval is remembered
+   *
+   * When retrieval of a CK (or of the KDK needed to decrypt it) fails, all decrypts waiting for
+   * that CK fail, and subsequent decrypts using that CK fail immediately with the same error
+   * until the delay given by @p policy elapses.  The next decrypt after that retries the
+   * retrieval.  The default is RetryPolicy().
+   */
+  void
+  setRetryPolicy(const RetryPolicy& policy)
+  {
+    m_retryPolicy = policy;
+  }
+
+  /**
+   * @brief Select how KDKs are retrieved, which must match the AccessManager of the dataset
+   *
+   * With KdkDistribution::KeyTree, the Decryptor retrieves the node keys from its leaf up to
+   * the root, and keeps its leaf node key for each NAC identity, so that only the node keys
+   * that have changed since are retrieved for a new KDK.
+   */
+  void
+  setKdkDistribution(KdkDistribution mode)
+  {
+    m_kdkDistribution = mode;
+  }
+
+  /**
+   * @brief Point-in-time view of Decryptor counters, gauges, and per-stage latencies
+   */
+  struct MetricsSnapshot
+  {
+    uint64_t nCkFetches = 0;      ///< CK Interests expressed, including retries
+    uint64_t nCkRetries = 0;      ///< CK Interests re-expressed after a timeout
+    uint64_t nCkNacks = 0;
+    uint64_t nCkTimeouts = 0;
+    uint64_t nKdkFetches = 0;     ///< KDK Interests expressed, including retries
+    uint64_t nKdkRetries = 0;     ///< KDK Interests re-expressed after a timeout
+    uint64_t nKdkNacks = 0;
+    uint64_t nKdkTimeouts = 0;
+    uint64_t nNodeKeyFetches = 0; ///< node key Interests expressed with KdkDistribution::KeyTree
+    uint64_t nKdkDerivations = 0; ///< KDKs of sub-datasets derived from an already imported KDK
+    uint64_t nCkCacheHits = 0;    ///< decrypts that found the CK already retrieved
+    uint64_t nCkCacheMisses = 0;  ///< decrypts that had to wait for the CK
+    uint64_t nKdkCacheHits = 0;   ///< CKs decrypted using an already imported KDK
+    uint64_t nKdkCacheMisses = 0; ///< CKs that required KDK retrieval
+    int64_t nPendingDecrypts = 0; ///< decrypts currently waiting for their CK
+    uint64_t nPendingDecryptOverflows = 0; ///< decrypts failed because of PendingDecryptLimits
+    uint64_t nCkNegativeCacheHits = 0; ///< decrypts failed right away after a failed CK retrieval
+    uint64_t nValidations = 0;         ///< CK, KDK, and node key Data passed to the Validator
+    uint64_t nValidationCacheHits = 0; ///< CK, KDK, and node key Data accepted without the Validator
+    uint64_t nValidationFailures = 0;
+
+    LatencyHistogram::Snapshot ckFetchLatency;   ///< from CK Interest to CK Data
+    LatencyHistogram::Snapshot kdkFetchLatency;  ///< from KDK Interest to KDK Data
+    LatencyHistogram::Snapshot kdkUnwrapLatency; ///< TPM decryption and import of KDK
+    LatencyHistogram::Snapshot ckUnwrapLatency;  ///< decryption of CK using KDK
+    LatencyHistogram::Snapshot decryptLatency;   ///< AES decryption of the content
+  };
+
+  /**
+   * @brief Get a snapshot of the metrics of this Decryptor
+   *
+   * Can be called from any thread.  The metrics of all Decryptors are also reported, summed up,
+   * into MetricsRegistry::getDefault() under `nac.Decryptor.`
+   */
+  MetricsSnapshot
+  getMetrics() const;
+
+NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   struct ContentKey
   {
     bool isRetrieved = false;
-    Buffer bits;
+    // the CK bits exist only as the key schedule of this cipher, expanded once on retrieval
+    std::shared_ptr<detail::AesCbcCipher> cipher;
     std::optional<PendingInterestHandle> pendingInterest;
+    bool isValidating = false; // CK, KDK, or node key Data is being validated
+
+    bool
+    isBeingRetrieved() const
+    {
+      return pendingInterest.has_value() || isValidating;
+    }
+
+    // negative caching of failed retrievals
+    size_t nFailures = 0; // consecutive failed retrievals
+    time::steady_clock::time_point retryAfter;
+    ErrorCode lastErrorCode = ErrorCode::CkRetrievalFailure;
+    std::string lastErrorMessage;
 
     struct PendingDecrypt
     {
-      EncryptedContent encryptedContent;
+      Block encryptedContent; // parsed again only when the CK is retrieved
       DecryptSuccessCallback onSuccess;
       ErrorCallback onFailure;
+      uint64_t seqNo; // for finding the oldest pending decrypt across CKs
     };
-    std::list<PendingDecrypt> pendingDecrypts;
+    // grows geometrically while the CK is being retrieved, released once it is retrieved
+    boost::circular_buffer<PendingDecrypt> pendingDecrypts;
+    size_t nPendingDecryptBytes = 0;
   };
 
   using ContentKeys = std::map<Name, ContentKey>;
 
+  /**
+   * @brief Queue a decrypt until CK @p ck is retrieved, subject to m_pendingDecryptLimits
+   * @return whether the decrypt was queued; if not, its onFailure has been called
+   */
+  bool
+  enqueuePendingDecrypt(ContentKeys::iterator ck, ContentKey::PendingDecrypt&& item);
+
+  void
+  dropOldestPendingDecrypt(ContentKeys::iterator ck);
+
+  /**
+   * @brief Find the CK whose queue holds the oldest pending decrypt across all CKs
+   * @pre m_pendingDecryptDepth.nEntries > 0
+   */
+  ContentKeys::iterator
+  findOldestPendingDecrypt();
+
+  /**
+   * @brief Whether an entry of m_pendingDecryptOrder refers to a decrypt that is still queued
+   */
+  static bool
+  isPending(const std::pair<uint64_t, ContentKeys::iterator>& entry);
+
+  template<typename Handler>
+  void
+  initiateDecrypt(Handler&& handler, const Block& encryptedContent)
+  {
+    using H = std::decay_t<Handler>;
+    auto executor = boost::asio::get_associated_executor(handler, m_face.getIoContext().get_executor());
+
+    ConstBufferPtr result;
+    try {
+      result = tryDecrypt(encryptedContent);
+    }
+    catch (const Error&) {
+      // let decrypt() report the error through the usual path; it reports malformed or
+      // undecryptable content to onFailure instead of throwing
+    }
+    if (result != nullptr) {
+      boost::asio::post(executor, [h = H(std::forward<Handler>(handler)), result] () mutable {
+        std::move(h)(boost::system::error_code{}, std::move(result));
+      });
+      return;
+    }
+
+    // the callbacks are copied into the pending decrypt, while the handler may be move-only
+    auto h = std::make_shared<H>(std::forward<Handler>(handler));
+    decrypt(encryptedContent,
+      [h, executor] (ConstBufferPtr plaintext) {
+        boost::asio::dispatch(executor, [h, plaintext = std::move(plaintext)] () mutable {
+          std::move(*h)(boost::system::error_code{}, std::move(plaintext));
+        });
+      },
+      [h, executor] (const ErrorCode& code, const std::string&) {
+        // errors can be reported from within decrypt()
+        boost::asio::post(executor, [h, code] {
+          std::move(*h)(make_error_code(code), nullptr);
+        });
+      });
+  }
+
+  /**
+   * @brief Find a retrieved CK by the wire encoding of its name
+   * @return the CK, or nullptr if the CK has not been retrieved
+   */
+  const ContentKey*
+  findRetrievedCk(span<const uint8_t> ckNameWire);
+
+  void
+  fetchCk(ContentKeys::iterator ck, size_t nTriesLeft);
+
+  /**
+   * @brief Validate @p data retrieved for CK @p ck, then call @p onValidated
+   */
+  void
+  validateKeyData(ContentKeys::iterator ck, const Data& data, ErrorCode errorCode,
+                  const ErrorCallback& onFailure, const std::function<void()>& onValidated);
+
+  void
+  fetchKdk(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData, size_t nTriesLeft);
+
+  struct NodeKey
+  {
+    Name name; // <nac-identity>/NODE/<node-id>/<version>
+    SecureBuffer bits;
+  };
+
+  /**
+   * @brief Retrieve the node key wrapped with @p current (or, if nullptr, the leaf node key
+   *        encrypted with the credentials key), until reaching @p rootKeyName that wraps the
+   *        password of @p kdkData
+   */
   void
-  fetchCk(ContentKeys::iterator ck, const ErrorCallback& onFailure, size_t nTriesLeft);
+  fetchNodeKey(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData, const Data& kdkData,
+               const Name& rootKeyName, std::shared_ptr<const NodeKey> current, size_t nTriesLeft);
 
+  /**
+   * @brief Fail all decrypts waiting for CK @p ck and negatively cache the failure
+   */
   void
-  fetchKdk(ContentKeys::iterator ck, const Name& kdkPrefix, const Data& ckData,
-           const ErrorCallback& onFailure, size_t nTriesLeft);
+  failCk(ContentKeys::iterator ck, const ErrorCode& code, const std::string& msg);
 
+  /**
+   * @brief Decrypt and import KDK, whose password is encrypted with the credentials key or,
+   *        if given, wrapped with @p rootKey
+   */
   bool
-  decryptAndImportKdk(const Data& kdkData, const ErrorCallback& onFailure);
+  decryptAndImportKdk(const Data& kdkData, const ErrorCallback& onFailure,
+                      const NodeKey* rootKey = nullptr);
+
+  /**
+   * @brief Decrypt a secret encrypted with the public key of m_credentialsKey
+   * @return the secret, or an empty buffer if the private key is not in the TPM
+   */
+  SecureBuffer
+  decryptWithCredentials(span<const uint8_t> ciphertext);
+
+  /**
+   * @brief Get the credentials key for unwrapping KDKs encrypted with the ECDH-based scheme
+   *
+   * The TPM cannot perform ECDH, so the private key is exported from @p m_keyChain once and
+   * kept in memory for the lifetime of the Decryptor.
+   *
+   * @throw std::runtime_error the key cannot be exported
+   */
+  const detail::EciesPrivateKey&
+  getCredentialsEciesKey();
+
+  /**
+   * @brief Get the KDK of sub-dataset @p subDataset, derived from the imported EC KDK
+   *        @p kdkKeyName on first use
+   * @throw Error the KDK cannot be derived
+   */
+  const detail::EciesPrivateKey&
+  getDerivedKdk(const Name& kdkKeyName, const Name& subDataset);
 
   void
   decryptCkAndProcessPendingDecrypts(ContentKeys::iterator ck, const Data& ckData,
                                      const Name& kdkKeyName/* local keyChain name for KDK key*/,
                                      const ErrorCallback& onFailure);
 
+  /**
+   * @brief Decrypt @p encryptedContent with @p cipher and record its latency
+   *
+   * A payload that cannot be decrypted is reported to @p onFailure, so that one corrupted
+   * decrypt does not affect the others pending on the same CK.
+   */
+  void
+  decryptAndNotify(const EncryptedContent& encryptedContent, detail::AesCbcCipher& cipher,
+                   const DecryptSuccessCallback& onSuccess, const ErrorCallback& onFailure);
+
   /**
    * @brief Synchronously decrypt
    */
-  static void
-  doDecrypt(const EncryptedContent& encryptedContent, const Buffer& ckBits,
-            const DecryptSuccessCallback& onSuccess,
-            const ErrorCallback& onFailure);
+  static ConstBufferPtr
+  doDecrypt(const EncryptedContent& encryptedContent, detail::AesCbcCipher& cipher);
+
+  /**
+   * @brief Metrics of this instance, each also added to the metric of the same name in
+   *        MetricsRegistry::getDefault()
+   */
+  struct Metrics
+  {
+    Metrics();
+
+    Counter nCkFetches;
+    Counter nCkRetries;
+    Counter nCkNacks;
+    Counter nCkTimeouts;
+    Counter nKdkFetches;
+    Counter nKdkRetries;
+    Counter nKdkNacks;
+    Counter nKdkTimeouts;
+    Counter nNodeKeyFetches;
+    Counter nKdkDerivations;
+    Counter nCkCacheHits;
+    Counter nCkCacheMisses;
+    Counter nKdkCacheHits;
+    Counter nKdkCacheMisses;
+    Gauge nPendingDecrypts;
+    Counter nPendingDecryptOverflows;
+    Counter nCkNegativeCacheHits;
+    Counter nValidations;
+    Counter nValidationCacheHits;
+    Counter nValidationFailures;
+
+    LatencyHistogram ckFetchLatency;
+    LatencyHistogram kdkFetchLatency;
+    LatencyHistogram kdkUnwrapLatency;
+    LatencyHistogram ckUnwrapLatency;
+    LatencyHistogram decryptLatency;
+  };
 
-private:
+NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   Key m_credentialsKey;
-  // Validator& m_validator;
   Face& m_face;
   KeyChain& m_keyChain; // external keychain with access credentials
   KeyChain m_internalKeyChain; // internal in-memory keychain for temporarily storing KDKs
+  std::unique_ptr<detail::EciesPrivateKey> m_credentialsEciesKey;
+  // EC KDKs, which cannot be used for decryption through the TPM
+  std::map<Name, std::unique_ptr<detail::EciesPrivateKey>> m_eciesKdks;
+  KdkDistribution m_kdkDistribution = KdkDistribution::Direct;
+  // NAC identity => leaf node key, only with KdkDistribution::KeyTree
+  std::map<Name, std::shared_ptr<const NodeKey>> m_leafKeys;
 
   // a set of Content Keys
   // TODO: add some expiration, so they are not stored forever
   ContentKeys m_cks;
+  // most recently used CK of tryDecrypt(), to look it up without decoding its name
+  ContentKeys::iterator m_hotCk = m_cks.end();
+  Buffer m_hotCkNameWire;
+
+  PendingDecryptLimits m_pendingDecryptLimits;
+  PendingDecryptDepth m_pendingDecryptDepth;
+  uint64_t m_nextPendingDecryptSeqNo = 0;
+  // (seqNo, CK) of every queued decrypt in arrival order; entries of decrypts that already left
+  // their queue are skipped and pruned lazily
+  std::deque<std::pair<uint64_t, ContentKeys::iterator>> m_pendingDecryptOrder;
+
+  RetryPolicy m_retryPolicy;
+
+  Metrics m_metrics;
+  std::unique_ptr<detail::ValidationCache> m_validationCache; // uses m_metrics
 };
 
 } // namespace ndn::nac
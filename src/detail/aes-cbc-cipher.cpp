@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/aes-cbc-cipher.hpp"
+
+#include <ndn-cxx/util/exception.hpp>
+
+#include <openssl/evp.h>
+
+#include <climits>
+
+namespace ndn::nac::detail {
+
+AesCbcCipher::AesCbcCipher(span<const uint8_t> key, CipherOperator op)
+  : m_ctx(EVP_CIPHER_CTX_new())
+  , m_op(op)
+{
+  if (key.size() != AES_KEY_SIZE) {
+    EVP_CIPHER_CTX_free(m_ctx);
+    NDN_THROW(Error("Invalid AES-256-CBC key size"));
+  }
+
+  // the key is expanded only once, later initializations only replace the IV
+  if (m_ctx == nullptr ||
+      EVP_CipherInit_ex(m_ctx, EVP_aes_256_cbc(), nullptr, key.data(), nullptr,
+                        op == CipherOperator::ENCRYPT ? 1 : 0) != 1) {
+    EVP_CIPHER_CTX_free(m_ctx);
+    NDN_THROW(Error("Failed to initialize AES-256-CBC context"));
+  }
+}
+
+AesCbcCipher::~AesCbcCipher()
+{
+  EVP_CIPHER_CTX_free(m_ctx);
+}
+
+size_t
+AesCbcCipher::process(span<const uint8_t> iv, span<const uint8_t> input, span<uint8_t> output)
+{
+  if (iv.size() != AES_IV_SIZE) {
+    NDN_THROW(Error("Invalid AES-256-CBC IV size"));
+  }
+  if (output.size() < getMaxOutputSize(input.size()) || input.size() > INT_MAX - AES_IV_SIZE) {
+    NDN_THROW(Error("Invalid buffer size for AES-256-CBC"));
+  }
+
+  // a freshly initialized context holds back the last block until finalization,
+  // so the output never exceeds getMaxOutputSize()
+  int len = 0;
+  int finalLen = 0;
+  if (EVP_CipherInit_ex(m_ctx, nullptr, nullptr, nullptr, iv.data(), -1) != 1 ||
+      EVP_CipherUpdate(m_ctx, output.data(), &len, input.data(), static_cast<int>(input.size())) != 1 ||
+      EVP_CipherFinal_ex(m_ctx, output.data() + len, &finalLen) != 1) {
+    NDN_THROW(Error(m_op == CipherOperator::ENCRYPT ? "AES-256-CBC encryption failed"
+                                                    : "AES-256-CBC decryption failed"));
+  }
+  return static_cast<size_t>(len + finalLen);
+}
+
+ConstBufferPtr
+AesCbcCipher::process(span<const uint8_t> iv, span<const uint8_t> input)
+{
+  auto output = std::make_shared<Buffer>(getMaxOutputSize(input.size()));
+  output->resize(process(iv, input, *output));
+  return output;
+}
+
+} // namespace ndn::nac::detail
@@ -0,0 +1,86 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_AES_CBC_CIPHER_HPP
+#define NDN_NAC_DETAIL_AES_CBC_CIPHER_HPP
+
+#include "common.hpp"
+
+struct evp_cipher_ctx_st;
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief AES-256-CBC cipher handle bound to one content key
+ *
+ * The ndn-cxx transform chain creates a cipher context, expands the key, and allocates its
+ * output for every operation.  This handle expands the key once, at construction; each
+ * operation then only sets the IV and processes the input into a buffer supplied by the
+ * caller, without allocating memory.
+ *
+ * The expanded key lives in memory allocated by OpenSSL from the ordinary heap, not in
+ * SecureArena; it is wiped when the handle is destroyed, but may be swapped to disk or
+ * written to a core dump before then.
+ */
+class AesCbcCipher : noncopyable
+{
+public:
+  /**
+   * @param key 256-bit key
+   * @param op whether the handle encrypts or decrypts
+   * @throw Error invalid key size
+   */
+  AesCbcCipher(span<const uint8_t> key, CipherOperator op);
+
+  ~AesCbcCipher();
+
+  /**
+   * @brief Maximum size of the output for @p inputSize bytes of input
+   */
+  size_t
+  getMaxOutputSize(size_t inputSize) const noexcept
+  {
+    return m_op == CipherOperator::ENCRYPT ? (inputSize / AES_IV_SIZE + 1) * AES_IV_SIZE : inputSize;
+  }
+
+  /**
+   * @brief Encrypt or decrypt @p input, padded according to PKCS #7
+   * @param iv 128-bit initialization vector
+   * @param input plaintext or ciphertext
+   * @param[out] output buffer of at least getMaxOutputSize() bytes
+   * @return size of the output
+   * @throw Error invalid IV or buffer size, or the ciphertext cannot be decrypted
+   */
+  size_t
+  process(span<const uint8_t> iv, span<const uint8_t> input, span<uint8_t> output);
+
+  /**
+   * @brief Encrypt or decrypt @p input into a new buffer
+   */
+  ConstBufferPtr
+  process(span<const uint8_t> iv, span<const uint8_t> input);
+
+private:
+  evp_cipher_ctx_st* m_ctx;
+  CipherOperator m_op;
+};
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_AES_CBC_CIPHER_HPP
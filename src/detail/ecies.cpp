@@ -0,0 +1,481 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/ecies.hpp"
+
+#include <ndn-cxx/encoding/buffer-stream.hpp>
+#include <ndn-cxx/util/exception.hpp>
+
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/objects.h>
+#include <openssl/x509.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+#endif
+
+namespace ndn::nac::detail {
+
+namespace {
+
+const char HKDF_INFO[] = "NDN-NAC ECIES AES-256-KWP";
+const char DERIVE_INFO[] = "NDN-NAC EC key derivation";
+
+struct EvpPkeyDeleter
+{
+  void
+  operator()(EVP_PKEY* key) const noexcept
+  {
+    EVP_PKEY_free(key);
+  }
+};
+
+struct EvpPkeyCtxDeleter
+{
+  void
+  operator()(EVP_PKEY_CTX* ctx) const noexcept
+  {
+    EVP_PKEY_CTX_free(ctx);
+  }
+};
+
+struct EvpCipherCtxDeleter
+{
+  void
+  operator()(EVP_CIPHER_CTX* ctx) const noexcept
+  {
+    EVP_CIPHER_CTX_free(ctx);
+  }
+};
+
+struct BnDeleter
+{
+  void
+  operator()(BIGNUM* bn) const noexcept
+  {
+    BN_clear_free(bn);
+  }
+};
+
+struct BnCtxDeleter
+{
+  void
+  operator()(BN_CTX* ctx) const noexcept
+  {
+    BN_CTX_free(ctx);
+  }
+};
+
+struct EcGroupDeleter
+{
+  void
+  operator()(EC_GROUP* group) const noexcept
+  {
+    EC_GROUP_free(group);
+  }
+};
+
+struct EcPointDeleter
+{
+  void
+  operator()(EC_POINT* point) const noexcept
+  {
+    EC_POINT_free(point);
+  }
+};
+
+using EvpPkey = std::unique_ptr<EVP_PKEY, EvpPkeyDeleter>;
+using EvpPkeyCtx = std::unique_ptr<EVP_PKEY_CTX, EvpPkeyCtxDeleter>;
+using EvpCipherCtx = std::unique_ptr<EVP_CIPHER_CTX, EvpCipherCtxDeleter>;
+using Bn = std::unique_ptr<BIGNUM, BnDeleter>;
+using BnCtx = std::unique_ptr<BN_CTX, BnCtxDeleter>;
+using EcGroup = std::unique_ptr<EC_GROUP, EcGroupDeleter>;
+using EcPoint = std::unique_ptr<EC_POINT, EcPointDeleter>;
+
+bool
+isSupportedKeyType(const EVP_PKEY* key)
+{
+  // ndn-cxx can neither generate nor store X25519/X448 keys, so only EC keys are accepted
+  return EVP_PKEY_base_id(key) == EVP_PKEY_EC;
+}
+
+EvpPkey
+loadPublicKey(span<const uint8_t> der, const uint8_t** end = nullptr)
+{
+  auto p = der.data();
+  EvpPkey key(d2i_PUBKEY(nullptr, &p, static_cast<long>(der.size())));
+  if (key == nullptr) {
+    NDN_THROW(Error("Failed to load public key"));
+  }
+  if (!isSupportedKeyType(key.get())) {
+    NDN_THROW(Error("Public key type is not supported for ECIES"));
+  }
+  if (end != nullptr) {
+    *end = p;
+  }
+  return key;
+}
+
+Buffer
+savePublicKey(EVP_PKEY* key)
+{
+  int len = i2d_PUBKEY(key, nullptr);
+  if (len <= 0) {
+    NDN_THROW(Error("Failed to encode public key"));
+  }
+  Buffer der(static_cast<size_t>(len));
+  auto p = der.data();
+  i2d_PUBKEY(key, &p);
+  return der;
+}
+
+SecureBuffer
+hkdfSha256(span<const uint8_t> ikm, span<const uint8_t> info, size_t length)
+{
+  SecureBuffer okm(length);
+  size_t okmLen = okm.size();
+  EvpPkeyCtx kdfCtx(EVP_PKEY_CTX_new_id(EVP_PKEY_HKDF, nullptr));
+  if (kdfCtx == nullptr ||
+      EVP_PKEY_derive_init(kdfCtx.get()) != 1 ||
+      EVP_PKEY_CTX_set_hkdf_md(kdfCtx.get(), EVP_sha256()) != 1 ||
+      EVP_PKEY_CTX_set1_hkdf_key(kdfCtx.get(), ikm.data(), static_cast<int>(ikm.size())) != 1 ||
+      EVP_PKEY_CTX_add1_hkdf_info(kdfCtx.get(), info.data(), static_cast<int>(info.size())) != 1 ||
+      EVP_PKEY_derive(kdfCtx.get(), okm.data(), &okmLen) != 1) {
+    NDN_THROW(Error("HKDF failed"));
+  }
+  return okm;
+}
+
+/**
+ * @brief Derive the key-encryption key from ECDH of @p privateKey and @p peerKey
+ */
+SecureBuffer
+deriveKek(EVP_PKEY* privateKey, EVP_PKEY* peerKey, span<const uint8_t> ephemeralPublicKey)
+{
+  EvpPkeyCtx dhCtx(EVP_PKEY_CTX_new(privateKey, nullptr));
+  size_t secretLen = 0;
+  if (dhCtx == nullptr ||
+      EVP_PKEY_derive_init(dhCtx.get()) != 1 ||
+      EVP_PKEY_derive_set_peer(dhCtx.get(), peerKey) != 1 ||
+      EVP_PKEY_derive(dhCtx.get(), nullptr, &secretLen) != 1) {
+    NDN_THROW(Error("Failed to initialize ECDH key agreement"));
+  }
+  SecureBuffer secret(secretLen);
+  if (EVP_PKEY_derive(dhCtx.get(), secret.data(), &secretLen) != 1) {
+    NDN_THROW(Error("ECDH key agreement failed"));
+  }
+  secret.shrink(secretLen);
+
+  Buffer info(reinterpret_cast<const uint8_t*>(HKDF_INFO),
+              reinterpret_cast<const uint8_t*>(HKDF_INFO) + sizeof(HKDF_INFO) - 1);
+  info.insert(info.end(), ephemeralPublicKey.begin(), ephemeralPublicKey.end());
+
+  return hkdfSha256(secret, info, AES_KEY_SIZE);
+}
+
+/**
+ * @brief Elliptic-curve key split into its group, public point, and private scalar
+ */
+struct EcKeyParts
+{
+  EcGroup group;
+  EcPoint point;
+  Bn scalar; // nullptr for a public key
+};
+
+EcKeyParts
+decomposeEcKey(EVP_PKEY* key, bool isPrivate)
+{
+  if (EVP_PKEY_base_id(key) != EVP_PKEY_EC) {
+    NDN_THROW(Error("Only EC keys can be derived for sub-datasets"));
+  }
+
+  EcKeyParts parts;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  char groupName[80];
+  size_t len = 0;
+  if (EVP_PKEY_get_utf8_string_param(key, OSSL_PKEY_PARAM_GROUP_NAME, groupName, sizeof(groupName), &len) == 1) {
+    parts.group.reset(EC_GROUP_new_by_curve_name(OBJ_sn2nid(groupName)));
+  }
+  if (parts.group != nullptr &&
+      EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, nullptr, 0, &len) == 1) {
+    Buffer point(len);
+    parts.point.reset(EC_POINT_new(parts.group.get()));
+    if (EVP_PKEY_get_octet_string_param(key, OSSL_PKEY_PARAM_PUB_KEY, point.data(), point.size(), &len) != 1 ||
+        EC_POINT_oct2point(parts.group.get(), parts.point.get(), point.data(), len, nullptr) != 1) {
+      parts.point.reset();
+    }
+  }
+  if (isPrivate) {
+    BIGNUM* scalar = nullptr;
+    EVP_PKEY_get_bn_param(key, OSSL_PKEY_PARAM_PRIV_KEY, &scalar);
+    parts.scalar.reset(scalar);
+  }
+#else
+  const EC_KEY* ecKey = EVP_PKEY_get0_EC_KEY(key);
+  parts.group.reset(EC_GROUP_dup(EC_KEY_get0_group(ecKey)));
+  if (parts.group != nullptr) {
+    parts.point.reset(EC_POINT_dup(EC_KEY_get0_public_key(ecKey), parts.group.get()));
+  }
+  if (isPrivate) {
+    parts.scalar.reset(BN_dup(EC_KEY_get0_private_key(ecKey)));
+  }
+#endif
+
+  if (parts.group == nullptr || parts.point == nullptr || (isPrivate && parts.scalar == nullptr)) {
+    NDN_THROW(Error("Failed to decompose EC key"));
+  }
+  return parts;
+}
+
+Buffer
+encodePoint(const EC_GROUP* group, const EC_POINT* point, BN_CTX* ctx)
+{
+  Buffer octets(EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, nullptr, 0, ctx));
+  if (octets.empty() ||
+      EC_POINT_point2oct(group, point, POINT_CONVERSION_UNCOMPRESSED, octets.data(), octets.size(), ctx) == 0) {
+    NDN_THROW(Error("Failed to encode EC point"));
+  }
+  return octets;
+}
+
+EvpPkey
+composeEcKey(const EcKeyParts& parts)
+{
+  EVP_PKEY* key = nullptr;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+  auto point = encodePoint(parts.group.get(), parts.point.get(), nullptr);
+  const char* groupName = OBJ_nid2sn(EC_GROUP_get_curve_name(parts.group.get()));
+
+  std::unique_ptr<OSSL_PARAM_BLD, decltype(&OSSL_PARAM_BLD_free)> builder(OSSL_PARAM_BLD_new(),
+                                                                          &OSSL_PARAM_BLD_free);
+  if (builder == nullptr || groupName == nullptr ||
+      OSSL_PARAM_BLD_push_utf8_string(builder.get(), OSSL_PKEY_PARAM_GROUP_NAME, groupName, 0) != 1 ||
+      OSSL_PARAM_BLD_push_octet_string(builder.get(), OSSL_PKEY_PARAM_PUB_KEY, point.data(), point.size()) != 1 ||
+      (parts.scalar != nullptr &&
+       OSSL_PARAM_BLD_push_BN(builder.get(), OSSL_PKEY_PARAM_PRIV_KEY, parts.scalar.get()) != 1)) {
+    NDN_THROW(Error("Failed to compose EC key"));
+  }
+  std::unique_ptr<OSSL_PARAM, decltype(&OSSL_PARAM_free)> params(OSSL_PARAM_BLD_to_param(builder.get()),
+                                                                 &OSSL_PARAM_free);
+  EvpPkeyCtx ctx(EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr));
+  if (params == nullptr || ctx == nullptr ||
+      EVP_PKEY_fromdata_init(ctx.get()) != 1 ||
+      EVP_PKEY_fromdata(ctx.get(), &key, parts.scalar != nullptr ? EVP_PKEY_KEYPAIR : EVP_PKEY_PUBLIC_KEY,
+                        params.get()) != 1) {
+    NDN_THROW(Error("Failed to compose EC key"));
+  }
+#else
+  EC_KEY* ecKey = EC_KEY_new();
+  if (ecKey == nullptr ||
+      EC_KEY_set_group(ecKey, parts.group.get()) != 1 ||
+      EC_KEY_set_public_key(ecKey, parts.point.get()) != 1 ||
+      (parts.scalar != nullptr && EC_KEY_set_private_key(ecKey, parts.scalar.get()) != 1) ||
+      (key = EVP_PKEY_new()) == nullptr ||
+      EVP_PKEY_assign_EC_KEY(key, ecKey) != 1) {
+    EVP_PKEY_free(key);
+    EC_KEY_free(ecKey);
+    NDN_THROW(Error("Failed to compose EC key"));
+  }
+#endif
+  return EvpPkey(key);
+}
+
+/**
+ * @brief Replace the key in @p parts with that of the sub-dataset @p subDataset
+ */
+void
+deriveEcKey(EcKeyParts& parts, const Name& subDataset)
+{
+  BnCtx ctx(BN_CTX_new());
+  const BIGNUM* order = EC_GROUP_get0_order(parts.group.get());
+  if (ctx == nullptr || order == nullptr) {
+    NDN_THROW(Error("Failed to initialize EC key derivation"));
+  }
+  // 128 bits more than the order, so that reducing the tweak modulo the order has negligible bias
+  auto tweakLen = static_cast<size_t>(BN_num_bytes(order)) + 16;
+
+  for (const auto& component : subDataset) {
+    // tweak = HKDF-SHA256(parent point, info || component) mod order
+    auto parentPoint = encodePoint(parts.group.get(), parts.point.get(), ctx.get());
+    Buffer info(reinterpret_cast<const uint8_t*>(DERIVE_INFO),
+                reinterpret_cast<const uint8_t*>(DERIVE_INFO) + sizeof(DERIVE_INFO) - 1);
+    const Block& wire = component.wireEncode();
+    info.insert(info.end(), wire.begin(), wire.end());
+    auto okm = hkdfSha256(parentPoint, info, tweakLen);
+
+    Bn tweak(BN_bin2bn(okm.data(), static_cast<int>(okm.size()), nullptr));
+    EcPoint tweakPoint(EC_POINT_new(parts.group.get()));
+    if (tweak == nullptr || tweakPoint == nullptr ||
+        BN_nnmod(tweak.get(), tweak.get(), order, ctx.get()) != 1 || BN_is_zero(tweak.get()) ||
+        // point = point + tweak * G
+        EC_POINT_mul(parts.group.get(), tweakPoint.get(), tweak.get(), nullptr, nullptr, ctx.get()) != 1 ||
+        EC_POINT_add(parts.group.get(), parts.point.get(), parts.point.get(), tweakPoint.get(), ctx.get()) != 1 ||
+        EC_POINT_is_at_infinity(parts.group.get(), parts.point.get()) ||
+        // scalar = scalar + tweak mod order
+        (parts.scalar != nullptr &&
+         BN_mod_add(parts.scalar.get(), parts.scalar.get(), tweak.get(), order, ctx.get()) != 1)) {
+      NDN_THROW(Error("EC key derivation failed"));
+    }
+  }
+}
+
+/**
+ * @brief AES-256 key wrap with padding (RFC 5649)
+ */
+SecureBuffer
+aesKeyWrap(span<const uint8_t> kek, span<const uint8_t> input, bool isWrap)
+{
+  if (kek.size() != AES_KEY_SIZE) {
+    NDN_THROW(Error("Invalid AES key wrap key size"));
+  }
+
+  EvpCipherCtx ctx(EVP_CIPHER_CTX_new());
+  if (ctx == nullptr) {
+    NDN_THROW(Error("Failed to create cipher context"));
+  }
+  EVP_CIPHER_CTX_set_flags(ctx.get(), EVP_CIPHER_CTX_FLAG_WRAP_ALLOW);
+
+  // wrapping adds at most 15 bytes (8-byte integrity block plus padding to 8 bytes)
+  SecureBuffer output(input.size() + 16);
+  int len = 0;
+  int finalLen = 0;
+  bool isOk = EVP_CipherInit_ex(ctx.get(), EVP_aes_256_wrap_pad(), nullptr,
+                                kek.data(), nullptr, isWrap ? 1 : 0) == 1 &&
+              EVP_CipherUpdate(ctx.get(), output.data(), &len,
+                               input.data(), static_cast<int>(input.size())) == 1 &&
+              EVP_CipherFinal_ex(ctx.get(), output.data() + len, &finalLen) == 1;
+  if (!isOk) {
+    NDN_THROW(Error(isWrap ? "AES key wrap failed" : "AES key unwrap failed (wrong key or corrupted input)"));
+  }
+
+  output.shrink(static_cast<size_t>(len + finalLen));
+  return output;
+}
+
+} // namespace
+
+class EciesPrivateKey::Impl
+{
+public:
+  EvpPkey key;
+};
+
+EciesPrivateKey::EciesPrivateKey(const security::transform::PrivateKey& key)
+  : m_impl(std::make_unique<Impl>())
+{
+  OBufferStream os;
+  key.savePkcs1(os);
+  auto der = os.buf();
+
+  const uint8_t* p = der->data();
+  m_impl->key.reset(d2i_AutoPrivateKey(nullptr, &p, static_cast<long>(der->size())));
+  OPENSSL_cleanse(der->data(), der->size());
+  if (m_impl->key == nullptr || !isSupportedKeyType(m_impl->key.get())) {
+    NDN_THROW(Error("Private key type is not supported for ECIES"));
+  }
+}
+
+EciesPrivateKey::EciesPrivateKey()
+  : m_impl(std::make_unique<Impl>())
+{
+}
+
+EciesPrivateKey::~EciesPrivateKey() = default;
+
+std::unique_ptr<EciesPrivateKey>
+EciesPrivateKey::derive(const Name& subDataset) const
+{
+  auto parts = decomposeEcKey(m_impl->key.get(), true);
+  deriveEcKey(parts, subDataset);
+
+  std::unique_ptr<EciesPrivateKey> derived(new EciesPrivateKey);
+  derived->m_impl->key = composeEcKey(parts);
+  return derived;
+}
+
+SecureBuffer
+EciesPrivateKey::unwrap(span<const uint8_t> wrapped) const
+{
+  const uint8_t* end = nullptr;
+  auto ephemeralKey = loadPublicKey(wrapped, &end);
+  auto ephemeralKeyLen = static_cast<size_t>(end - wrapped.data());
+
+  auto kek = deriveKek(m_impl->key.get(), ephemeralKey.get(), wrapped.first(ephemeralKeyLen));
+  return aesKeyWrap(kek, wrapped.subspan(ephemeralKeyLen), false);
+}
+
+bool
+isEciesKey(span<const uint8_t> publicKey)
+{
+  auto p = publicKey.data();
+  EvpPkey key(d2i_PUBKEY(nullptr, &p, static_cast<long>(publicKey.size())));
+  return key != nullptr && isSupportedKeyType(key.get());
+}
+
+ConstBufferPtr
+eciesWrap(span<const uint8_t> recipientPublicKey, span<const uint8_t> key)
+{
+  auto recipientKey = loadPublicKey(recipientPublicKey);
+
+  // ephemeral key on the same curve as the recipient key
+  EvpPkeyCtx genCtx(EVP_PKEY_CTX_new(recipientKey.get(), nullptr));
+  EVP_PKEY* ephemeral = nullptr;
+  if (genCtx == nullptr ||
+      EVP_PKEY_keygen_init(genCtx.get()) != 1 ||
+      EVP_PKEY_keygen(genCtx.get(), &ephemeral) != 1) {
+    NDN_THROW(Error("Failed to generate ephemeral key"));
+  }
+  EvpPkey ephemeralKey(ephemeral);
+  auto ephemeralPublicKey = savePublicKey(ephemeralKey.get());
+
+  auto kek = deriveKek(ephemeralKey.get(), recipientKey.get(), ephemeralPublicKey);
+  auto wrappedKey = aesKeyWrap(kek, key, true);
+
+  auto output = std::make_shared<Buffer>(std::move(ephemeralPublicKey));
+  output->insert(output->end(), wrappedKey.begin(), wrappedKey.end());
+  return output;
+}
+
+ConstBufferPtr
+deriveEciesPublicKey(span<const uint8_t> publicKey, const Name& subDataset)
+{
+  auto key = loadPublicKey(publicKey);
+  auto parts = decomposeEcKey(key.get(), false);
+  deriveEcKey(parts, subDataset);
+  return std::make_shared<Buffer>(savePublicKey(composeEcKey(parts).get()));
+}
+
+ConstBufferPtr
+aesWrapKey(span<const uint8_t> kek, span<const uint8_t> key)
+{
+  auto wrapped = aesKeyWrap(kek, key, true);
+  return std::make_shared<Buffer>(wrapped.begin(), wrapped.end());
+}
+
+SecureBuffer
+aesUnwrapKey(span<const uint8_t> kek, span<const uint8_t> wrapped)
+{
+  return aesKeyWrap(kek, wrapped, false);
+}
+
+} // namespace ndn::nac::detail
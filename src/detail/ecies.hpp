@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_ECIES_HPP
+#define NDN_NAC_DETAIL_ECIES_HPP
+
+#include "common.hpp"
+#include "secure-memory.hpp"
+
+#include <ndn-cxx/security/transform/private-key.hpp>
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Hybrid key wrapping for elliptic-curve KEK/KDK and member keys
+ *
+ * A key is wrapped for an EC recipient public key as follows:
+ *
+ *  1. an ephemeral key pair is generated on the recipient's curve;
+ *  2. the ECDH shared secret of the ephemeral private key and the recipient public key is
+ *     expanded with HKDF-SHA256 into a 256-bit key-encryption key (the info string binds the
+ *     ephemeral public key);
+ *  3. the key is wrapped with AES-256 key wrap with padding (RFC 5649).
+ *
+ * The result is the ephemeral public key (DER-encoded SubjectPublicKeyInfo) immediately
+ * followed by the wrapped key.  It takes the place of the RSA-OAEP ciphertext in the
+ * EncryptedContent element, the scheme being determined by the type of the recipient key.
+ */
+class EciesPrivateKey : noncopyable
+{
+public:
+  /**
+   * @brief Create from an EC private key
+   * @throw Error @p key is of an unsupported type
+   */
+  explicit
+  EciesPrivateKey(const security::transform::PrivateKey& key);
+
+  ~EciesPrivateKey();
+
+  /**
+   * @brief Unwrap a key wrapped by eciesWrap()
+   * @throw Error @p wrapped is malformed or cannot be unwrapped with this key
+   */
+  SecureBuffer
+  unwrap(span<const uint8_t> wrapped) const;
+
+  /**
+   * @brief Derive the private key of sub-dataset @p subDataset, see deriveEciesPublicKey()
+   * @throw Error this is not an EC key
+   */
+  std::unique_ptr<EciesPrivateKey>
+  derive(const Name& subDataset) const;
+
+private:
+  EciesPrivateKey();
+
+private:
+  class Impl;
+  unique_ptr<Impl> m_impl;
+};
+
+/**
+ * @brief Check whether @p publicKey (DER-encoded SubjectPublicKeyInfo) can be used with eciesWrap()
+ */
+bool
+isEciesKey(span<const uint8_t> publicKey);
+
+/**
+ * @brief Wrap @p key for the holder of @p recipientPublicKey
+ * @param recipientPublicKey DER-encoded SubjectPublicKeyInfo of an EC key
+ * @throw Error the recipient key is malformed or of an unsupported type
+ */
+ConstBufferPtr
+eciesWrap(span<const uint8_t> recipientPublicKey, span<const uint8_t> key);
+
+/**
+ * @brief Derive the public key of sub-dataset @p subDataset from the EC public key @p publicKey
+ *
+ * Each name component `c` of @p subDataset in turn replaces a key with public point `P` and
+ * private scalar `d` by the key with public point `P + t*G` and private scalar `d + t mod n`,
+ * where `t` is HKDF-SHA256 of the uncompressed encoding of `P` (no salt, info =
+ * `"NDN-NAC EC key derivation"` followed by the TLV encoding of `c`), reduced modulo the group
+ * order `n`.  The holder of the private key of a dataset can therefore derive the private key
+ * of any of its sub-datasets (see EciesPrivateKey::derive()), while producers derive the
+ * public key from the KEK alone.
+ *
+ * @return DER-encoded SubjectPublicKeyInfo of the derived key
+ * @throw Error @p publicKey is not an EC key
+ */
+ConstBufferPtr
+deriveEciesPublicKey(span<const uint8_t> publicKey, const Name& subDataset);
+
+/**
+ * @brief Wrap @p key with the 256-bit key-encryption key @p kek, using AES key wrap with
+ *        padding (RFC 5649)
+ * @throw Error invalid key size
+ */
+ConstBufferPtr
+aesWrapKey(span<const uint8_t> kek, span<const uint8_t> key);
+
+/**
+ * @brief Unwrap a key wrapped by aesWrapKey()
+ * @throw Error @p wrapped is malformed or was not wrapped with @p kek
+ */
+SecureBuffer
+aesUnwrapKey(span<const uint8_t> kek, span<const uint8_t> wrapped);
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_ECIES_HPP
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/key-tree.hpp"
+
+#include <ndn-cxx/util/exception.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+namespace ndn::nac::detail {
+
+KeyTree::KeyTree() = default;
+
+KeyTree::~KeyTree() = default;
+
+const KeyTree::Node&
+KeyTree::addLeaf(KeyTreeChanges& changes)
+{
+  size_t slot = 0;
+  if (!m_freeSlots.empty()) {
+    slot = *m_freeSlots.begin();
+    m_freeSlots.erase(m_freeSlots.begin());
+  }
+  else {
+    if (m_root != nullptr && m_nSlots == (size_t(1) << m_height)) {
+      // all slots are taken, the current root becomes the left child of a new root
+      auto root = makeNode(nullptr, changes);
+      m_root->parent = root.get();
+      changes.wrapping.insert(m_root->id);
+      root->children[0] = std::move(m_root);
+      m_root = std::move(root);
+      ++m_height;
+    }
+    slot = m_nSlots++;
+  }
+
+  if (m_root == nullptr) {
+    m_root = makeNode(nullptr, changes);
+  }
+  Node* node = m_root.get();
+  for (size_t level = m_height; level > 0; --level) {
+    auto& child = node->children[(slot >> (level - 1)) & 1];
+    if (child == nullptr) {
+      child = makeNode(node, changes);
+    }
+    node = child.get();
+  }
+
+  node->slot = slot;
+  m_leaves[slot] = node;
+  return *node;
+}
+
+void
+KeyTree::removeLeaf(size_t slot, KeyTreeChanges& changes)
+{
+  auto leaf = m_leaves.find(slot);
+  if (leaf == m_leaves.end()) {
+    NDN_THROW(std::out_of_range("Slot " + std::to_string(slot) + " of the key tree is not taken"));
+  }
+  Node* node = leaf->second;
+  m_leaves.erase(leaf);
+  m_freeSlots.insert(slot);
+
+  // delete the leaf and the ancestors that no longer have any leaves below them
+  while (node->children[0] == nullptr && node->children[1] == nullptr) {
+    changes.removed.insert(node->id);
+    changes.wrapping.erase(node->id);
+    m_nodes.erase(node->id);
+
+    Node* parent = node->parent;
+    if (parent == nullptr) {
+      m_root.reset();
+      m_height = 0;
+      m_nSlots = 0;
+      m_freeSlots.clear();
+      return;
+    }
+    auto& child = parent->children[0].get() == node ? parent->children[0] : parent->children[1];
+    child.reset();
+    node = parent;
+  }
+
+  // the removed leaf knew the keys of all remaining ancestors
+  for (; node != nullptr; node = node->parent) {
+    rekey(*node);
+    if (node->parent != nullptr) {
+      changes.wrapping.insert(node->id);
+    }
+    for (const auto& child : node->children) {
+      if (child != nullptr) {
+        changes.wrapping.insert(child->id);
+      }
+    }
+  }
+}
+
+const KeyTree::Node*
+KeyTree::findNode(uint64_t id) const
+{
+  auto node = m_nodes.find(id);
+  return node == m_nodes.end() ? nullptr : node->second;
+}
+
+std::unique_ptr<KeyTree::Node>
+KeyTree::makeNode(Node* parent, KeyTreeChanges& changes)
+{
+  auto node = std::make_unique<Node>();
+  node->id = m_nextId++;
+  node->key = SecureBuffer(AES_KEY_SIZE);
+  random::generateSecureBytes(node->key);
+  node->parent = parent;
+  m_nodes[node->id] = node.get();
+  if (parent != nullptr) {
+    changes.wrapping.insert(node->id);
+  }
+  return node;
+}
+
+void
+KeyTree::rekey(Node& node)
+{
+  ++node.version;
+  random::generateSecureBytes(node.key);
+}
+
+} // namespace ndn::nac::detail
@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_KEY_TREE_HPP
+#define NDN_NAC_DETAIL_KEY_TREE_HPP
+
+#include "common.hpp"
+#include "secure-memory.hpp"
+
+#include <array>
+#include <map>
+#include <set>
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Nodes of a KeyTree affected by one or more operations
+ */
+struct KeyTreeChanges
+{
+  /// nodes whose own key or whose parent's key changed, i.e., that need to wrap their parent again
+  std::set<uint64_t> wrapping;
+  /// deleted nodes
+  std::set<uint64_t> removed;
+};
+
+/**
+ * @brief Binary tree of symmetric node keys for a logical key hierarchy (LKH)
+ *
+ * Every member occupies a leaf slot, and all leaves are at the same depth.  Nodes are created
+ * when the first leaf below them is added and deleted with the last one.  When all slots are
+ * taken, the tree grows by one level: the current root becomes the left child of a new root.
+ *
+ * The tree only maintains the keys; publishing them is up to the user.  Each non-root node
+ * wraps the key of its parent, so the user needs to (re)publish that wrapped key for every
+ * node reported in KeyTreeChanges::wrapping, and withdraw it for every node in
+ * KeyTreeChanges::removed.  Node IDs are never reused, and a node gets a new version
+ * whenever its key is replaced.
+ */
+class KeyTree : noncopyable
+{
+public:
+  struct Node
+  {
+    uint64_t id;
+    uint64_t version = 1;
+    SecureBuffer key;
+    size_t slot = 0; // only meaningful for leaves
+    Node* parent = nullptr;
+    std::array<std::unique_ptr<Node>, 2> children;
+  };
+
+public:
+  KeyTree();
+
+  ~KeyTree();
+
+  /**
+   * @brief Add a leaf in the lowest free slot
+   *
+   * Only the nodes newly created on the path of the leaf are reported.  Keys of existing
+   * nodes are kept, i.e., a new member can decrypt the KDK published before it was added.
+   */
+  const Node&
+  addLeaf(KeyTreeChanges& changes);
+
+  /**
+   * @brief Remove the leaf in @p slot and replace the keys of all its remaining ancestors
+   * @throw std::out_of_range the slot is not taken
+   */
+  void
+  removeLeaf(size_t slot, KeyTreeChanges& changes);
+
+  /**
+   * @brief Find a node by ID
+   * @return the node, or nullptr if it does not exist (anymore)
+   */
+  const Node*
+  findNode(uint64_t id) const;
+
+  const Node&
+  getLeaf(size_t slot) const
+  {
+    return *m_leaves.at(slot);
+  }
+
+  /**
+   * @return the root, or nullptr if the tree is empty
+   */
+  const Node*
+  getRoot() const
+  {
+    return m_root.get();
+  }
+
+  size_t
+  getNLeaves() const
+  {
+    return m_leaves.size();
+  }
+
+  /**
+   * @brief Get the depth of the leaves
+   */
+  size_t
+  getHeight() const
+  {
+    return m_height;
+  }
+
+private:
+  std::unique_ptr<Node>
+  makeNode(Node* parent, KeyTreeChanges& changes);
+
+  static void
+  rekey(Node& node);
+
+private:
+  std::unique_ptr<Node> m_root;
+  size_t m_height = 0;
+  size_t m_nSlots = 0; // slots ever used at the current height
+  std::set<size_t> m_freeSlots;
+  std::map<size_t, Node*> m_leaves;
+  std::map<uint64_t, Node*> m_nodes;
+  uint64_t m_nextId = 0;
+};
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_KEY_TREE_HPP
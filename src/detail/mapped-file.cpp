@@ -0,0 +1,70 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/mapped-file.hpp"
+
+#include <ndn-cxx/util/exception.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ndn::nac::detail {
+
+MappedFile::MappedFile(const std::string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    NDN_THROW(std::runtime_error("Cannot open '" + path + "': " + std::strerror(errno)));
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    int error = errno;
+    ::close(fd);
+    NDN_THROW(std::runtime_error("Cannot stat '" + path + "': " + std::strerror(error)));
+  }
+
+  // an empty file cannot be mapped, and has no contents to map anyway
+  m_size = static_cast<size_t>(st.st_size);
+  if (m_size > 0) {
+    void* addr = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      int error = errno;
+      ::close(fd);
+      NDN_THROW(std::runtime_error("Cannot map '" + path + "': " + std::strerror(error)));
+    }
+    m_data = static_cast<const uint8_t*>(addr);
+  }
+  // the mapping stays valid after the descriptor is closed
+  ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (m_data != nullptr) {
+    ::munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+}
+
+} // namespace ndn::nac::detail
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_MAPPED_FILE_HPP
+#define NDN_NAC_DETAIL_MAPPED_FILE_HPP
+
+#include "common.hpp"
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Read-only memory mapping of a whole file
+ *
+ * Pages are loaded by the operating system when they are first accessed, and are shared with
+ * other processes that map the same file.  The file must not be modified while it is mapped:
+ * accessing a page beyond the end of a truncated file raises SIGBUS, and other changes show up
+ * in the mapping.  A file is updated by writing a new file and renaming it over the old one, so
+ * that the mapping keeps the old contents until it is unmapped.
+ */
+class MappedFile : noncopyable
+{
+public:
+  /**
+   * @throw std::runtime_error the file cannot be opened or mapped
+   */
+  explicit
+  MappedFile(const std::string& path);
+
+  ~MappedFile();
+
+  span<const uint8_t>
+  getContents() const
+  {
+    return {m_data, m_size};
+  }
+
+private:
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_MAPPED_FILE_HPP
@@ -0,0 +1,227 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/merkle-batch.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/util/exception.hpp>
+#include <ndn-cxx/util/sha256.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace ndn::nac::detail {
+
+using Hash = std::array<uint8_t, util::Sha256::DIGEST_SIZE>;
+
+static Hash
+finalize(util::Sha256& sha)
+{
+  auto digest = sha.computeDigest();
+  Hash hash;
+  std::copy(digest->begin(), digest->end(), hash.begin());
+  return hash;
+}
+
+static Hash
+hashLeaf(const InputBuffers& signedRanges)
+{
+  util::Sha256 sha;
+  const uint8_t prefix = 0x00;
+  sha.update({&prefix, 1});
+  for (const auto& range : signedRanges) {
+    sha.update(range);
+  }
+  return finalize(sha);
+}
+
+static Hash
+hashNode(const Hash& left, const Hash& right)
+{
+  util::Sha256 sha;
+  const uint8_t prefix = 0x01;
+  sha.update({&prefix, 1});
+  sha.update(left);
+  sha.update(right);
+  return finalize(sha);
+}
+
+// Bottom-up construction, where an unpaired last node is promoted to the next level, yields
+// the same tree as the recursive definition of RFC 9162, in which the left subtree of every
+// node is the largest perfect tree that fits.
+static std::vector<std::vector<Hash>>
+buildTree(std::vector<Hash> leaves)
+{
+  std::vector<std::vector<Hash>> levels;
+  levels.push_back(std::move(leaves));
+  while (levels.back().size() > 1) {
+    const auto& level = levels.back();
+    std::vector<Hash> next;
+    next.reserve((level.size() + 1) / 2);
+    for (size_t i = 0; i + 1 < level.size(); i += 2) {
+      next.push_back(hashNode(level[i], level[i + 1]));
+    }
+    if (level.size() % 2 == 1) {
+      next.push_back(level.back());
+    }
+    levels.push_back(std::move(next));
+  }
+  return levels;
+}
+
+static std::vector<Hash>
+getInclusionProof(const std::vector<std::vector<Hash>>& levels, size_t index)
+{
+  std::vector<Hash> proof;
+  for (size_t i = 0; i + 1 < levels.size(); ++i, index /= 2) {
+    auto sibling = index ^ 1;
+    if (sibling < levels[i].size()) {
+      proof.push_back(levels[i][sibling]);
+    }
+  }
+  return proof;
+}
+
+// RFC 9162, section 2.1.3.2
+static std::optional<Hash>
+computeRootFromProof(Hash hash, uint64_t index, uint64_t treeSize, const std::vector<Hash>& proof)
+{
+  if (index >= treeSize) {
+    return std::nullopt;
+  }
+  uint64_t fn = index;
+  uint64_t sn = treeSize - 1;
+  for (const auto& sibling : proof) {
+    if (sn == 0) {
+      return std::nullopt;
+    }
+    if ((fn & 1) == 1 || fn == sn) {
+      hash = hashNode(sibling, hash);
+      while ((fn & 1) == 0 && fn != 0) {
+        fn >>= 1;
+        sn >>= 1;
+      }
+    }
+    else {
+      hash = hashNode(hash, sibling);
+    }
+    fn >>= 1;
+    sn >>= 1;
+  }
+  if (sn != 0) {
+    return std::nullopt;
+  }
+  return hash;
+}
+
+void
+signBatch(const std::vector<Data*>& packets, KeyChain& keyChain, const SigningInfo& signingInfo)
+{
+  if (packets.empty()) {
+    return;
+  }
+  if (packets.size() == 1) {
+    keyChain.sign(*packets.front(), signingInfo);
+    return;
+  }
+
+  Name prefix = packets.front()->getName();
+  std::vector<EncodingBuffer> encoders(packets.size());
+  std::vector<Hash> leaves;
+  leaves.reserve(packets.size());
+  for (size_t i = 0; i < packets.size(); ++i) {
+    auto& data = *packets[i];
+    data.setSignatureInfo(SignatureInfo(static_cast<tlv::SignatureTypeValue>(tlv::SignatureSha256MerkleBatch)));
+    data.wireEncode(encoders[i], true);
+    leaves.push_back(hashLeaf({{encoders[i].data(), encoders[i].size()}}));
+
+    const auto& name = data.getName();
+    size_t common = 0;
+    while (common < prefix.size() && common < name.size() && prefix[common] == name[common]) {
+      ++common;
+    }
+    prefix = prefix.getPrefix(common);
+  }
+
+  auto levels = buildTree(std::move(leaves));
+  const auto& root = levels.back().front();
+
+  Data rootData(prefix.append(BATCH).append(name::Component(span<const uint8_t>(root))));
+  rootData.setContent(root);
+  keyChain.sign(rootData, signingInfo);
+
+  for (size_t i = 0; i < packets.size(); ++i) {
+    Block value(tlv::SignatureValue);
+    value.push_back(rootData.wireEncode());
+    value.push_back(makeNonNegativeIntegerBlock(tlv::BatchLeafIndex, i));
+    value.push_back(makeNonNegativeIntegerBlock(tlv::BatchTreeSize, packets.size()));
+    for (const auto& hash : getInclusionProof(levels, i)) {
+      value.push_back(makeBinaryBlock(tlv::BatchProofHash, hash));
+    }
+    value.encode();
+    packets[i]->wireEncode(encoders[i], value.value_bytes());
+  }
+}
+
+Data
+verifyBatchProof(const Data& data)
+{
+  if (!isBatchSigned(data)) {
+    NDN_THROW(Error("Data is not batch-signed"));
+  }
+
+  try {
+    Block value = data.getSignatureValue();
+    value.parse();
+    const auto& elements = value.elements();
+    if (elements.size() < 3 || elements[0].type() != tlv::Data ||
+        elements[1].type() != tlv::BatchLeafIndex || elements[2].type() != tlv::BatchTreeSize) {
+      NDN_THROW(Error("Malformed batch signature"));
+    }
+
+    Data rootData(elements[0]);
+    // the trust policy is applied to the name of the batch root, which must cover the packet
+    const auto& rootName = rootData.getName();
+    if (rootName.size() < 2 || rootName.get(-2) != BATCH || !rootName.getPrefix(-2).isPrefixOf(data.getName())) {
+      NDN_THROW(Error("Batch root " + rootName.toUri() + " does not cover " + data.getName().toUri()));
+    }
+
+    auto index = readNonNegativeInteger(elements[1]);
+    auto treeSize = readNonNegativeInteger(elements[2]);
+    std::vector<Hash> proof;
+    for (auto it = elements.begin() + 3; it != elements.end(); ++it) {
+      if (it->type() != tlv::BatchProofHash || it->value_size() != std::tuple_size_v<Hash>) {
+        NDN_THROW(Error("Malformed batch signature"));
+      }
+      std::copy(it->value_begin(), it->value_end(), proof.emplace_back().begin());
+    }
+
+    auto root = computeRootFromProof(hashLeaf(data.extractSignedRanges()), index, treeSize, proof);
+    const auto& expected = rootData.getContent();
+    if (!root || !std::equal(root->begin(), root->end(), expected.value_begin(), expected.value_end())) {
+      NDN_THROW(Error("Inclusion proof does not match the batch root"));
+    }
+    return rootData;
+  }
+  catch (const tlv::Error& e) {
+    NDN_THROW_NESTED(Error("Malformed batch signature: " + std::string(e.what())));
+  }
+}
+
+} // namespace ndn::nac::detail
@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_MERKLE_BATCH_HPP
+#define NDN_NAC_DETAIL_MERKLE_BATCH_HPP
+
+#include "common.hpp"
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Sign @p packets with a single signature over the root of a Merkle tree
+ *
+ * The leaves of the tree are the signed portions of the packets, whose SignatureInfo is set to
+ * tlv::SignatureSha256MerkleBatch, and the tree is built as in RFC 9162 (Certificate
+ * Transparency): leaf hash `SHA-256(0x00 || leaf)` and node hash `SHA-256(0x01 || left || right)`.
+ * The root is the content of a batch root Data, named after the longest common prefix of the
+ * packets followed by `BATCH/<root>`, which is signed according to @p signingInfo.  The
+ * SignatureValue of each packet consists of the batch root Data and the inclusion proof of the
+ * packet.
+ *
+ * A batch of a single packet is signed directly according to @p signingInfo.
+ *
+ * @throw std::runtime_error signing failed
+ */
+void
+signBatch(const std::vector<Data*>& packets, KeyChain& keyChain, const SigningInfo& signingInfo);
+
+/**
+ * @brief Check whether @p data has been signed with signBatch()
+ */
+inline bool
+isBatchSigned(const Data& data)
+{
+  return data.getSignatureType() == static_cast<int32_t>(tlv::SignatureSha256MerkleBatch);
+}
+
+/**
+ * @brief Verify the inclusion proof of batch-signed @p data
+ *
+ * Validating the returned batch root Data completes the validation of @p data.
+ *
+ * @return the batch root Data
+ * @throw Error the SignatureValue is malformed, the batch root does not cover the name of
+ *              @p data, or the proof does not lead to the root
+ */
+Data
+verifyBatchProof(const Data& data);
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_MERKLE_BATCH_HPP
@@ -0,0 +1,58 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_PROBES_HPP
+#define NDN_NAC_DETAIL_PROBES_HPP
+
+#include "detail/config.hpp"
+
+#include <ndn-cxx/name.hpp>
+
+/**
+ * @file
+ * @brief Static tracepoints (USDT probes) on the NAC hot paths
+ *
+ * When the library is configured with `--with-usdt`, each NAC_PROBE() site becomes a USDT
+ * probe `ndn_nac:<name>` that can be attached to with perf, bpftrace, or SystemTap; an
+ * unattached probe is a single nop instruction.  Otherwise, NAC_PROBE() expands to nothing
+ * and its arguments are not evaluated.
+ *
+ * Names (CK, KDK, member key) are passed as 64-bit hashes computed by probeHash(), so that
+ * events of the same key can be correlated without copying names out of the process.
+ * See tools/bpftrace/nac-latency.bt for an example.
+ */
+
+#ifdef NAC_HAVE_USDT
+#include <sys/sdt.h>
+#define NAC_PROBE(name, ...) STAP_PROBEV(ndn_nac, name, __VA_ARGS__)
+#else
+#define NAC_PROBE(name, ...) do {} while (false)
+#endif
+
+namespace ndn::nac::detail {
+
+inline uint64_t
+probeHash(const Name& name)
+{
+  return std::hash<Name>{}(name);
+}
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_PROBES_HPP
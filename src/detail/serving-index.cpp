@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/serving-index.hpp"
+
+#include <ndn-cxx/security/signing-helpers.hpp>
+
+namespace ndn::nac::detail {
+
+void
+ServingIndex::insert(shared_ptr<const Data> data)
+{
+  // Face::put() sends the encoding of a packet as is, without copying it, so a packet that is
+  // already encoded costs no more than the lookup; compute the full name once as well
+  BOOST_ASSERT(data->hasWire());
+  data->getFullName();
+
+  m_ordered[data->getName()] = data;
+  m_byName[data->getName()] = std::move(data);
+}
+
+shared_ptr<const Data>
+ServingIndex::erase(const Name& name)
+{
+  auto it = m_byName.find(name);
+  if (it == m_byName.end()) {
+    return nullptr;
+  }
+  auto data = std::move(it->second);
+  m_byName.erase(it);
+  m_ordered.erase(name);
+  return data;
+}
+
+shared_ptr<const Data>
+ServingIndex::find(const Interest& interest) const
+{
+  const auto& name = interest.getName();
+
+  if (!interest.getCanBePrefix()) {
+    if (!name.empty() && name[-1].isImplicitSha256Digest()) {
+      auto it = m_byName.find(name.getPrefix(-1));
+      if (it != m_byName.end() && it->second->getFullName() == name) {
+        return it->second;
+      }
+      return nullptr;
+    }
+    auto it = m_byName.find(name);
+    return it == m_byName.end() ? nullptr : it->second;
+  }
+
+  // the last name under the prefix, i.e., the one just before its successor
+  auto it = m_ordered.lower_bound(name.getSuccessor());
+  if (it == m_ordered.begin()) {
+    return nullptr;
+  }
+  --it;
+  if (!name.isPrefixOf(it->first)) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void
+PublishedPackets::publish(const Data& data)
+{
+  // m_ims keys packets by full name, so it would keep a previous packet with the same name
+  unpublish(data.getName());
+
+  auto stored = std::make_shared<Data>(data);
+  m_ims.insert(*stored);
+  m_nBytes.increment(static_cast<int64_t>(stored->wireEncode().size()));
+  m_index.insert(std::move(stored));
+}
+
+void
+PublishedPackets::unpublish(const Name& name)
+{
+  auto data = m_index.erase(name);
+  if (data == nullptr) {
+    return;
+  }
+  m_nBytes.decrement(static_cast<int64_t>(data->wireEncode().size()));
+  m_ims.erase(data->getFullName(), false);
+}
+
+Data
+makeNack(const Interest& interest, KeyChain& keyChain)
+{
+  Data nack(interest.getName());
+  nack.setContentType(tlv::ContentType_Nack);
+  nack.setFreshnessPeriod(NACK_FRESHNESS_PERIOD);
+  keyChain.sign(nack, signingWithSha256());
+  return nack;
+}
+
+} // namespace ndn::nac::detail
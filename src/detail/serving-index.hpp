@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_SERVING_INDEX_HPP
+#define NDN_NAC_DETAIL_SERVING_INDEX_HPP
+
+#include "common.hpp"
+#include "metrics.hpp"
+
+#include <map>
+#include <unordered_map>
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Lookup structure for the packets published by AccessManager and Encryptor
+ *
+ * Interests that cannot be a prefix, e.g., for a KDK, are answered with a single hash table
+ * lookup of the exact name.  Interests that can be a prefix, e.g., `<access-prefix>/KEK`,
+ * are answered with the packet that has the greatest name under the prefix, i.e., its latest
+ * version.  There is at most one packet per name, and freshness is not taken into account,
+ * as published packets stay valid until they are erased.
+ *
+ * Packets must be signed (i.e., encoded) before they are inserted.  They are kept, and handed
+ * to Face::put(), together with their encoding, which the Face passes to the transport without
+ * re-encoding or copying it, unless NDNLPv2 fields have to be added.
+ */
+class ServingIndex : noncopyable
+{
+public:
+  /**
+   * @brief Add @p data, replacing any packet with the same name
+   * @pre @p data has been signed, i.e., `data->hasWire()`
+   */
+  void
+  insert(shared_ptr<const Data> data);
+
+  /**
+   * @brief Remove the packet named @p name, if any
+   * @return the removed packet, or nullptr if there was none
+   */
+  shared_ptr<const Data>
+  erase(const Name& name);
+
+  /**
+   * @brief Find the packet to answer @p interest with
+   * @return the packet, or nullptr if there is none
+   */
+  shared_ptr<const Data>
+  find(const Interest& interest) const;
+
+  size_t
+  size() const
+  {
+    return m_byName.size();
+  }
+
+private:
+  std::unordered_map<Name, shared_ptr<const Data>> m_byName;
+  std::map<Name, shared_ptr<const Data>> m_ordered; // for Interests that can be a prefix
+};
+
+/**
+ * @brief Packets published by AccessManager or Encryptor
+ *
+ * Keeps in sync the InMemoryStorage through which the owner lists its published packets and the
+ * ServingIndex through which it answers Interests.  Both hold the same packet, whose encoding is
+ * thus stored once, and the size of the stored encodings is accounted in a Gauge.
+ */
+class PublishedPackets : noncopyable
+{
+public:
+  PublishedPackets(InMemoryStorage& ims, Gauge& nBytes)
+    : m_ims(ims)
+    , m_nBytes(nBytes)
+  {
+  }
+
+  /**
+   * @brief Publish @p data, replacing any packet with the same name
+   * @pre @p data has been signed
+   */
+  void
+  publish(const Data& data);
+
+  /**
+   * @brief Withdraw the packet named @p name, if any
+   */
+  void
+  unpublish(const Name& name);
+
+  shared_ptr<const Data>
+  find(const Interest& interest) const
+  {
+    return m_index.find(interest);
+  }
+
+private:
+  InMemoryStorage& m_ims;
+  Gauge& m_nBytes;
+  ServingIndex m_index;
+};
+
+/**
+ * @brief Create an application-level NACK for @p interest, i.e., a Data packet with
+ *        ContentType NACK and a short FreshnessPeriod
+ *
+ * The NACK is signed with a SHA-256 digest, so that answering a flood of Interests for
+ * non-existent packets does not cost a signature each.  As for a network NACK, a consumer
+ * cannot authenticate it, and can only stop waiting for the Interest to time out.
+ */
+Data
+makeNack(const Interest& interest, KeyChain& keyChain);
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_SERVING_INDEX_HPP
@@ -0,0 +1,129 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "detail/validation-cache.hpp"
+#include "detail/merkle-batch.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+#include <algorithm>
+
+namespace ndn::nac::detail {
+
+NDN_LOG_INIT(nac.ValidationCache);
+
+static bool
+isRemembered(std::map<Name, ValidationCache::Expiry>& entries, const Name& key,
+             ValidationCache::Expiry now)
+{
+  auto it = entries.find(key);
+  if (it == entries.end()) {
+    return false;
+  }
+  if (it->second <= now) {
+    entries.erase(it);
+    return false;
+  }
+  return true;
+}
+
+static void
+remember(std::map<Name, ValidationCache::Expiry>& entries, const Name& key,
+         ValidationCache::Expiry now, const ValidationCache::State& state)
+{
+  if (entries.size() >= state.capacity && entries.count(key) == 0) {
+    for (auto it = entries.begin(); it != entries.end();) {
+      it = it->second <= now ? entries.erase(it) : std::next(it);
+    }
+    if (entries.size() >= state.capacity) {
+      // all entries are fresh, drop the one that expires first
+      auto oldest = std::min_element(entries.begin(), entries.end(),
+                                     [] (const auto& a, const auto& b) { return a.second < b.second; });
+      entries.erase(oldest);
+    }
+  }
+  entries[key] = now + state.lifetime;
+}
+
+ValidationCache::ValidationCache(Validator& validator, Counter& nHits, Counter& nValidations,
+                                 size_t capacity, time::nanoseconds lifetime)
+  : m_validator(validator)
+  , m_nHits(nHits)
+  , m_nValidations(nValidations)
+  , m_state(std::make_shared<State>(State{std::max<size_t>(capacity, 1), lifetime, {}}))
+{
+}
+
+void
+ValidationCache::validate(const Data& data,
+                          const security::DataValidationSuccessCallback& onSuccess,
+                          const security::DataValidationFailureCallback& onFailure)
+{
+  auto now = time::steady_clock::now();
+  const Name& fullName = data.getFullName();
+  if (isRemembered(m_state->packets, fullName, now)) {
+    NDN_LOG_TRACE(fullName << " has already been validated");
+    m_nHits.increment();
+    return onSuccess(data);
+  }
+
+  if (isBatchSigned(data)) {
+    // the batch root is validated (or found in the cache) on behalf of every packet of the batch
+    std::optional<Data> rootData;
+    try {
+      rootData = verifyBatchProof(data);
+    }
+    catch (const std::runtime_error& e) {
+      NDN_LOG_DEBUG("Invalid batch signature of " << data.getName() << ": " << e.what());
+      return onFailure(data, security::ValidationError(security::ValidationError::INVALID_SIGNATURE,
+                                                       "Invalid batch signature of " + data.getName().toUri()));
+    }
+    return validate(*rootData,
+                    [data, onSuccess] (const Data&) { onSuccess(data); },
+                    [data, onFailure] (const Data&, const security::ValidationError& error) {
+                      onFailure(data, error);
+                    });
+  }
+
+  m_nValidations.increment();
+  m_validator.validate(data,
+    [weakState = std::weak_ptr<State>(m_state), onSuccess] (const Data& validData) {
+      auto state = weakState.lock();
+      if (state == nullptr) {
+        return;
+      }
+      remember(state->packets, validData.getFullName(), time::steady_clock::now(), *state);
+      onSuccess(validData);
+    },
+    [weakState = std::weak_ptr<State>(m_state), onFailure] (const Data& invalidData,
+                                                             const security::ValidationError& error) {
+      if (weakState.expired()) {
+        return;
+      }
+      onFailure(invalidData, error);
+    });
+}
+
+void
+ValidationCache::clear()
+{
+  m_state->packets.clear();
+}
+
+} // namespace ndn::nac::detail
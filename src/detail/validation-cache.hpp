@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_DETAIL_VALIDATION_CACHE_HPP
+#define NDN_NAC_DETAIL_VALIDATION_CACHE_HPP
+
+#include "common.hpp"
+#include "metrics.hpp"
+
+#include <map>
+
+namespace ndn::nac::detail {
+
+/**
+ * @brief Front-end of a Validator that remembers successful validations
+ *
+ * A Data packet whose full name, which covers its signature, has already been validated is
+ * accepted right away.  All other packets are passed to Validator::validate(), so that the
+ * trust policy checks every packet name against its signer; the certificate chain of a signer
+ * that has already been validated comes from the Validator's cache of verified certificates.
+ *
+ * Packets signed with detail::signBatch() are accepted once their inclusion proof leads to the
+ * root of their batch and the batch root Data itself is accepted as above, so that the
+ * signature of a batch is validated only once.  The batch root is named under the common
+ * prefix of the packets it covers, and the trust policy is applied to that name.
+ *
+ * Callbacks of a validation still in progress are not invoked once the cache is destroyed.
+ */
+class ValidationCache : noncopyable
+{
+public:
+  /**
+   * @param validator    the Validator to use for packets not in the cache
+   * @param nHits        incremented for every packet accepted without Validator::validate()
+   * @param nValidations incremented for every packet passed to Validator::validate()
+   * @param capacity     maximum number of remembered packets
+   * @param lifetime     how long a successful validation is remembered
+   */
+  ValidationCache(Validator& validator, Counter& nHits, Counter& nValidations,
+                  size_t capacity = 1024, time::nanoseconds lifetime = 1_h);
+
+  void
+  validate(const Data& data,
+           const security::DataValidationSuccessCallback& onSuccess,
+           const security::DataValidationFailureCallback& onFailure);
+
+  /**
+   * @brief Forget all validations
+   */
+  void
+  clear();
+
+NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  using Expiry = time::steady_clock::time_point;
+
+  struct State
+  {
+    size_t capacity;
+    time::nanoseconds lifetime;
+    std::map<Name, Expiry> packets; // full name
+  };
+
+NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  Validator& m_validator;
+  Counter& m_nHits;
+  Counter& m_nValidations;
+  // shared with the callbacks of validations in progress
+  std::shared_ptr<State> m_state;
+};
+
+} // namespace ndn::nac::detail
+
+#endif // NDN_NAC_DETAIL_VALIDATION_CACHE_HPP
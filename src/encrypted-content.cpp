@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -114,11 +114,33 @@ EncryptedContent::unsetPayloadKey()
   return *this;
 }
 
+const Name&
+EncryptedContent::getKeyLocator() const
+{
+  if (!m_keyLocatorName) {
+    m_keyLocatorName.emplace(m_keyLocator.isValid() ? Name(m_keyLocator) : Name());
+  }
+  return *m_keyLocatorName;
+}
+
 EncryptedContent&
-EncryptedContent::setKeyLocator(Name keyLocator)
+EncryptedContent::setKeyLocator(const Name& keyLocator)
 {
+  m_wire.reset();
+  m_keyLocator = keyLocator.wireEncode();
+  m_keyLocatorName = keyLocator;
+  return *this;
+}
+
+EncryptedContent&
+EncryptedContent::setKeyLocator(Block keyLocator)
+{
+  if (keyLocator.type() != tlv::Name || !keyLocator.hasWire()) {
+    NDN_THROW(Error("KeyLocator must be an encoded Name TLV"));
+  }
   m_wire.reset();
   m_keyLocator = std::move(keyLocator);
+  m_keyLocatorName.reset();
   return *this;
 }
 
@@ -127,6 +149,7 @@ EncryptedContent::unsetKeyLocator()
 {
   m_wire.reset();
   m_keyLocator = {};
+  m_keyLocatorName.reset();
   return *this;
 }
 
@@ -137,7 +160,7 @@ EncryptedContent::wireEncode(EncodingImpl<TAG>& encoder) const
   size_t totalLength = 0;
 
   if (hasKeyLocator()) {
-    totalLength += m_keyLocator.wireEncode(encoder);
+    totalLength += prependBlock(encoder, m_keyLocator);
   }
 
   if (hasPayloadKey()) {
@@ -210,7 +233,8 @@ EncryptedContent::wireDecode(const Block& wire)
 
   block = m_wire.find(tlv::Name);
   if (block != m_wire.elements_end()) {
-    m_keyLocator.wireDecode(*block);
+    m_keyLocator = *block;
+    m_keyLocatorName.emplace(m_keyLocator);
   }
 }
 
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -24,6 +24,8 @@
 
 #include <ndn-cxx/encoding/tlv.hpp>
 
+#include <optional>
+
 namespace ndn::nac {
 
 /**
@@ -113,17 +115,37 @@ public:
   bool
   hasKeyLocator() const
   {
-    return !m_keyLocator.empty();
+    return m_keyLocator.isValid() && m_keyLocator.value_size() > 0;
   }
 
+  /**
+   * @brief Get the KeyLocator name, decoding it on first access if it was set as a wire block
+   */
   const Name&
-  getKeyLocator() const
+  getKeyLocator() const;
+
+  /**
+   * @brief Get the encoded Name TLV of the KeyLocator
+   */
+  const Block&
+  getKeyLocatorWire() const
   {
     return m_keyLocator;
   }
 
   EncryptedContent&
-  setKeyLocator(Name keyLocator);
+  setKeyLocator(const Name& keyLocator);
+
+  /**
+   * @brief Set the KeyLocator from an already encoded Name TLV
+   *
+   * The block is prepended as is by wireEncode() and shares its buffer with @p keyLocator,
+   * which lets a producer encode the name of its current CK once for all packets.
+   *
+   * @throw Error @p keyLocator is not a Name TLV with wire encoding
+   */
+  EncryptedContent&
+  setKeyLocator(Block keyLocator);
 
   EncryptedContent&
   unsetKeyLocator();
@@ -143,7 +165,8 @@ private:
   Block m_payload;
   Block m_payloadKey; ///< for public key encryption, public key encodes a random key that is used
                       ///< for symmetric encryption of the content
-  Name m_keyLocator;
+  Block m_keyLocator; // encoded Name TLV
+  mutable std::optional<Name> m_keyLocatorName; // decoded on demand
 
   mutable Block m_wire;
 };
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -18,13 +18,17 @@
  */
 
 #include "encryptor.hpp"
+#include "detail/aes-cbc-cipher.hpp"
+#include "detail/ecies.hpp"
+#include "detail/merkle-batch.hpp"
+#include "detail/probes.hpp"
+#include "detail/serving-index.hpp"
+#include "detail/validation-cache.hpp"
 
-#include <ndn-cxx/security/transform/block-cipher.hpp>
-#include <ndn-cxx/security/transform/buffer-source.hpp>
-#include <ndn-cxx/security/transform/stream-sink.hpp>
 #include <ndn-cxx/util/logger.hpp>
 #include <ndn-cxx/util/random.hpp>
 
+#include <boost/asio/error.hpp>
 #include <boost/lexical_cast.hpp>
 
 namespace ndn::nac {
@@ -33,31 +37,87 @@ NDN_LOG_INIT(nac.Encryptor);
 
 constexpr size_t N_RETRIES = 3;
 
+/**
+ * @brief Derive the KEK of sub-dataset @p subDataset from @p kek
+ *
+ * Only the name and the public key in the content of the result are used, so it is not signed.
+ */
+static Data
+deriveKek(const Data& kek, const Name& subDataset)
+{
+  Data derived(Name(kek.getName()).append(DERIVED).append(subDataset));
+  derived.setContent(detail::deriveEciesPublicKey(kek.getContent().value_bytes(), subDataset));
+  return derived;
+}
+
+Encryptor::Metrics::Metrics()
+  : nEncrypts(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nEncrypts"))
+  , nEncryptedBytes(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nEncryptedBytes"))
+  , nCkRotations(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkRotations"))
+  , nKekFetches(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekFetches"))
+  , nKekRetries(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekRetries"))
+  , nKekNacks(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekNacks"))
+  , nKekTimeouts(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekTimeouts"))
+  , nCkDataPublished(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkDataPublished"))
+  , nCkServed(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkServed"))
+  , nCkNotFound(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkNotFound"))
+  , nCkPoolHits(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkPoolHits"))
+  , nCkPoolMisses(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nCkPoolMisses"))
+  , nBatchSignedPackets(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nBatchSignedPackets"))
+  , nKekValidations(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekValidations"))
+  , nKekValidationCacheHits(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekValidationCacheHits"))
+  , nKekValidationFailures(MetricsRegistry::getDefault().getCounter("nac.Encryptor.nKekValidationFailures"))
+  , imsBytes(MetricsRegistry::getDefault().getGauge("nac.Encryptor.imsBytes"))
+  , encryptLatency(MetricsRegistry::getDefault().getHistogram("nac.Encryptor.encryptLatency"))
+  , ckRotationLatency(MetricsRegistry::getDefault().getHistogram("nac.Encryptor.ckRotationLatency"))
+  , publicKeyEncryptLatency(MetricsRegistry::getDefault().getHistogram("nac.Encryptor.publicKeyEncryptLatency"))
+  , signLatency(MetricsRegistry::getDefault().getHistogram("nac.Encryptor.signLatency"))
+{
+}
+
 Encryptor::Encryptor(const Name& accessPrefix,
                      const Name& ckPrefix, SigningInfo ckDataSigningInfo,
                      const ErrorCallback& onFailure,
-                     Validator&, KeyChain& keyChain, Face& face)
+                     Validator& validator, KeyChain& keyChain, Face& face)
+  : Encryptor(accessPrefix, Name(), ckPrefix, std::move(ckDataSigningInfo), onFailure, validator, keyChain, face)
+{
+}
+
+Encryptor::Encryptor(const Name& accessPrefix, const Name& subDataset,
+                     const Name& ckPrefix, SigningInfo ckDataSigningInfo,
+                     const ErrorCallback& onFailure,
+                     Validator& validator, KeyChain& keyChain, Face& face)
   : m_accessPrefix(accessPrefix)
+  , m_subDataset(subDataset)
   , m_ckPrefix(ckPrefix)
   , m_ckBits(AES_KEY_SIZE)
   , m_ckDataSigningInfo(std::move(ckDataSigningInfo))
   , m_isKekRetrievalInProgress(false)
   , m_onFailure(onFailure)
+  , m_published(std::make_unique<detail::PublishedPackets>(m_ims, m_imsBytes))
   , m_keyChain(keyChain)
   , m_face(face)
   , m_scheduler(face.getIoContext())
+  , m_kekValidationCache(std::make_unique<detail::ValidationCache>(validator, m_metrics.nKekValidationCacheHits,
+                                                                   m_metrics.nKekValidations))
 {
   regenerateCk();
 
-  auto serveFromIms = [this] (const Name&, const Interest& interest) {
-    auto data = m_ims.find(interest);
+  auto serve = [this] (const Name&, const Interest& interest) {
+    auto data = m_published->find(interest);
     if (data != nullptr) {
-      NDN_LOG_DEBUG("Serving " << data->getName() << " from InMemoryStorage");
+      NDN_LOG_TRACE("Serving " << data->getName());
+      NAC_PROBE(ck_serve, detail::probeHash(interest.getName()), 1);
+      m_metrics.nCkServed.increment();
       m_face.put(*data);
     }
     else {
-      NDN_LOG_DEBUG("Didn't find CK data for " << interest.getName());
-      // send NACK?
+      NDN_LOG_TRACE("Didn't find CK data for " << interest.getName());
+      NAC_PROBE(ck_serve, detail::probeHash(interest.getName()), 0);
+      m_metrics.nCkNotFound.increment();
+      if (m_isNackingUnpublished) {
+        m_face.put(detail::makeNack(interest, m_keyChain));
+      }
     }
   };
 
@@ -65,12 +125,13 @@ Encryptor::Encryptor(const Name& accessPrefix,
     NDN_LOG_ERROR("Failed to register prefix " << prefix << ": " << msg);
   };
 
-  m_ckReg = m_face.setInterestFilter(Name(ckPrefix).append(CK), serveFromIms, handleError);
+  m_ckReg = m_face.setInterestFilter(Name(ckPrefix).append(CK), serve, handleError);
 }
 
 Encryptor::~Encryptor()
 {
   m_kekPendingInterest.cancel();
+  notifyReadyWaiters(boost::asio::error::operation_aborted);
 }
 
 void
@@ -85,53 +146,211 @@ Encryptor::retryFetchingKek()
   fetchKekAndPublishCkData([&] {
       NDN_LOG_DEBUG("KEK retrieved and published");
       m_isKekRetrievalInProgress = false;
+      notifyReadyWaiters({});
     },
     [=] (const ErrorCode& code, const std::string& msg) {
       NDN_LOG_ERROR("Failed to retrieved KEK: " + msg);
       m_isKekRetrievalInProgress = false;
       m_onFailure(code, msg);
+      notifyReadyWaiters(code);
     },
     N_RETRIES);
 }
 
+void
+Encryptor::notifyReadyWaiters(const boost::system::error_code& ec)
+{
+  auto waiters = std::move(m_readyWaiters);
+  m_readyWaiters.clear();
+  for (const auto& waiter : waiters) {
+    waiter(ec);
+  }
+}
+
 void
 Encryptor::regenerateCk()
 {
-  m_ckName = m_ckPrefix;
-  m_ckName
-    .append(CK)
-    .appendVersion(); // version = ID of CK
+  auto startTime = time::steady_clock::now();
+  m_metrics.nCkRotations.increment();
+
+  if (!takeCkFromPool()) {
+    generateCk();
+
+    // one implication: if CK updated before KEK fetched, KDK for the old CK will not be published
+    if (!m_kek) {
+      retryFetchingKek();
+    }
+    else {
+      makeAndPublishCkData(m_onFailure);
+    }
+  }
+  scheduleCkPoolRefill();
+
+  m_metrics.ckRotationLatency.record(time::steady_clock::now() - startTime);
+  NAC_PROBE(ck_rotate, detail::probeHash(m_ckName));
+}
+
+void
+Encryptor::generateCk()
+{
+  m_ckName = makeCkName();
+  m_ckNameWire = m_ckName.wireEncode();
   NDN_LOG_DEBUG("Generating new CK: " << m_ckName);
   random::generateSecureBytes(m_ckBits);
+  m_ckCipher = std::make_shared<detail::AesCbcCipher>(m_ckBits, CipherOperator::ENCRYPT);
+}
 
-  // one implication: if CK updated before KEK fetched, KDK for the old CK will not be published
-  if (!m_kek) {
+void
+Encryptor::scheduleKekRefresh()
+{
+  auto period = m_kek->getFreshnessPeriod();
+  if (period <= 0_ms) {
+    period = DEFAULT_KEK_FRESHNESS_PERIOD;
+  }
+  m_kekRefreshEvent = m_scheduler.schedule(period, [this] {
+    NDN_LOG_DEBUG("KEK " << m_kek->getName() << " is no longer fresh, checking for a new one");
     retryFetchingKek();
+  });
+}
+
+void
+Encryptor::setCkPoolSize(size_t size)
+{
+  m_ckPoolSize = size;
+  while (m_ckPool.size() > m_ckPoolSize) {
+    m_ckPool.pop_back();
   }
-  else {
-    makeAndPublishCkData(m_onFailure);
+  scheduleCkPoolRefill();
+}
+
+bool
+Encryptor::takeCkFromPool()
+{
+  while (!m_ckPool.empty() && (!m_kek || m_ckPool.front().kekName != m_kek->getName())) {
+    NDN_LOG_DEBUG("Discarding CK " << m_ckPool.front().ckName << " prepared for a different KEK");
+    m_ckPool.pop_front();
+  }
+
+  if (m_ckPool.empty()) {
+    if (m_ckPoolSize > 0) {
+      m_metrics.nCkPoolMisses.increment();
+    }
+    return false;
+  }
+
+  auto& ck = m_ckPool.front();
+  NDN_LOG_DEBUG("Using prepared CK: " << ck.ckName);
+  m_ckName = std::move(ck.ckName);
+  m_ckNameWire = m_ckName.wireEncode();
+  m_ckBits = std::move(ck.ckBits);
+  m_ckCipher = std::move(ck.ckCipher);
+  publishCkData(*ck.ckData);
+  m_ckPool.pop_front();
+  m_metrics.nCkPoolHits.increment();
+  return true;
+}
+
+void
+Encryptor::scheduleCkPoolRefill()
+{
+  if (m_isCkPoolRefillScheduled || !m_kek || m_ckPool.size() >= m_ckPoolSize) {
+    return;
+  }
+
+  m_isCkPoolRefillScheduled = true;
+  m_ckPoolRefillEvent = m_scheduler.schedule(0_ns, [this] {
+    m_isCkPoolRefillScheduled = false;
+    if (!m_kek || m_ckPool.size() >= m_ckPoolSize) {
+      return;
+    }
+
+    if (m_isBatchSigning) {
+      try {
+        refillCkPoolBatch();
+      }
+      catch (const std::runtime_error&) {
+        // do not retry, regenerateCk() will report the error
+        NDN_LOG_ERROR("Failed to prepare CKs with KEK " << m_kek->getName());
+      }
+      return;
+    }
+
+    PreparedCk ck{makeCkName(), SecureBuffer(AES_KEY_SIZE), nullptr, m_kek->getName(), nullptr};
+    random::generateSecureBytes(ck.ckBits);
+    ck.ckCipher = std::make_shared<detail::AesCbcCipher>(ck.ckBits, CipherOperator::ENCRYPT);
+    try {
+      ck.ckData = makeCkData(ck.ckName, ck.ckBits);
+    }
+    catch (const std::runtime_error&) {
+      // do not retry, regenerateCk() will report the error
+      NDN_LOG_ERROR("Failed to prepare CK with KEK " << m_kek->getName());
+      return;
+    }
+    m_ckPool.push_back(std::move(ck));
+
+    scheduleCkPoolRefill();
+  });
+}
+
+void
+Encryptor::refillCkPoolBatch()
+{
+  std::vector<PreparedCk> cks;
+  std::vector<Data*> packets;
+  cks.reserve(m_ckPoolSize - m_ckPool.size());
+  packets.reserve(cks.capacity());
+  while (m_ckPool.size() + cks.size() < m_ckPoolSize) {
+    auto& ck = cks.emplace_back(PreparedCk{makeCkName(), SecureBuffer(AES_KEY_SIZE), nullptr,
+                                           m_kek->getName(), nullptr});
+    random::generateSecureBytes(ck.ckBits);
+    ck.ckCipher = std::make_shared<detail::AesCbcCipher>(ck.ckBits, CipherOperator::ENCRYPT);
+    ck.ckData = makeUnsignedCkData(ck.ckName, ck.ckBits);
+    packets.push_back(ck.ckData.get());
+  }
+
+  auto signStartTime = time::steady_clock::now();
+  detail::signBatch(packets, m_keyChain, m_ckDataSigningInfo);
+  m_metrics.signLatency.record(time::steady_clock::now() - signStartTime);
+  if (packets.size() > 1) {
+    m_metrics.nBatchSignedPackets.increment(packets.size());
+  }
+
+  NDN_LOG_DEBUG("Prepared " << cks.size() << " CKs signed as one batch");
+  for (auto& ck : cks) {
+    m_ckPool.push_back(std::move(ck));
   }
 }
 
+Name
+Encryptor::makeCkName()
+{
+  // CKs can be created in bursts, e.g., when filling the pool, so the current timestamp
+  // alone does not guarantee unique versions
+  auto now = static_cast<uint64_t>(time::toUnixTimestamp(time::system_clock::now()).count());
+  m_lastCkVersion = std::max(now, m_lastCkVersion + 1);
+
+  return Name(m_ckPrefix).append(CK).appendVersion(m_lastCkVersion); // version = ID of CK
+}
+
 EncryptedContent
 Encryptor::encrypt(span<const uint8_t> data)
 {
+  auto startTime = time::steady_clock::now();
+  NAC_PROBE(encrypt_start, data.size());
+
   // Generate IV
   auto iv = std::make_shared<Buffer>(AES_IV_SIZE);
   random::generateSecureBytes(*iv);
 
-  OBufferStream os;
-  security::transform::bufferSource(data)
-    >> security::transform::blockCipher(BlockCipherAlgorithm::AES_CBC,
-                                        CipherOperator::ENCRYPT,
-                                        m_ckBits, *iv)
-    >> security::transform::streamSink(os);
-
   EncryptedContent content;
   content.setIv(iv);
-  content.setPayload(os.buf());
-  content.setKeyLocator(m_ckName);
+  content.setPayload(m_ckCipher->process(*iv, data));
+  content.setKeyLocator(m_ckNameWire);
 
+  m_metrics.nEncrypts.increment();
+  m_metrics.nEncryptedBytes.increment(data.size());
+  m_metrics.encryptLatency.record(time::steady_clock::now() - startTime);
+  NAC_PROBE(encrypt_done, detail::probeHash(m_ckName), content.getPayload().value_size());
   return content;
 }
 
@@ -143,41 +362,88 @@ Encryptor::fetchKekAndPublishCkData(const std::function<void()>& onReady,
   // interest for <access-prefix>/KEK to retrieve <access-prefix>/KEK/<key-id> KekData
 
   NDN_LOG_DEBUG("Fetching KEK " << Name(m_accessPrefix).append(KEK));
+  m_metrics.nKekFetches.increment();
 
   auto kekInterest = Interest(Name(m_accessPrefix).append(KEK))
                      .setCanBePrefix(true)
                      .setMustBeFresh(true);
+  // network NACKs and application-level NACKs (i.e., no KEK has been published) alike
+  auto onNack = [=] (const Interest& i, const std::string& what) {
+    m_metrics.nKekNacks.increment();
+    if (nTriesLeft > 1) {
+      m_metrics.nKekRetries.increment();
+      m_scheduler.schedule(RETRY_DELAY_AFTER_NACK, [=] {
+        fetchKekAndPublishCkData(onReady, onFailure, nTriesLeft - 1);
+      });
+    }
+    else {
+      onFailure(ErrorCode::KekRetrievalFailure, "Retrieval of KEK [" + i.getName().toUri() +
+                "] failed. Got " + what);
+      NDN_LOG_DEBUG("Scheduling retry from NACK");
+      m_scheduler.schedule(m_retryPolicy.getDelay(++m_nKekFailures), [this] { retryFetchingKek(); });
+    }
+  };
+
   m_kekPendingInterest = m_face.expressInterest(kekInterest,
-    [=] (const Interest&, const Data& kek) {
-      // @todo verify if the key is legit
-      m_kek = kek;
-      if (makeAndPublishCkData(onFailure)) {
-        onReady();
+    [=] (const Interest& i, const Data& fetchedKek) {
+      if (fetchedKek.getContentType() == tlv::ContentType_Nack) {
+        return onNack(i, "application NACK");
       }
-      // otherwise, failure has been already declared
+      m_kekValidationCache->validate(fetchedKek,
+        [=] (const Data&) {
+          Data kek = fetchedKek;
+          if (!m_subDataset.empty()) {
+            try {
+              kek = deriveKek(fetchedKek, m_subDataset);
+            }
+            catch (const std::runtime_error& e) {
+              onFailure(ErrorCode::EncryptionFailure, "Failed to derive KEK for sub-dataset " + m_subDataset.toUri() +
+                        " from [" + fetchedKek.getName().toUri() + "]: " + e.what());
+              return;
+            }
+          }
+          bool isFirstKek = !m_kek;
+          bool isKekChanged = !isFirstKek && m_kek->getName() != kek.getName();
+          m_kek = kek;
+          m_nKekFailures = 0;
+          scheduleKekRefresh();
+          if (isKekChanged) {
+            // e.g., a member has been removed: the current CK and the prepared ones may be known
+            // to consumers that can decrypt CKs encrypted with the previous KEK only
+            NDN_LOG_INFO("KEK changed to " << kek.getName() << ", discarding the current CK and "
+                         << m_ckPool.size() << " prepared CKs");
+            m_ckPool.clear();
+            generateCk();
+          }
+          // a refresh that finds the same KEK leaves the published CK data as it is
+          if ((!isFirstKek && !isKekChanged) || makeAndPublishCkData(onFailure)) {
+            onReady();
+          }
+          // otherwise, failure has been already declared
+          scheduleCkPoolRefill();
+        },
+        [=] (const Data&, const security::ValidationError& error) {
+          m_metrics.nKekValidationFailures.increment();
+          onFailure(ErrorCode::KekValidationFailure, "Validation of KEK [" + fetchedKek.getName().toUri() +
+                    "] failed: " + boost::lexical_cast<std::string>(error));
+          NDN_LOG_DEBUG("Scheduling retry after failed validation");
+          m_scheduler.schedule(m_retryPolicy.getDelay(++m_nKekFailures), [this] { retryFetchingKek(); });
+        });
     },
     [=] (const Interest& i, const lp::Nack& nack) {
-      if (nTriesLeft > 1) {
-        m_scheduler.schedule(RETRY_DELAY_AFTER_NACK, [=] {
-          fetchKekAndPublishCkData(onReady, onFailure, nTriesLeft - 1);
-        });
-      }
-      else {
-        onFailure(ErrorCode::KekRetrievalFailure, "Retrieval of KEK [" + i.getName().toUri() +
-                  "] failed. Got NACK with reason " + boost::lexical_cast<std::string>(nack.getReason()));
-        NDN_LOG_DEBUG("Scheduling retry from NACK");
-        m_scheduler.schedule(RETRY_DELAY_KEK_RETRIEVAL, [this] { retryFetchingKek(); });
-      }
+      onNack(i, "NACK with reason " + boost::lexical_cast<std::string>(nack.getReason()));
     },
     [=] (const Interest& i) {
+      m_metrics.nKekTimeouts.increment();
       if (nTriesLeft > 1) {
+        m_metrics.nKekRetries.increment();
         fetchKekAndPublishCkData(onReady, onFailure, nTriesLeft - 1);
       }
       else {
         onFailure(ErrorCode::KekRetrievalTimeout,
                   "Retrieval of KEK [" + i.getName().toUri() + "] timed out");
         NDN_LOG_DEBUG("Scheduling retry after all timeouts");
-        m_scheduler.schedule(RETRY_DELAY_KEK_RETRIEVAL, [this] { retryFetchingKek(); });
+        m_scheduler.schedule(m_retryPolicy.getDelay(++m_nKekFailures), [this] { retryFetchingKek(); });
       }
     });
 }
@@ -186,20 +452,7 @@ bool
 Encryptor::makeAndPublishCkData(const ErrorCallback& onFailure)
 {
   try {
-    PublicKey kek;
-    kek.loadPkcs8(m_kek->getContent().value_bytes());
-
-    EncryptedContent content;
-    content.setPayload(kek.encrypt(m_ckBits));
-
-    auto ckData = std::make_shared<Data>(Name(m_ckName).append(ENCRYPTED_BY).append(m_kek->getName()));
-    ckData->setContent(content.wireEncode());
-    // FreshnessPeriod can serve as a soft access control for revoking access
-    ckData->setFreshnessPeriod(DEFAULT_CK_FRESHNESS_PERIOD);
-    m_keyChain.sign(*ckData, m_ckDataSigningInfo);
-    m_ims.insert(*ckData);
-
-    NDN_LOG_DEBUG("Publishing CK data: " << ckData->getName());
+    publishCkData(*makeCkData(m_ckName, m_ckBits));
     return true;
   }
   catch (const std::runtime_error&) {
@@ -209,4 +462,45 @@ Encryptor::makeAndPublishCkData(const ErrorCallback& onFailure)
   }
 }
 
+shared_ptr<Data>
+Encryptor::makeCkData(const Name& ckName, span<const uint8_t> ckBits)
+{
+  auto ckData = makeUnsignedCkData(ckName, ckBits);
+  auto signStartTime = time::steady_clock::now();
+  m_keyChain.sign(*ckData, m_ckDataSigningInfo);
+  m_metrics.signLatency.record(time::steady_clock::now() - signStartTime);
+  return ckData;
+}
+
+shared_ptr<Data>
+Encryptor::makeUnsignedCkData(const Name& ckName, span<const uint8_t> ckBits)
+{
+  auto encryptStartTime = time::steady_clock::now();
+  EncryptedContent content;
+  if (detail::isEciesKey(m_kek->getContent().value_bytes())) {
+    content.setPayload(detail::eciesWrap(m_kek->getContent().value_bytes(), ckBits));
+  }
+  else {
+    PublicKey kek;
+    kek.loadPkcs8(m_kek->getContent().value_bytes());
+    content.setPayload(kek.encrypt(ckBits));
+  }
+  m_metrics.publicKeyEncryptLatency.record(time::steady_clock::now() - encryptStartTime);
+
+  auto ckData = std::make_shared<Data>(Name(ckName).append(ENCRYPTED_BY).append(m_kek->getName()));
+  ckData->setContent(content.wireEncode());
+  // FreshnessPeriod can serve as a soft access control for revoking access
+  ckData->setFreshnessPeriod(DEFAULT_CK_FRESHNESS_PERIOD);
+  return ckData;
+}
+
+void
+Encryptor::publishCkData(const Data& ckData)
+{
+  m_published->publish(ckData);
+  m_metrics.nCkDataPublished.increment();
+
+  NDN_LOG_DEBUG("Publishing CK data: " << ckData.getName());
+}
+
 } // namespace ndn::nac
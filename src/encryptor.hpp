@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -22,9 +22,25 @@
 
 #include "common.hpp"
 #include "encrypted-content.hpp"
+#include "metrics.hpp"
+#include "secure-memory.hpp"
+
+#include <deque>
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
 
 namespace ndn::nac {
 
+namespace detail {
+class AesCbcCipher;
+class PublishedPackets;
+class ValidationCache;
+} // namespace detail
+
 /**
  * @brief NAC Encryptor
  *
@@ -32,6 +48,8 @@ namespace ndn::nac {
  */
 class Encryptor
 {
+  friend tests::BenchmarkAccess;
+
 public:
   /**
    * @param accessPrefix  NAC prefix to fetch KEK (e.g., /access/prefix/NAC/data/subset)
@@ -41,9 +59,12 @@ public:
    * @param onFailure     Callback to notify application of a failure to create CK data
    *                      (failed to fetch KEK, failed to encrypt with KEK, etc.).
    *                      Note that Encryptor will continue trying to retrieve KEK until success
-   *                      (each attempt separated by `RETRY_DELAY_KEK_RETRIEVAL`) and @p onFailure
-   *                      may be called multiple times.
-   * @param validator     Validation policy to ensure correctness of KEK
+   *                      (each attempt separated by a delay given by the retry policy, see
+   *                      setRetryPolicy()) and @p onFailure may be called multiple times.
+   *                      The KEK is retrieved again whenever its FreshnessPeriod expires; if it
+   *                      has changed, a new CK is generated.
+   * @param validator     Validation policy to ensure correctness of KEK; a KEK that fails
+   *                      validation is reported with ErrorCode::KekValidationFailure
    * @param keyChain      KeyChain
    * @param face          Face that will be used to fetch KEK and publish CK data
    */
@@ -52,6 +73,23 @@ public:
             const ErrorCallback& onFailure,
             Validator& validator, KeyChain& keyChain, Face& face);
 
+  /**
+   * @brief Encrypt for sub-dataset @p subDataset of the NAC prefix @p accessPrefix
+   *
+   * The KEK of @p accessPrefix, which must be an EC key, is retrieved as usual, and the KEK of
+   * the sub-dataset is derived from it locally (see detail::deriveEciesPublicKey()), named
+   * `<access-prefix>/KEK/<key-id>/DERIVED/<sub-dataset>`.  Consumers that can retrieve the KDK
+   * of @p accessPrefix derive the corresponding private key, so that no AccessManager, KEK, or
+   * KDK is needed for the sub-dataset itself.  If the KEK is not an EC key, CK data cannot be
+   * created and @p onFailure is called with ErrorCode::EncryptionFailure.
+   *
+   * An empty @p subDataset is the same as the other constructor.
+   */
+  Encryptor(const Name& accessPrefix, const Name& subDataset,
+            const Name& ckPrefix, SigningInfo ckDataSigningInfo,
+            const ErrorCallback& onFailure,
+            Validator& validator, KeyChain& keyChain, Face& face);
+
   ~Encryptor();
 
   /**
@@ -73,6 +111,42 @@ public:
   EncryptedContent
   encrypt(span<const uint8_t> data);
 
+  /**
+   * @brief Wait until KEK is retrieved and CK data published, with completion token @p token
+   *
+   * The completion signature is `void(boost::system::error_code)`.  Completes right away if KEK
+   * has already been retrieved.  Otherwise, starts retrieval of KEK if it is not in progress,
+   * and completes when the current attempt succeeds or fails, in the latter case with the
+   * ErrorCode of the failure (see getErrorCategory()).  The handler is invoked through its
+   * associated executor, by default that of the Face's io_context.  For example, in a C++20
+   * coroutine:
+   * @code
+   * co_await encryptor.ready(boost::asio::use_awaitable);
+   * @endcode
+   */
+  template<typename CompletionToken>
+  auto
+  ready(CompletionToken&& token)
+  {
+    return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code)>(
+      [this] (auto&& handler) {
+        using H = std::decay_t<decltype(handler)>;
+        auto executor = boost::asio::get_associated_executor(handler, m_face.getIoContext().get_executor());
+        if (m_kek) {
+          boost::asio::post(executor, [h = H(std::forward<decltype(handler)>(handler))] () mutable {
+            std::move(h)(boost::system::error_code{});
+          });
+          return;
+        }
+
+        auto h = std::make_shared<H>(std::forward<decltype(handler)>(handler));
+        m_readyWaiters.push_back([h, executor] (const boost::system::error_code& ec) {
+          boost::asio::dispatch(executor, [h, ec] { std::move(*h)(ec); });
+        });
+        retryFetchingKek();
+      }, token);
+  }
+
   /**
    * @brief Create a new content key and publish the corresponding CK data
    *
@@ -82,6 +156,59 @@ public:
   void
   regenerateCk();
 
+  /**
+   * @brief Keep up to @p size content keys prepared in advance
+   *
+   * A prepared CK already has its CK data encrypted with the current KEK and signed, so that
+   * regenerateCk() only needs to publish it.  The pool is refilled in the background, one CK
+   * per event loop iteration of the Face, and is discarded when a different KEK is fetched.
+   * CK data of a prepared CK is published only once the CK is taken into use.
+   *
+   * The default size is zero, i.e., every CK is generated, encrypted, and signed by regenerateCk().
+   */
+  void
+  setCkPoolSize(size_t size);
+
+  /**
+   * @brief Enable or disable batch signing of prepared CKs (disabled by default)
+   *
+   * With batch signing, the CK pool (see setCkPoolSize()) is refilled in a single event loop
+   * iteration, and the CK data of all CKs prepared together are signed with a single signature
+   * over the root of a Merkle tree of the packets (see detail::signBatch()).  Decryptor
+   * validates such packets transparently.
+   */
+  void
+  setBatchSigning(bool isEnabled)
+  {
+    m_isBatchSigning = isEnabled;
+  }
+
+  /**
+   * @brief Enable or disable application-level NACKs (disabled by default)
+   *
+   * If enabled, Interests for CK data that is not published are answered with an application-level
+   * NACK (see detail::makeNack()).  Enable this only if no other Encryptor publishes under the
+   * same CK prefix, as their Interest filters would receive the same Interests and the NACK could
+   * pre-empt the CK data of the other Encryptor, both at the consumer and in network caches.
+   */
+  void
+  setNackUnpublished(bool isEnabled)
+  {
+    m_isNackingUnpublished = isEnabled;
+  }
+
+  /**
+   * @brief Set the delays between attempts to retrieve KEK
+   *
+   * Each attempt consists of up to three Interests; the policy determines the delay after a
+   * failed attempt.  The default is a fixed delay of `RETRY_DELAY_KEK_RETRIEVAL`.
+   */
+  void
+  setRetryPolicy(const RetryPolicy& policy)
+  {
+    m_retryPolicy = policy;
+  }
+
 public: // accessor interface for published data packets
   /**
    * @return number of packets stored in in-memory storage
@@ -118,6 +245,9 @@ private:
   void
   retryFetchingKek();
 
+  void
+  notifyReadyWaiters(const boost::system::error_code& ec);
+
   void
   fetchKekAndPublishCkData(const std::function<void()>& onReady,
                            const ErrorCallback& onFailure,
@@ -126,24 +256,137 @@ private:
   bool
   makeAndPublishCkData(const ErrorCallback& onFailure);
 
+  /**
+   * @brief Replace the current CK by a newly generated one, without publishing its CK data
+   */
+  void
+  generateCk();
+
+  /**
+   * @brief Retrieve the KEK again once the current one is no longer fresh
+   *
+   * The AccessManager replaces the KEK when a member is removed (see AccessManager::removeMember());
+   * this way, the Encryptor moves to the new KEK, and to a new CK, within one FreshnessPeriod.
+   */
+  void
+  scheduleKekRefresh();
+
+  /**
+   * @brief Create a name for a new CK, with a version greater than that of any previous CK
+   */
+  Name
+  makeCkName();
+
+  /**
+   * @brief Create CK data for CK @p ckName encrypted with the current KEK
+   * @throw std::runtime_error encryption or signing failed
+   */
+  shared_ptr<Data>
+  makeCkData(const Name& ckName, span<const uint8_t> ckBits);
+
+  /**
+   * @brief Create unsigned CK data for CK @p ckName encrypted with the current KEK
+   * @throw std::runtime_error encryption failed
+   */
+  shared_ptr<Data>
+  makeUnsignedCkData(const Name& ckName, span<const uint8_t> ckBits);
+
+  /**
+   * @brief Prepare CKs until the pool is full, with their CK data signed as one batch
+   * @throw std::runtime_error encryption or signing failed
+   */
+  void
+  refillCkPoolBatch();
+
+  void
+  publishCkData(const Data& ckData);
+
+  /**
+   * @brief Make the oldest CK from the pool prepared for the current KEK the current CK
+   * @return false if no such CK is available
+   */
+  bool
+  takeCkFromPool();
+
+  void
+  scheduleCkPoolRefill();
+
+  /**
+   * @brief Operational metrics, reported into MetricsRegistry::getDefault() under `nac.Encryptor.`
+   */
+  struct Metrics
+  {
+    Metrics();
+
+    Counter& nEncrypts;
+    Counter& nEncryptedBytes;
+    Counter& nCkRotations;
+    Counter& nKekFetches;
+    Counter& nKekRetries;
+    Counter& nKekNacks;
+    Counter& nKekTimeouts;
+    Counter& nCkDataPublished;
+    Counter& nCkServed;
+    Counter& nCkNotFound;
+    Counter& nCkPoolHits;
+    Counter& nCkPoolMisses;
+    Counter& nBatchSignedPackets;
+    Counter& nKekValidations;
+    Counter& nKekValidationCacheHits;
+    Counter& nKekValidationFailures;
+    Gauge& imsBytes;
+    LatencyHistogram& encryptLatency;
+    LatencyHistogram& ckRotationLatency;
+    LatencyHistogram& publicKeyEncryptLatency;
+    LatencyHistogram& signLatency;
+  };
+
 NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
   Name m_accessPrefix;
+  Name m_subDataset;
   Name m_ckPrefix;
   Name m_ckName;
-  Buffer m_ckBits;
+  Block m_ckNameWire; // m_ckName encoded once per CK, shared by all EncryptedContent
+  SecureBuffer m_ckBits; // kept for encrypting CK data once KEK is retrieved
+  shared_ptr<detail::AesCbcCipher> m_ckCipher; // m_ckBits with the key already expanded
   SigningInfo m_ckDataSigningInfo;
 
   bool m_isKekRetrievalInProgress;
+  RetryPolicy m_retryPolicy = RetryPolicy::fixed(RETRY_DELAY_KEK_RETRIEVAL);
+  size_t m_nKekFailures = 0; // consecutive failed attempts to retrieve KEK
   std::optional<Data> m_kek;
   ErrorCallback m_onFailure;
+  std::vector<std::function<void(const boost::system::error_code&)>> m_readyWaiters;
 
   InMemoryStoragePersistent m_ims; // for encrypted CKs
+  std::unique_ptr<detail::PublishedPackets> m_published; // serves the packets in m_ims
   ScopedRegisteredPrefixHandle m_ckReg;
   PendingInterestHandle m_kekPendingInterest;
 
   KeyChain& m_keyChain;
   Face& m_face;
   Scheduler m_scheduler;
+  scheduler::ScopedEventId m_kekRefreshEvent;
+
+  struct PreparedCk
+  {
+    Name ckName;
+    SecureBuffer ckBits;
+    shared_ptr<detail::AesCbcCipher> ckCipher;
+    Name kekName;
+    shared_ptr<Data> ckData;
+  };
+  std::deque<PreparedCk> m_ckPool;
+  size_t m_ckPoolSize = 0;
+  bool m_isCkPoolRefillScheduled = false;
+  bool m_isBatchSigning = false;
+  bool m_isNackingUnpublished = false;
+  scheduler::ScopedEventId m_ckPoolRefillEvent;
+  uint64_t m_lastCkVersion = 0;
+
+  Metrics m_metrics;
+  Gauge m_imsBytes{m_metrics.imsBytes}; // contribution of this instance
+  std::unique_ptr<detail::ValidationCache> m_kekValidationCache; // uses m_metrics
 };
 
 } // namespace ndn::nac
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "kdk-server.hpp"
+#include "detail/mapped-file.hpp"
+#include "detail/probes.hpp"
+#include "detail/serving-index.hpp"
+
+#include <ndn-cxx/encoding/block-helpers.hpp>
+#include <ndn-cxx/util/exception.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+#include <algorithm>
+
+namespace ndn::nac {
+
+NDN_LOG_INIT(nac.KdkServer);
+
+KdkServer::Metrics::Metrics()
+  : nKekServed(MetricsRegistry::getDefault().getCounter("nac.KdkServer.nKekServed"))
+  , nKdkServed(MetricsRegistry::getDefault().getCounter("nac.KdkServer.nKdkServed"))
+  , nNodeKeysServed(MetricsRegistry::getDefault().getCounter("nac.KdkServer.nNodeKeysServed"))
+  , nNotFound(MetricsRegistry::getDefault().getCounter("nac.KdkServer.nNotFound"))
+{
+}
+
+KdkServer::KdkServer(const std::string& bundleFile, Face& face)
+  : m_face(face)
+  , m_keyChain("pib-memory:", "tpm-memory:")
+{
+  try {
+    m_file = std::make_unique<detail::MappedFile>(bundleFile);
+  }
+  catch (const std::runtime_error& e) {
+    NDN_THROW_NESTED(Error(e.what()));
+  }
+
+  // only the index is copied out of the mapping
+  auto contents = m_file->getContents();
+  auto [isOk, index] = Block::fromBuffer(contents);
+  if (!isOk || index.type() != tlv::KdkBundleIndex) {
+    NDN_THROW(Error("'" + bundleFile + "' is not a KDK bundle"));
+  }
+  auto packets = contents.subspan(index.size());
+
+  try {
+    index.parse();
+    m_entries.reserve(index.elements_size());
+    for (const auto& element : index.elements()) {
+      element.parse();
+      if (element.type() != tlv::KdkBundleEntry || element.elements_size() != 2 ||
+          element.elements()[0].type() != tlv::Name || element.elements()[1].type() != tlv::KdkBundleOffset) {
+        NDN_THROW(Error("Malformed index entry"));
+      }
+      Name name(element.elements()[0]);
+      auto offset = readNonNegativeInteger(element.elements()[1]);
+      if (!m_entries.empty() && !(m_entries.back().name < name)) {
+        NDN_THROW(Error("Index is not in canonical order at " + name.toUri()));
+      }
+
+      // the size of the packet is given by its TLV header, without decoding the rest of it
+      if (offset >= packets.size()) {
+        NDN_THROW(Error("Packet " + name.toUri() + " is outside of the bundle"));
+      }
+      auto begin = packets.begin() + static_cast<ptrdiff_t>(offset);
+      auto pos = begin;
+      uint32_t type = 0;
+      uint64_t length = 0;
+      if (!tlv::readType(pos, packets.end(), type) || type != tlv::Data ||
+          !tlv::readVarNumber(pos, packets.end(), length) ||
+          length > static_cast<uint64_t>(packets.end() - pos)) {
+        NDN_THROW(Error("Packet " + name.toUri() + " is truncated or not a Data packet"));
+      }
+      auto size = static_cast<size_t>(pos - begin) + static_cast<size_t>(length);
+      m_entries.push_back({std::move(name), packets.subspan(static_cast<size_t>(offset), size), nullptr});
+    }
+  }
+  catch (const tlv::Error& e) {
+    NDN_THROW_NESTED(Error("Malformed KDK bundle '" + bundleFile + "': " + e.what()));
+  }
+  catch (const Error& e) {
+    NDN_THROW_NESTED(Error("Malformed KDK bundle '" + bundleFile + "': " + e.what()));
+  }
+
+  // <nac-identity>/KEK/<key-id>
+  auto kek = std::find_if(m_entries.begin(), m_entries.end(), [] (const auto& entry) {
+    return entry.name.size() >= 2 && entry.name.get(-2) == KEK;
+  });
+  if (kek == m_entries.end()) {
+    NDN_THROW(Error("KDK bundle '" + bundleFile + "' has no KEK"));
+  }
+  m_nacIdentity = kek->name.getPrefix(-2);
+
+  bool hasNodeKeys = false;
+  for (const auto& entry : m_entries) {
+    if (!m_nacIdentity.isPrefixOf(entry.name) || entry.name.size() == m_nacIdentity.size()) {
+      NDN_THROW(Error("Packet " + entry.name.toUri() + " in KDK bundle '" + bundleFile +
+                      "' is not under " + m_nacIdentity.toUri()));
+    }
+    hasNodeKeys = hasNodeKeys || entry.name.get(m_nacIdentity.size()) == NODE;
+  }
+
+  auto serve = [this] (const Name& filter, const Interest& interest) {
+    this->serve(filter, interest);
+  };
+  auto handleError = [] (const Name& prefix, const std::string& msg) {
+    NDN_LOG_ERROR("Failed to register prefix " << prefix << ": " << msg);
+  };
+  m_kekReg = m_face.setInterestFilter(Name(m_nacIdentity).append(KEK), serve, handleError);
+  m_kdkReg = m_face.setInterestFilter(Name(m_nacIdentity).append(KDK), serve, handleError);
+  if (hasNodeKeys) {
+    m_nodeReg = m_face.setInterestFilter(Name(m_nacIdentity).append(NODE), serve, handleError);
+  }
+  NDN_LOG_INFO("Serving " << m_entries.size() << " packets of " << m_nacIdentity << " from " << bundleFile);
+}
+
+KdkServer::~KdkServer() = default;
+
+void
+KdkServer::writeBundle(std::vector<Data> packets, std::ostream& os)
+{
+  std::sort(packets.begin(), packets.end(),
+            [] (const Data& a, const Data& b) { return a.getName() < b.getName(); });
+
+  Block index(tlv::KdkBundleIndex);
+  uint64_t offset = 0;
+  for (size_t i = 0; i < packets.size(); ++i) {
+    if (i > 0 && packets[i].getName() == packets[i - 1].getName()) {
+      NDN_THROW(Error("Packet " + packets[i].getName().toUri() + " is in the bundle twice"));
+    }
+    Block entry(tlv::KdkBundleEntry);
+    entry.push_back(packets[i].getName().wireEncode());
+    entry.push_back(makeNonNegativeIntegerBlock(tlv::KdkBundleOffset, offset));
+    entry.encode();
+    index.push_back(entry);
+    offset += packets[i].wireEncode().size();
+  }
+  index.encode();
+
+  os.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size()));
+  for (const auto& data : packets) {
+    const auto& wire = data.wireEncode();
+    os.write(reinterpret_cast<const char*>(wire.data()), static_cast<std::streamsize>(wire.size()));
+  }
+}
+
+const Data*
+KdkServer::getData(const Entry& entry)
+{
+  // Face::put() takes a Data, and a Block owns its buffer, so the packet cannot be sent straight
+  // from the mapping; it is copied and decoded once instead, and later sent with its encoding
+  if (entry.data == nullptr) {
+    auto data = std::make_shared<Data>();
+    try {
+      data->wireDecode(Block(entry.wire));
+    }
+    catch (const tlv::Error& e) {
+      NDN_LOG_ERROR("Cannot decode packet " << entry.name << " from the bundle: " << e.what());
+      return nullptr;
+    }
+    if (data->getName() != entry.name) {
+      NDN_LOG_ERROR("Packet " << data->getName() << " is indexed as " << entry.name << " in the bundle");
+      return nullptr;
+    }
+    entry.data = std::move(data);
+  }
+  return entry.data.get();
+}
+
+const KdkServer::Entry*
+KdkServer::find(const Interest& interest) const
+{
+  auto byName = [] (const Entry& entry, const Name& name) { return entry.name < name; };
+  auto matches = [&] (const Entry& entry) {
+    const auto* data = getData(entry);
+    // e.g., a different implicit digest
+    return data != nullptr && interest.matchesData(*data);
+  };
+  const auto& name = interest.getName();
+
+  // a name with an implicit digest can only be a prefix of the full name of the packet itself
+  bool hasDigest = !name.empty() && name[-1].isImplicitSha256Digest();
+  if (!interest.getCanBePrefix() || hasDigest) {
+    auto exactName = hasDigest ? name.getPrefix(-1) : name;
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), exactName, byName);
+    return it != m_entries.end() && it->name == exactName && matches(*it) ? &*it : nullptr;
+  }
+
+  // the last name under the prefix that the Interest matches, starting just before the successor
+  // of the prefix
+  auto it = std::lower_bound(m_entries.begin(), m_entries.end(), name.getSuccessor(), byName);
+  while (it != m_entries.begin()) {
+    --it;
+    if (!name.isPrefixOf(it->name)) {
+      break;
+    }
+    if (matches(*it)) {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+void
+KdkServer::serve(const Name& filter, const Interest& interest)
+{
+  const auto* entry = find(interest);
+  if (entry == nullptr) {
+    NDN_LOG_TRACE("Didn't find data for " << interest.getName());
+    handleNotFound(interest);
+    return;
+  }
+
+  NDN_LOG_TRACE("Serving " << entry->name);
+  NAC_PROBE(key_serve, detail::probeHash(interest.getName()), 1);
+  if (filter.get(-1) == KEK) {
+    m_metrics.nKekServed.increment();
+  }
+  else if (filter.get(-1) == NODE) {
+    m_metrics.nNodeKeysServed.increment();
+  }
+  else {
+    m_metrics.nKdkServed.increment();
+  }
+  m_face.put(*entry->data);
+}
+
+void
+KdkServer::handleNotFound(const Interest& interest)
+{
+  NAC_PROBE(key_serve, detail::probeHash(interest.getName()), 0);
+  m_metrics.nNotFound.increment();
+  if (m_isNackingUnpublished) {
+    m_face.put(detail::makeNack(interest, m_keyChain));
+  }
+}
+
+} // namespace ndn::nac
@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_KDK_SERVER_HPP
+#define NDN_NAC_KDK_SERVER_HPP
+
+#include "common.hpp"
+#include "metrics.hpp"
+
+#include <ndn-cxx/face.hpp>
+
+namespace ndn::nac {
+
+namespace detail {
+class MappedFile;
+} // namespace detail
+
+/**
+ * @brief Server of the KEK and KDKs exported by an offline Access Manager
+ *
+ * The data owner's keys can stay on an offline host: AccessManager::exportBundle() (or
+ * writeBundle()) writes the KEK and all KDKs, already signed, into a single bundle file, and
+ * KdkServer serves that file on an online host under the usual KEK and KDK names, in the same
+ * way as AccessManager.  KdkServer has no access to any private key and performs no
+ * cryptographic operations: the bundle is mapped into memory, only its index is loaded, and a
+ * packet is decoded from the mapping when it is first requested, and then sent as is.
+ *
+ * Interests for packets that are not in the bundle can be answered with an application-level
+ * NACK, as with AccessManager.  To change the membership, a new bundle is exported offline
+ * and loaded by a new KdkServer.  The new bundle must be written to a new file that is then
+ * renamed over the old one (as `ndn-nac add-members -b` does), since rewriting the file that a
+ * KdkServer maps can crash it (see detail::MappedFile).
+ */
+class KdkServer : noncopyable
+{
+public:
+  class Error : public std::runtime_error
+  {
+  public:
+    using std::runtime_error::runtime_error;
+  };
+
+  /**
+   * @brief Load the bundle in @p bundleFile and serve its packets on @p face
+   *
+   * Registers the prefixes `[nac-identity]/KEK` and `[nac-identity]/KDK` (and
+   * `[nac-identity]/NODE`, if the bundle has node keys), where `[nac-identity]` is taken from
+   * the name of the KEK in the bundle.
+   *
+   * @throw Error the file cannot be mapped, or is not a valid bundle
+   */
+  KdkServer(const std::string& bundleFile, Face& face);
+
+  ~KdkServer();
+
+  /**
+   * @brief Get the name of the NAC identity, i.e., `[identity]/NAC/[dataset]`
+   */
+  const Name&
+  getNacIdentity() const
+  {
+    return m_nacIdentity;
+  }
+
+  /**
+   * @brief Get the number of packets in the bundle
+   */
+  size_t
+  size() const
+  {
+    return m_entries.size();
+  }
+
+  /**
+   * @brief Enable or disable application-level NACKs (disabled by default),
+   *        as with AccessManager::setNackUnpublished()
+   */
+  void
+  setNackUnpublished(bool isEnabled)
+  {
+    m_isNackingUnpublished = isEnabled;
+  }
+
+  /**
+   * @brief Write @p packets into a bundle
+   *
+   * The bundle consists of an index with the name and offset of every packet, in canonical
+   * order of the names, followed by the packets in the same order, in TLV wire format (see
+   * the NAC specification).
+   *
+   * @pre all packets are signed
+   * @throw Error two packets have the same name
+   */
+  static void
+  writeBundle(std::vector<Data> packets, std::ostream& os);
+
+NAC_PUBLIC_WITH_TESTS_ELSE_PRIVATE:
+  struct Entry
+  {
+    Name name;
+    span<const uint8_t> wire; // in the mapping
+    mutable shared_ptr<const Data> data; // decoded when first requested
+  };
+
+  /**
+   * @brief Find the packet to answer @p interest with, as with detail::ServingIndex
+   *
+   * With CanBePrefix, this is the packet with the greatest name under the prefix among those
+   * that @p interest matches, e.g., with its implicit digest.
+   *
+   * @return the entry of the packet, whose Data has been decoded, or nullptr if there is none
+   */
+  const Entry*
+  find(const Interest& interest) const;
+
+  /**
+   * @brief Get the packet of @p entry, decoding it from the mapping when first requested
+   * @return the packet, or nullptr if it is malformed
+   */
+  static const Data*
+  getData(const Entry& entry);
+
+private:
+  void
+  serve(const Name& filter, const Interest& interest);
+
+  void
+  handleNotFound(const Interest& interest);
+
+  /**
+   * @brief Operational metrics, reported into MetricsRegistry::getDefault() under `nac.KdkServer.`
+   */
+  struct Metrics
+  {
+    Metrics();
+
+    Counter& nKekServed;
+    Counter& nKdkServed;
+    Counter& nNodeKeysServed;
+    Counter& nNotFound;
+  };
+
+private:
+  std::unique_ptr<detail::MappedFile> m_file;
+  std::vector<Entry> m_entries; // in canonical order of the names
+  Name m_nacIdentity;
+
+  Face& m_face;
+  KeyChain m_keyChain; // without any keys, only for digest-signing NACKs
+  bool m_isNackingUnpublished = false;
+  ScopedRegisteredPrefixHandle m_kekReg;
+  ScopedRegisteredPrefixHandle m_kdkReg;
+  ScopedRegisteredPrefixHandle m_nodeReg;
+
+  Metrics m_metrics;
+};
+
+} // namespace ndn::nac
+
+#endif // NDN_NAC_KDK_SERVER_HPP
@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "metrics-dumper.hpp"
+
+#include <ndn-cxx/util/exception.hpp>
+#include <ndn-cxx/util/logger.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+namespace ndn::nac {
+
+NDN_LOG_INIT(nac.MetricsDumper);
+
+MetricsDumper::MetricsDumper(boost::asio::io_context& io, std::string path, MetricsRegistry& registry)
+  : m_path(std::move(path))
+  , m_registry(registry)
+  , m_scheduler(io)
+  , m_signals(io)
+{
+}
+
+void
+MetricsDumper::setInterval(time::nanoseconds interval)
+{
+  m_interval = interval;
+  m_dumpEvent.cancel();
+  if (m_interval > 0_ns) {
+    scheduleDump();
+  }
+}
+
+void
+MetricsDumper::scheduleDump()
+{
+  m_dumpEvent = m_scheduler.schedule(m_interval, [this] {
+    tryDump();
+    scheduleDump();
+  });
+}
+
+void
+MetricsDumper::addSignal(int signalNumber)
+{
+  m_signals.add(signalNumber);
+  if (!m_isWaitingForSignal) {
+    waitForSignal();
+  }
+}
+
+void
+MetricsDumper::waitForSignal()
+{
+  m_isWaitingForSignal = true;
+  m_signals.async_wait([this] (const boost::system::error_code& error, int signalNumber) {
+    if (error == boost::asio::error::operation_aborted) {
+      return;
+    }
+    if (!error) {
+      NDN_LOG_DEBUG("Received signal " << signalNumber << ", writing metrics to " << m_path);
+      tryDump();
+    }
+    waitForSignal();
+  });
+}
+
+void
+MetricsDumper::dump()
+{
+  auto tmpPath = m_path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::trunc);
+    if (!file) {
+      NDN_THROW(Error("Cannot open '" + tmpPath + "'"));
+    }
+    m_registry.getSnapshot().save(file);
+    file.flush();
+    if (!file) {
+      NDN_THROW(Error("Cannot write '" + tmpPath + "'"));
+    }
+  }
+  if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+    NDN_THROW(Error("Cannot rename '" + tmpPath + "' to '" + m_path + "'"));
+  }
+}
+
+void
+MetricsDumper::tryDump()
+{
+  try {
+    dump();
+  }
+  catch (const Error& e) {
+    NDN_LOG_ERROR("Failed to write metrics: " << e.what());
+  }
+}
+
+} // namespace ndn::nac
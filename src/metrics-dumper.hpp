@@ -0,0 +1,103 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_METRICS_DUMPER_HPP
+#define NDN_NAC_METRICS_DUMPER_HPP
+
+#include "metrics.hpp"
+
+#include <ndn-cxx/util/scheduler.hpp>
+
+#include <boost/asio/signal_set.hpp>
+
+namespace ndn::nac {
+
+/**
+ * @brief Saves snapshots of a MetricsRegistry of a running process into a file
+ *
+ * Snapshots are written in the format of MetricsRegistry::Snapshot::save(), which
+ * `ndn-nac dump-metrics` prints, periodically (see setInterval()) and/or whenever the process
+ * receives one of the signals given to addSignal(), e.g.:
+ * @code
+ * MetricsDumper dumper(face.getIoContext(), "/var/run/my-app.metrics");
+ * dumper.setInterval(10_s);
+ * dumper.addSignal(SIGUSR1);
+ * @endcode
+ * and then `kill -USR1 <pid>; ndn-nac dump-metrics /var/run/my-app.metrics`.
+ *
+ * Each snapshot is written into a temporary file next to the target, which is then renamed to
+ * the target, so that a reader never sees a partially written snapshot.
+ */
+class MetricsDumper : noncopyable
+{
+public:
+  /**
+   * @param io       io_context that runs periodic dumps and signal handling, e.g., that of the Face
+   * @param path     file to write snapshots into
+   * @param registry registry to take snapshots of
+   */
+  MetricsDumper(boost::asio::io_context& io, std::string path,
+                MetricsRegistry& registry = MetricsRegistry::getDefault());
+
+  /**
+   * @brief Write a snapshot every @p interval, or stop the periodic dumps if zero
+   */
+  void
+  setInterval(time::nanoseconds interval);
+
+  /**
+   * @brief Write a snapshot whenever the process receives signal @p signalNumber
+   * @throw boost::system::system_error the signal cannot be handled
+   */
+  void
+  addSignal(int signalNumber);
+
+  /**
+   * @brief Write a snapshot now
+   * @throw Error the file cannot be written
+   */
+  void
+  dump();
+
+private:
+  void
+  scheduleDump();
+
+  void
+  waitForSignal();
+
+  /**
+   * @brief Write a snapshot, logging instead of throwing on failure
+   */
+  void
+  tryDump();
+
+private:
+  std::string m_path;
+  MetricsRegistry& m_registry;
+  Scheduler m_scheduler;
+  scheduler::ScopedEventId m_dumpEvent;
+  time::nanoseconds m_interval{0};
+  boost::asio::signal_set m_signals;
+  bool m_isWaitingForSignal = false;
+};
+
+} // namespace ndn::nac
+
+#endif // NDN_NAC_METRICS_DUMPER_HPP
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "metrics.hpp"
+
+#include <ndn-cxx/util/exception.hpp>
+
+#include <iomanip>
+#include <sstream>
+
+namespace ndn::nac {
+
+void
+LatencyHistogram::record(time::nanoseconds latency) noexcept
+{
+  auto ns = std::max<int64_t>(latency.count(), 0);
+
+  size_t index = 0;
+  for (auto v = static_cast<uint64_t>(ns) >> 1; v != 0 && index < N_BUCKETS - 1; v >>= 1) {
+    ++index;
+  }
+
+  m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(ns, std::memory_order_relaxed);
+
+  auto prevMax = m_max.load(std::memory_order_relaxed);
+  while (prevMax < ns && !m_max.compare_exchange_weak(prevMax, ns, std::memory_order_relaxed)) {
+  }
+
+  if (m_total != nullptr) {
+    m_total->record(latency);
+  }
+}
+
+LatencyHistogram::Snapshot
+LatencyHistogram::getSnapshot() const
+{
+  Snapshot snapshot;
+  for (size_t i = 0; i < N_BUCKETS; ++i) {
+    snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+  }
+  snapshot.count = m_count.load(std::memory_order_relaxed);
+  snapshot.sum = time::nanoseconds(m_sum.load(std::memory_order_relaxed));
+  snapshot.max = time::nanoseconds(m_max.load(std::memory_order_relaxed));
+  return snapshot;
+}
+
+time::nanoseconds
+LatencyHistogram::Snapshot::getQuantile(double p) const
+{
+  // the buckets and the count are read independently, so rely only on the buckets
+  uint64_t total = 0;
+  for (auto n : buckets) {
+    total += n;
+  }
+  if (total == 0) {
+    return time::nanoseconds(0);
+  }
+
+  auto rank = static_cast<uint64_t>(p * total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < N_BUCKETS - 1; ++i) {
+    seen += buckets[i];
+    if (seen > rank) {
+      return std::min(getBucketLowerBound(i + 1), max);
+    }
+  }
+  return max;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const LatencyHistogram::Snapshot& snapshot)
+{
+  return os << "count=" << snapshot.count
+            << " mean=" << snapshot.getMean()
+            << " p50=" << snapshot.getQuantile(0.5)
+            << " p99=" << snapshot.getQuantile(0.99)
+            << " max=" << snapshot.max;
+}
+
+MetricsRegistry&
+MetricsRegistry::getDefault()
+{
+  static MetricsRegistry registry;
+  return registry;
+}
+
+template<typename T>
+static T&
+findOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name)
+{
+  auto& metric = metrics[name];
+  if (metric == nullptr) {
+    metric = std::make_unique<T>();
+  }
+  return *metric;
+}
+
+Counter&
+MetricsRegistry::getCounter(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return findOrCreate(m_counters, name);
+}
+
+Gauge&
+MetricsRegistry::getGauge(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return findOrCreate(m_gauges, name);
+}
+
+LatencyHistogram&
+MetricsRegistry::getHistogram(const std::string& name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return findOrCreate(m_histograms, name);
+}
+
+MetricsRegistry::Snapshot
+MetricsRegistry::getSnapshot() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  Snapshot snapshot;
+  for (const auto& [name, counter] : m_counters) {
+    snapshot.counters.emplace(name, counter->get());
+  }
+  for (const auto& [name, gauge] : m_gauges) {
+    snapshot.gauges.emplace(name, gauge->get());
+  }
+  for (const auto& [name, histogram] : m_histograms) {
+    snapshot.histograms.emplace(name, histogram->getSnapshot());
+  }
+  return snapshot;
+}
+
+// The saved format has one metric per line:
+//
+//   counter <name> <value>
+//   gauge <name> <value>
+//   histogram <name> <count> <sum-ns> <max-ns> <bucket-0> ... <bucket-N>
+
+void
+MetricsRegistry::Snapshot::save(std::ostream& os) const
+{
+  for (const auto& [name, value] : counters) {
+    os << "counter " << name << ' ' << value << '\n';
+  }
+  for (const auto& [name, value] : gauges) {
+    os << "gauge " << name << ' ' << value << '\n';
+  }
+  for (const auto& [name, histogram] : histograms) {
+    os << "histogram " << name << ' ' << histogram.count << ' '
+       << histogram.sum.count() << ' ' << histogram.max.count();
+    for (auto n : histogram.buckets) {
+      os << ' ' << n;
+    }
+    os << '\n';
+  }
+}
+
+MetricsRegistry::Snapshot
+MetricsRegistry::Snapshot::load(std::istream& is)
+{
+  Snapshot snapshot;
+  std::string line;
+  size_t lineNo = 0;
+  while (std::getline(is, line)) {
+    ++lineNo;
+    if (line.empty()) {
+      continue;
+    }
+
+    std::istringstream iss(line);
+    std::string type, name;
+    iss >> type >> name;
+
+    bool isOk = false;
+    if (type == "counter") {
+      isOk = static_cast<bool>(iss >> snapshot.counters[name]);
+    }
+    else if (type == "gauge") {
+      isOk = static_cast<bool>(iss >> snapshot.gauges[name]);
+    }
+    else if (type == "histogram") {
+      auto& histogram = snapshot.histograms[name];
+      int64_t sum = 0, max = 0;
+      isOk = static_cast<bool>(iss >> histogram.count >> sum >> max);
+      histogram.sum = time::nanoseconds(sum);
+      histogram.max = time::nanoseconds(max);
+      for (auto& n : histogram.buckets) {
+        isOk = isOk && static_cast<bool>(iss >> n);
+      }
+    }
+
+    if (!isOk) {
+      NDN_THROW(Error("Malformed metrics snapshot at line " + std::to_string(lineNo)));
+    }
+  }
+  return snapshot;
+}
+
+std::ostream&
+operator<<(std::ostream& os, const MetricsRegistry::Snapshot& snapshot)
+{
+  size_t width = 0;
+  for (const auto& [name, value] : snapshot.counters) {
+    width = std::max(width, name.size());
+  }
+  for (const auto& [name, value] : snapshot.gauges) {
+    width = std::max(width, name.size());
+  }
+  for (const auto& [name, value] : snapshot.histograms) {
+    width = std::max(width, name.size());
+  }
+
+  auto print = [&] (const std::string& name, const auto& value) {
+    os << "  " << std::left << std::setw(width) << name << "  " << value << '\n';
+  };
+
+  os << "Counters:\n";
+  for (const auto& [name, value] : snapshot.counters) {
+    print(name, value);
+  }
+  os << "Gauges:\n";
+  for (const auto& [name, value] : snapshot.gauges) {
+    print(name, value);
+  }
+  os << "Latencies:\n";
+  for (const auto& [name, value] : snapshot.histograms) {
+    print(name, value);
+  }
+  return os;
+}
+
+} // namespace ndn::nac
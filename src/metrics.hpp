@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_METRICS_HPP
+#define NDN_NAC_METRICS_HPP
+
+#include "common.hpp"
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+
+namespace ndn::nac {
+
+/**
+ * @brief Monotonically increasing event counter
+ *
+ * All operations use relaxed atomics: the counter can be read from any thread (e.g., by a
+ * monitoring exporter) while being updated from the Face's thread, at the cost of a single
+ * uncontended atomic increment.
+ *
+ * A counter can additionally add its increments to a @p total counter, e.g., so that a
+ * per-instance counter is also reported into a MetricsRegistry.
+ */
+class Counter
+{
+public:
+  Counter() = default;
+
+  explicit
+  Counter(Counter& total) noexcept
+    : m_total(&total)
+  {
+  }
+
+  void
+  increment(uint64_t n = 1) noexcept
+  {
+    m_value.fetch_add(n, std::memory_order_relaxed);
+    if (m_total != nullptr) {
+      m_total->increment(n);
+    }
+  }
+
+  uint64_t
+  get() const noexcept
+  {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<uint64_t> m_value{0};
+  Counter* m_total = nullptr;
+};
+
+/**
+ * @brief Current value of a quantity that can go up and down (e.g., a queue depth)
+ *
+ * A gauge with a @p total gauge contributes its value to the total, until it is destroyed.
+ */
+class Gauge
+{
+public:
+  Gauge() = default;
+
+  explicit
+  Gauge(Gauge& total) noexcept
+    : m_total(&total)
+  {
+  }
+
+  ~Gauge()
+  {
+    if (m_total != nullptr) {
+      m_total->decrement(get());
+    }
+  }
+
+  void
+  increment(int64_t n = 1) noexcept
+  {
+    m_value.fetch_add(n, std::memory_order_relaxed);
+    if (m_total != nullptr) {
+      m_total->increment(n);
+    }
+  }
+
+  void
+  decrement(int64_t n = 1) noexcept
+  {
+    increment(-n);
+  }
+
+  void
+  set(int64_t value) noexcept
+  {
+    auto prev = m_value.exchange(value, std::memory_order_relaxed);
+    if (m_total != nullptr) {
+      m_total->increment(value - prev);
+    }
+  }
+
+  int64_t
+  get() const noexcept
+  {
+    return m_value.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<int64_t> m_value{0};
+  Gauge* m_total = nullptr;
+};
+
+/**
+ * @brief Latency histogram with power-of-two buckets
+ *
+ * Bucket `i` counts samples in the range `[2^i, 2^(i+1))` nanoseconds (bucket 0 also
+ * includes zero), and the last bucket additionally counts everything above its lower bound.
+ * Recording a sample takes a handful of relaxed atomic operations and never allocates.
+ * A histogram with a @p total histogram also records every sample into the total.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr size_t N_BUCKETS = 40; // last bucket starts at ~9 minutes
+
+  LatencyHistogram() = default;
+
+  explicit
+  LatencyHistogram(LatencyHistogram& total) noexcept
+    : m_total(&total)
+  {
+  }
+
+  struct Snapshot
+  {
+    std::array<uint64_t, N_BUCKETS> buckets{};
+    uint64_t count = 0;
+    time::nanoseconds sum{0};
+    time::nanoseconds max{0};
+
+    /**
+     * @brief Return the upper bound of the bucket containing the @p p -th quantile
+     * @param p quantile in the range [0, 1]
+     */
+    time::nanoseconds
+    getQuantile(double p) const;
+
+    time::nanoseconds
+    getMean() const
+    {
+      return count == 0 ? time::nanoseconds(0) : time::nanoseconds(sum.count() / static_cast<int64_t>(count));
+    }
+  };
+
+  void
+  record(time::nanoseconds latency) noexcept;
+
+  Snapshot
+  getSnapshot() const;
+
+  /**
+   * @brief Return the lower bound of bucket @p index
+   */
+  static constexpr time::nanoseconds
+  getBucketLowerBound(size_t index) noexcept
+  {
+    return time::nanoseconds(index == 0 ? 0 : int64_t(1) << index);
+  }
+
+private:
+  std::array<std::atomic<uint64_t>, N_BUCKETS> m_buckets{};
+  std::atomic<uint64_t> m_count{0};
+  std::atomic<int64_t> m_sum{0};
+  std::atomic<int64_t> m_max{0};
+  LatencyHistogram* m_total = nullptr;
+};
+
+std::ostream&
+operator<<(std::ostream& os, const LatencyHistogram::Snapshot& snapshot);
+
+/**
+ * @brief Process-wide collection of named counters, gauges, and latency histograms
+ *
+ * Components look up their metrics once (e.g., at construction) and afterwards update them
+ * through the returned references without any locking.  Only the lookup of a metric and
+ * taking a snapshot acquire a mutex.  A metric lives as long as the registry, and multiple
+ * instances of a component that use the same name aggregate into the same metric.
+ */
+class MetricsRegistry : noncopyable
+{
+public:
+  struct Snapshot
+  {
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, int64_t> gauges;
+    std::map<std::string, LatencyHistogram::Snapshot> histograms;
+
+    /**
+     * @brief Write the snapshot in a line-based format that can be read back with load()
+     */
+    void
+    save(std::ostream& os) const;
+
+    /**
+     * @brief Read a snapshot written by save()
+     * @throw Error input is malformed
+     */
+    static Snapshot
+    load(std::istream& is);
+  };
+
+  /**
+   * @brief Registry used by Encryptor and AccessManager
+   */
+  static MetricsRegistry&
+  getDefault();
+
+  Counter&
+  getCounter(const std::string& name);
+
+  Gauge&
+  getGauge(const std::string& name);
+
+  LatencyHistogram&
+  getHistogram(const std::string& name);
+
+  Snapshot
+  getSnapshot() const;
+
+private:
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::unique_ptr<Counter>> m_counters;
+  std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+  std::map<std::string, std::unique_ptr<LatencyHistogram>> m_histograms;
+};
+
+/**
+ * @brief Print @p snapshot in human-readable form
+ */
+std::ostream&
+operator<<(std::ostream& os, const MetricsRegistry::Snapshot& snapshot);
+
+} // namespace ndn::nac
+
+#endif // NDN_NAC_METRICS_HPP
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "secure-memory.hpp"
+
+#include <ndn-cxx/util/logger.hpp>
+
+#include <openssl/crypto.h>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace ndn::nac {
+
+NDN_LOG_INIT(nac.SecureMemory);
+
+static std::atomic<size_t> g_defaultArenaSize{SecureArena::DEFAULT_SIZE};
+static std::atomic<bool> g_hasDefaultArena{false};
+
+SecureArena::SecureArena(size_t size)
+  : m_nExhaustions(MetricsRegistry::getDefault().getCounter("nac.SecureArena.nExhaustions"))
+{
+  if (size == 0) {
+    return;
+  }
+
+  auto pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  m_mappedSize = (size + pageSize - 1) / pageSize * pageSize;
+  void* p = ::mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    NDN_LOG_WARN("Cannot map " << m_mappedSize << " bytes for key material: " << std::strerror(errno)
+                 << "; key material will be allocated from the heap");
+    m_mappedSize = 0;
+    return;
+  }
+
+  m_begin = static_cast<uint8_t*>(p);
+  m_isLocked = ::mlock(m_begin, m_mappedSize) == 0;
+  if (!m_isLocked) {
+    NDN_LOG_WARN("Cannot lock " << m_mappedSize << " bytes for key material: " << std::strerror(errno)
+                 << "; key material may be swapped to disk");
+  }
+#ifdef MADV_DONTDUMP
+  ::madvise(m_begin, m_mappedSize, MADV_DONTDUMP);
+#endif
+
+  m_nSmallSlots = m_mappedSize / 2 / SMALL_SLOT_SIZE;
+  m_largeBegin = m_begin + m_nSmallSlots * SMALL_SLOT_SIZE;
+  m_nLargeSlots = (m_mappedSize - m_nSmallSlots * SMALL_SLOT_SIZE) / LARGE_SLOT_SIZE;
+
+  m_freeSmallSlots.reserve(m_nSmallSlots);
+  for (size_t i = m_nSmallSlots; i > 0; --i) {
+    m_freeSmallSlots.push_back(m_begin + (i - 1) * SMALL_SLOT_SIZE);
+  }
+  m_freeLargeSlots.reserve(m_nLargeSlots);
+  for (size_t i = m_nLargeSlots; i > 0; --i) {
+    m_freeLargeSlots.push_back(m_largeBegin + (i - 1) * LARGE_SLOT_SIZE);
+  }
+}
+
+SecureArena::~SecureArena()
+{
+  if (m_begin != nullptr) {
+    OPENSSL_cleanse(m_begin, m_mappedSize);
+    if (m_isLocked) {
+      ::munlock(m_begin, m_mappedSize);
+    }
+    ::munmap(m_begin, m_mappedSize);
+  }
+}
+
+SecureArena&
+SecureArena::getDefault()
+{
+  // intentionally leaked, as SecureBuffers in other static objects may outlive any local static
+  static auto arena = [] {
+    g_hasDefaultArena = true;
+    return new SecureArena(g_defaultArenaSize);
+  }();
+  return *arena;
+}
+
+void
+SecureArena::setDefaultSize(size_t size)
+{
+  if (g_hasDefaultArena) {
+    NDN_THROW(Error("The default SecureArena has already been created"));
+  }
+  g_defaultArenaSize = size;
+}
+
+uint8_t*
+SecureArena::allocate(size_t size)
+{
+  if (size <= LARGE_SLOT_SIZE) {
+    bool isFirstExhaustion = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      // small requests spill over into large slots before going to the heap
+      auto* freeSlots = size <= SMALL_SLOT_SIZE && !m_freeSmallSlots.empty() ? &m_freeSmallSlots
+                                                                             : &m_freeLargeSlots;
+      if (!freeSlots->empty()) {
+        auto slot = freeSlots->back();
+        freeSlots->pop_back();
+        return slot;
+      }
+      isFirstExhaustion = !std::exchange(m_hasWarnedExhaustion, true);
+    }
+
+    m_nExhaustions.increment();
+    if (isFirstExhaustion && getNSlots() > 0) {
+      NDN_LOG_WARN("All " << getNSlots() << " slots for key material are in use, allocating from the heap;"
+                   " consider raising SecureArena::setDefaultSize()");
+    }
+  }
+
+  NDN_LOG_TRACE("Allocating " << size << " bytes of key material from the heap");
+  return static_cast<uint8_t*>(::operator new(size));
+}
+
+void
+SecureArena::deallocate(uint8_t* p, size_t size) noexcept
+{
+  if (p == nullptr) {
+    return;
+  }
+
+  auto addr = reinterpret_cast<uintptr_t>(p);
+  auto begin = reinterpret_cast<uintptr_t>(m_begin);
+  auto largeBegin = reinterpret_cast<uintptr_t>(m_largeBegin);
+  if (m_begin != nullptr && addr >= begin && addr < largeBegin) {
+    OPENSSL_cleanse(p, SMALL_SLOT_SIZE);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeSmallSlots.push_back(p);
+  }
+  else if (m_begin != nullptr && addr >= largeBegin && addr < begin + m_mappedSize) {
+    OPENSSL_cleanse(p, LARGE_SLOT_SIZE);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_freeLargeSlots.push_back(p);
+  }
+  else {
+    OPENSSL_cleanse(p, size);
+    ::operator delete(p);
+  }
+}
+
+size_t
+SecureArena::getNFreeSlots() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_freeSmallSlots.size() + m_freeLargeSlots.size();
+}
+
+SecureBuffer::SecureBuffer(size_t size)
+  : m_size(size)
+  , m_capacity(size)
+{
+  if (size > 0) {
+    m_data = SecureArena::getDefault().allocate(size);
+    std::memset(m_data, 0, size);
+  }
+}
+
+SecureBuffer::SecureBuffer(span<const uint8_t> bytes)
+  : SecureBuffer(bytes.size())
+{
+  std::copy(bytes.begin(), bytes.end(), m_data);
+}
+
+SecureBuffer::SecureBuffer(SecureBuffer&& other) noexcept
+  : m_data(std::exchange(other.m_data, nullptr))
+  , m_size(std::exchange(other.m_size, 0))
+  , m_capacity(std::exchange(other.m_capacity, 0))
+{
+}
+
+SecureBuffer&
+SecureBuffer::operator=(SecureBuffer&& other) noexcept
+{
+  if (this != &other) {
+    SecureArena::getDefault().deallocate(m_data, m_capacity);
+    m_data = std::exchange(other.m_data, nullptr);
+    m_size = std::exchange(other.m_size, 0);
+    m_capacity = std::exchange(other.m_capacity, 0);
+  }
+  return *this;
+}
+
+SecureBuffer::~SecureBuffer()
+{
+  SecureArena::getDefault().deallocate(m_data, m_capacity);
+}
+
+} // namespace ndn::nac
@@ -0,0 +1,246 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NDN_NAC_SECURE_MEMORY_HPP
+#define NDN_NAC_SECURE_MEMORY_HPP
+
+#include "common.hpp"
+#include "metrics.hpp"
+
+#include <mutex>
+
+namespace ndn::nac {
+
+/**
+ * @brief Pool of fixed-size slots in locked memory for key material
+ *
+ * The pool is allocated once as anonymous pages that are locked into physical memory
+ * (so that they are never written to swap) and, where supported, excluded from core dumps.
+ * Half of the pool is cut into SMALL_SLOT_SIZE slots, which fit the AES-256 keys (CKs, node
+ * keys) that make up most key material, and the other half into LARGE_SLOT_SIZE slots for
+ * KDK secrets and ECDH shared secrets.  A request takes the smallest free slot that fits it;
+ * allocating and releasing a slot only pushes and pops a free list, and every slot is wiped
+ * when released.  If the pages cannot be locked (e.g., because of RLIMIT_MEMLOCK), the pool
+ * is still used and a warning is logged.  Requests larger than a slot, or made while all
+ * fitting slots are in use, are served from the heap, and are wiped when released as well;
+ * the latter is logged once as a warning and counted in `nac.SecureArena.nExhaustions`.
+ *
+ * The arena covers key material held in SecureBuffer only.  In particular, the expanded key
+ * schedule of a CK (Encryptor's current CK, each CK retrieved by Decryptor, see
+ * detail::AesCbcCipher) lives in a cipher context that OpenSSL allocates from the ordinary
+ * heap: it is wiped when the CK is released, but is neither locked nor excluded from core
+ * dumps, and the CK can be recovered from it.  OpenSSL's own secure heap does not help here,
+ * as it only serves big numbers and private keys, not cipher contexts.
+ *
+ * All operations are thread-safe.
+ */
+class SecureArena : noncopyable
+{
+public:
+  static constexpr size_t SMALL_SLOT_SIZE = 32;
+  static constexpr size_t LARGE_SLOT_SIZE = 128;
+  static constexpr size_t DEFAULT_SIZE = 32 * 1024; // below the usual 64 KiB RLIMIT_MEMLOCK
+
+  /**
+   * @param size minimum size of the pool in octets; it is rounded up to whole pages
+   */
+  explicit
+  SecureArena(size_t size = DEFAULT_SIZE);
+
+  ~SecureArena();
+
+  /**
+   * @brief Arena used by SecureBuffer, created on first use and never destroyed
+   */
+  static SecureArena&
+  getDefault();
+
+  /**
+   * @brief Set the size of the pool of getDefault(), DEFAULT_SIZE if not set
+   *
+   * Applications that hold many keys at once (e.g., a Decryptor with thousands of retrieved
+   * CKs) should call this at startup, and raise RLIMIT_MEMLOCK accordingly.
+   * @throw Error the default arena has already been created
+   */
+  static void
+  setDefaultSize(size_t size);
+
+  /**
+   * @brief Allocate @p size bytes
+   * @throw std::bad_alloc
+   */
+  uint8_t*
+  allocate(size_t size);
+
+  /**
+   * @brief Wipe and release @p size bytes at @p p, previously returned by allocate(size)
+   */
+  void
+  deallocate(uint8_t* p, size_t size) noexcept;
+
+  /**
+   * @brief Size of the pool in octets
+   */
+  size_t
+  getSize() const noexcept
+  {
+    return m_mappedSize;
+  }
+
+  size_t
+  getNSlots() const noexcept
+  {
+    return m_nSmallSlots + m_nLargeSlots;
+  }
+
+  size_t
+  getNFreeSlots() const;
+
+  /**
+   * @brief Number of requests that fit a slot but were served from the heap, as all fitting
+   *        slots were in use
+   */
+  uint64_t
+  getNExhaustions() const noexcept
+  {
+    return m_nExhaustions.get();
+  }
+
+  /**
+   * @brief Whether the pool is locked into memory
+   */
+  bool
+  isLocked() const noexcept
+  {
+    return m_isLocked;
+  }
+
+private:
+  uint8_t* m_begin = nullptr;
+  uint8_t* m_largeBegin = nullptr; // small slots precede large slots
+  size_t m_mappedSize = 0;
+  size_t m_nSmallSlots = 0;
+  size_t m_nLargeSlots = 0;
+  bool m_isLocked = false;
+
+  mutable std::mutex m_mutex;
+  // never reallocated after construction
+  std::vector<uint8_t*> m_freeSmallSlots;
+  std::vector<uint8_t*> m_freeLargeSlots;
+  bool m_hasWarnedExhaustion = false;
+  Counter m_nExhaustions;
+};
+
+/**
+ * @brief Buffer for key material, allocated from SecureArena::getDefault() and wiped on release
+ *
+ * The size is fixed at construction; the buffer can be moved, but not copied.
+ */
+class SecureBuffer
+{
+public:
+  SecureBuffer() noexcept = default;
+
+  /**
+   * @brief Create a zero-filled buffer of @p size bytes
+   */
+  explicit
+  SecureBuffer(size_t size);
+
+  /**
+   * @brief Create a buffer with a copy of @p bytes
+   */
+  explicit
+  SecureBuffer(span<const uint8_t> bytes);
+
+  SecureBuffer(SecureBuffer&& other) noexcept;
+
+  SecureBuffer&
+  operator=(SecureBuffer&& other) noexcept;
+
+  ~SecureBuffer();
+
+  uint8_t*
+  data() noexcept
+  {
+    return m_data;
+  }
+
+  const uint8_t*
+  data() const noexcept
+  {
+    return m_data;
+  }
+
+  size_t
+  size() const noexcept
+  {
+    return m_size;
+  }
+
+  bool
+  empty() const noexcept
+  {
+    return m_size == 0;
+  }
+
+  uint8_t*
+  begin() noexcept
+  {
+    return m_data;
+  }
+
+  uint8_t*
+  end() noexcept
+  {
+    return m_data + m_size;
+  }
+
+  const uint8_t*
+  begin() const noexcept
+  {
+    return m_data;
+  }
+
+  const uint8_t*
+  end() const noexcept
+  {
+    return m_data + m_size;
+  }
+
+  /**
+   * @brief Shrink the buffer to @p size bytes
+   * @pre @p size does not exceed the size at construction
+   */
+  void
+  shrink(size_t size) noexcept
+  {
+    BOOST_ASSERT(size <= m_capacity);
+    m_size = size;
+  }
+
+private:
+  uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+  size_t m_capacity = 0;
+};
+
+} // namespace ndn::nac
+
+#endif // NDN_NAC_SECURE_MEMORY_HPP
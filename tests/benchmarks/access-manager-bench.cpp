@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "access-manager.hpp"
+#include "detail/serving-index.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+#include "tests/benchmarks/benchmark-report.hpp"
+
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+namespace ndn::nac::tests {
+
+class AccessManagerBenchFixture : public KeyChainFixture
+{
+public:
+  boost::asio::io_context io; // never run, KDKs are returned directly by addMember
+  DummyClientFace face{io, m_keyChain, {false, true}};
+  Identity accessIdentity = m_keyChain.createIdentity("/access/policy/identity");
+  Identity memberIdentity = m_keyChain.createIdentity("/member", RsaKeyParams());
+};
+
+BOOST_FIXTURE_TEST_SUITE(AccessManagerBench, AccessManagerBenchFixture)
+
+BOOST_AUTO_TEST_CASE(Construct)
+{
+  constexpr size_t N_ITERATIONS = 5;
+
+  // each iteration uses a new dataset, so that the NAC key has to be generated every time
+  size_t i = 0;
+  measure("AccessManager::AccessManager", {}, N_ITERATIONS, [&] {
+    AccessManager manager(accessIdentity, Name("/dataset").appendNumber(i++), m_keyChain, face);
+    BOOST_CHECK_EQUAL(manager.size(), 1);
+  });
+}
+
+BOOST_AUTO_TEST_CASE(AddMember)
+{
+  constexpr size_t N_ITERATIONS = 100;
+
+  AccessManager manager(accessIdentity, "/dataset", m_keyChain, face);
+  auto memberCert = memberIdentity.getDefaultKey().getDefaultCertificate();
+
+  size_t totalSize = 0;
+  measure("AccessManager::addMember", {}, N_ITERATIONS, [&] {
+    totalSize += manager.addMember(memberCert).wireEncode().size();
+  });
+  BOOST_CHECK_GT(totalSize, 0);
+}
+
+BOOST_AUTO_TEST_CASE(AddMembers)
+{
+  constexpr size_t N_ITERATIONS = 5;
+  constexpr size_t N_MEMBERS = 100;
+
+  std::vector<Certificate> memberCerts;
+  for (size_t i = 0; i < N_MEMBERS; ++i) {
+    auto identity = m_keyChain.createIdentity(Name("/member").appendNumber(i), EcKeyParams());
+    memberCerts.push_back(identity.getDefaultKey().getDefaultCertificate());
+  }
+
+  for (bool isBatchSigning : {false, true}) {
+    AccessManager manager(accessIdentity, "/dataset", m_keyChain, face);
+    manager.setBatchSigning(isBatchSigning);
+
+    size_t totalSize = 0;
+    measure("AccessManager::addMembers", {{"n_members", N_MEMBERS}, {"batch_signing", isBatchSigning}},
+            N_ITERATIONS, [&] {
+      for (const auto& kdk : manager.addMembers(memberCerts)) {
+        totalSize += kdk.wireEncode().size();
+      }
+    });
+    BOOST_CHECK_GT(totalSize, 0);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Serve)
+{
+  constexpr size_t N_ITERATIONS = 100000;
+  constexpr size_t N_MEMBERS = 1000;
+
+  // the KEK and the KDKs of a dataset with many members
+  const Name nacPrefix("/access/policy/identity/NAC/dataset");
+  InMemoryStoragePersistent ims;
+  detail::ServingIndex index;
+  auto publish = [&] (const Name& name) {
+    auto data = std::make_shared<Data>(name);
+    data->setContent(std::vector<uint8_t>(300));
+    m_keyChain.sign(*data, signingWithSha256());
+    ims.insert(*data);
+    index.insert(data);
+  };
+
+  publish(Name(nacPrefix).append(KEK).append("key-id"));
+  std::vector<Interest> kdkInterests;
+  for (size_t i = 0; i < N_MEMBERS; ++i) {
+    Name kdkName(nacPrefix);
+    kdkName.append(KDK).append("key-id").append(ENCRYPTED_BY)
+           .append("member").appendNumber(i).append("KEY").append("member-key-id");
+    publish(kdkName);
+    kdkInterests.emplace_back(kdkName);
+  }
+  Interest kekInterest(Name(nacPrefix).append(KEK));
+  kekInterest.setCanBePrefix(true);
+
+  size_t i = 0;
+  size_t nFound = 0;
+  measure("InMemoryStoragePersistent::find(KDK)", {{"n_members", N_MEMBERS}}, N_ITERATIONS, [&] {
+    nFound += ims.find(kdkInterests[i++ % N_MEMBERS]) != nullptr;
+  });
+  measure("detail::ServingIndex::find(KDK)", {{"n_members", N_MEMBERS}}, N_ITERATIONS, [&] {
+    nFound += index.find(kdkInterests[i++ % N_MEMBERS]) != nullptr;
+  });
+  measure("InMemoryStoragePersistent::find(KEK)", {{"n_members", N_MEMBERS}}, N_ITERATIONS, [&] {
+    nFound += ims.find(kekInterest) != nullptr;
+  });
+  measure("detail::ServingIndex::find(KEK)", {{"n_members", N_MEMBERS}}, N_ITERATIONS, [&] {
+    nFound += index.find(kekInterest) != nullptr;
+  });
+  BOOST_CHECK_EQUAL(nFound, 4 * N_ITERATIONS);
+}
+
+BOOST_AUTO_TEST_SUITE_END() // AccessManagerBench
+
+} // namespace ndn::nac::tests
@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NAC_TESTS_BENCHMARKS_BENCHMARK_ACCESS_HPP
+#define NAC_TESTS_BENCHMARKS_BENCHMARK_ACCESS_HPP
+
+#include "decryptor.hpp"
+#include "encryptor.hpp"
+
+namespace ndn::nac::tests {
+
+/**
+ * @brief Access to the internal stages of Decryptor and Encryptor that are benchmarked in isolation
+ *
+ * Benchmarks are built against the library as it is shipped, i.e., without NAC_WITH_TESTS,
+ * so they cannot use the private members directly.
+ */
+class BenchmarkAccess
+{
+public:
+  using ContentKey = Decryptor::ContentKey;
+  using ContentKeys = Decryptor::ContentKeys;
+
+  static ConstBufferPtr
+  doDecrypt(const EncryptedContent& encryptedContent, detail::AesCbcCipher& cipher)
+  {
+    return Decryptor::doDecrypt(encryptedContent, cipher);
+  }
+
+  static ContentKeys&
+  getCks(Decryptor& decryptor)
+  {
+    return decryptor.m_cks;
+  }
+
+  static KeyChain&
+  getInternalKeyChain(Decryptor& decryptor)
+  {
+    return decryptor.m_internalKeyChain;
+  }
+
+  static bool
+  decryptAndImportKdk(Decryptor& decryptor, const Data& kdkData, const ErrorCallback& onFailure)
+  {
+    return decryptor.decryptAndImportKdk(kdkData, onFailure);
+  }
+
+  static void
+  decryptCk(Decryptor& decryptor, ContentKeys::iterator ck, const Data& ckData,
+            const Name& kdkKeyName, const ErrorCallback& onFailure)
+  {
+    decryptor.decryptCkAndProcessPendingDecrypts(ck, ckData, kdkKeyName, onFailure);
+  }
+
+  static void
+  setKek(Encryptor& encryptor, const Data& kek)
+  {
+    encryptor.m_kek = kek;
+  }
+
+  static size_t
+  getCkPoolSize(const Encryptor& encryptor)
+  {
+    return encryptor.m_ckPool.size();
+  }
+
+  static bool
+  makeAndPublishCkData(Encryptor& encryptor, const ErrorCallback& onFailure)
+  {
+    return encryptor.makeAndPublishCkData(onFailure);
+  }
+};
+
+} // namespace ndn::nac::tests
+
+#endif // NAC_TESTS_BENCHMARKS_BENCHMARK_ACCESS_HPP
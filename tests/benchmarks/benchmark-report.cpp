@@ -0,0 +1,115 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "tests/benchmarks/benchmark-report.hpp"
+
+#include "version.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <ostream>
+
+namespace ndn::nac::tests {
+
+BenchmarkReport&
+BenchmarkReport::get()
+{
+  static BenchmarkReport instance;
+  return instance;
+}
+
+void
+BenchmarkReport::add(const std::string& name, const Parameters& params,
+                     std::vector<std::chrono::nanoseconds> samples)
+{
+  Result result;
+  result.name = name;
+  result.params = params;
+  result.iterations = samples.size();
+
+  if (!samples.empty()) {
+    std::sort(samples.begin(), samples.end());
+    result.total = std::accumulate(samples.begin(), samples.end(), std::chrono::nanoseconds(0));
+    result.min = samples.front();
+    result.p50 = samples[samples.size() / 2];
+    result.p99 = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    result.max = samples.back();
+  }
+
+  m_results.push_back(std::move(result));
+}
+
+static void
+writeJsonString(std::ostream& os, const std::string& str)
+{
+  os << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      os << '\\';
+    }
+    os << c;
+  }
+  os << '"';
+}
+
+void
+BenchmarkReport::writeJson(std::ostream& os) const
+{
+  os << "{\n"
+     << "  \"library\": \"ndn-nac\",\n"
+     << "  \"version\": ";
+  writeJsonString(os, NDN_NAC_VERSION_BUILD_STRING);
+  os << ",\n"
+     << "  \"benchmarks\": [";
+
+  bool isFirst = true;
+  for (const auto& result : m_results) {
+    os << (isFirst ? "\n" : ",\n");
+    isFirst = false;
+
+    os << "    {\"name\": ";
+    writeJsonString(os, result.name);
+    os << ", \"params\": {";
+    for (size_t i = 0; i < result.params.size(); ++i) {
+      os << (i > 0 ? ", " : "");
+      writeJsonString(os, result.params[i].first);
+      os << ": " << result.params[i].second;
+    }
+    os << "}";
+
+    auto mean = result.iterations > 0 ? result.total.count() / result.iterations : 0;
+    auto opsPerSec = result.total.count() > 0 ?
+                     static_cast<double>(result.iterations) * 1e9 / result.total.count() : 0.0;
+
+    os << ", \"iterations\": " << result.iterations
+       << ", \"total_ns\": " << result.total.count()
+       << ", \"mean_ns\": " << mean
+       << ", \"min_ns\": " << result.min.count()
+       << ", \"p50_ns\": " << result.p50.count()
+       << ", \"p99_ns\": " << result.p99.count()
+       << ", \"max_ns\": " << result.max.count()
+       << ", \"ops_per_sec\": " << opsPerSec
+       << "}";
+  }
+
+  os << "\n  ]\n"
+     << "}\n";
+}
+
+} // namespace ndn::nac::tests
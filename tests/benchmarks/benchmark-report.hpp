@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#ifndef NAC_TESTS_BENCHMARKS_BENCHMARK_REPORT_HPP
+#define NAC_TESTS_BENCHMARKS_BENCHMARK_REPORT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ndn::nac::tests {
+
+/**
+ * @brief Collects latency samples of benchmarked operations and writes them out as JSON.
+ *
+ * Wall-clock time is measured with std::chrono::steady_clock directly, so that the results
+ * are not affected by the mock clocks used in unit tests.
+ */
+class BenchmarkReport
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using Parameters = std::vector<std::pair<std::string, uint64_t>>;
+
+  struct Result
+  {
+    std::string name;
+    Parameters params;
+    size_t iterations = 0;
+    std::chrono::nanoseconds total{0};
+    std::chrono::nanoseconds min{0};
+    std::chrono::nanoseconds p50{0};
+    std::chrono::nanoseconds p99{0};
+    std::chrono::nanoseconds max{0};
+  };
+
+  static BenchmarkReport&
+  get();
+
+  /**
+   * @brief Record per-iteration latency @p samples of the operation @p name
+   */
+  void
+  add(const std::string& name, const Parameters& params,
+      std::vector<std::chrono::nanoseconds> samples);
+
+  const std::vector<Result>&
+  getResults() const
+  {
+    return m_results;
+  }
+
+  /**
+   * @brief Write all recorded results as a JSON document
+   */
+  void
+  writeJson(std::ostream& os) const;
+
+private:
+  std::vector<Result> m_results;
+};
+
+/**
+ * @brief Execute @p f @p nIterations times and record the latency of each invocation
+ */
+template<typename F>
+void
+measure(const std::string& name, const BenchmarkReport::Parameters& params,
+        size_t nIterations, F&& f)
+{
+  std::vector<std::chrono::nanoseconds> samples;
+  samples.reserve(nIterations);
+
+  for (size_t i = 0; i < nIterations; ++i) {
+    auto before = BenchmarkReport::Clock::now();
+    f();
+    auto after = BenchmarkReport::Clock::now();
+    samples.push_back(after - before);
+  }
+
+  BenchmarkReport::get().add(name, params, std::move(samples));
+}
+
+} // namespace ndn::nac::tests
+
+#endif // NAC_TESTS_BENCHMARKS_BENCHMARK_REPORT_HPP
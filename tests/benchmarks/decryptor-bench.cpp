@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "decryptor.hpp"
+#include "detail/aes-cbc-cipher.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+#include "tests/benchmarks/benchmark-access.hpp"
+#include "tests/benchmarks/benchmark-report.hpp"
+#include "tests/unit/static-data.hpp"
+
+#include <ndn-cxx/security/transform/block-cipher.hpp>
+#include <ndn-cxx/security/transform/buffer-source.hpp>
+#include <ndn-cxx/security/transform/stream-sink.hpp>
+#include <ndn-cxx/security/validator-null.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+namespace ndn::nac::tests {
+
+class DecryptorBenchFixture : public KeyChainFixture
+{
+public:
+  DecryptorBenchFixture()
+  {
+    // import "/first/user" identity, which is authorized by the static KDK packets
+    m_keyChain.importSafeBag(SafeBag(data.userIdentities.at(0)), "password", strlen("password"));
+    decryptor.emplace(m_keyChain.getPib().getIdentity("/first/user").getDefaultKey(),
+                      validator, m_keyChain, face);
+  }
+
+public:
+  StaticData data;
+  boost::asio::io_context io; // never run, all packets are supplied directly
+  DummyClientFace face{io, m_keyChain, {false, false}};
+  security::ValidatorNull validator;
+  std::optional<Decryptor> decryptor;
+};
+
+BOOST_FIXTURE_TEST_SUITE(DecryptorBench, DecryptorBenchFixture)
+
+BOOST_AUTO_TEST_CASE(DoDecrypt)
+{
+  const std::vector<size_t> payloadSizes{64, 1024, 8192, 65536};
+  constexpr size_t N_ITERATIONS = 20000;
+
+  Buffer ckBits(AES_KEY_SIZE);
+  random::generateSecureBytes(ckBits);
+  detail::AesCbcCipher cipher(ckBits, CipherOperator::DECRYPT);
+
+  for (size_t size : payloadSizes) {
+    Buffer plaintext(size);
+    auto iv = std::make_shared<Buffer>(AES_IV_SIZE);
+    random::generateSecureBytes(*iv);
+
+    OBufferStream os;
+    security::transform::bufferSource(plaintext)
+      >> security::transform::blockCipher(BlockCipherAlgorithm::AES_CBC,
+                                          CipherOperator::ENCRYPT, ckBits, *iv)
+      >> security::transform::streamSink(os);
+
+    EncryptedContent content;
+    content.setIv(iv);
+    content.setPayload(os.buf());
+
+    size_t totalSize = 0;
+    measure("Decryptor::doDecrypt", {{"payload_size", size}}, N_ITERATIONS, [&] {
+      totalSize += BenchmarkAccess::doDecrypt(content, cipher)->size();
+    });
+    BOOST_CHECK_EQUAL(totalSize, size * N_ITERATIONS);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CipherHandle)
+{
+  // small payloads, where the per-call key expansion and allocations of a transform chain dominate
+  const std::vector<size_t> payloadSizes{16, 64, 256};
+  constexpr size_t N_ITERATIONS = 100000;
+
+  Buffer ckBits(AES_KEY_SIZE);
+  random::generateSecureBytes(ckBits);
+  Buffer iv(AES_IV_SIZE);
+  random::generateSecureBytes(iv);
+  detail::AesCbcCipher encryptor(ckBits, CipherOperator::ENCRYPT);
+  detail::AesCbcCipher decryptor(ckBits, CipherOperator::DECRYPT);
+
+  for (size_t size : payloadSizes) {
+    Buffer plaintext(size);
+    auto ciphertext = encryptor.process(iv, plaintext);
+    Buffer output(encryptor.getMaxOutputSize(size));
+
+    for (auto op : {CipherOperator::ENCRYPT, CipherOperator::DECRYPT}) {
+      const auto& input = op == CipherOperator::ENCRYPT ? plaintext : *ciphertext;
+      auto& cipher = op == CipherOperator::ENCRYPT ? encryptor : decryptor;
+      std::string opName = op == CipherOperator::ENCRYPT ? "encrypt" : "decrypt";
+
+      size_t chainSize = 0;
+      measure("transform::blockCipher/" + opName, {{"payload_size", size}}, N_ITERATIONS, [&] {
+        OBufferStream os;
+        security::transform::bufferSource(input)
+          >> security::transform::blockCipher(BlockCipherAlgorithm::AES_CBC, op, ckBits, iv)
+          >> security::transform::streamSink(os);
+        chainSize += os.buf()->size();
+      });
+
+      size_t handleSize = 0;
+      measure("detail::AesCbcCipher/" + opName, {{"payload_size", size}}, N_ITERATIONS, [&] {
+        handleSize += cipher.process(iv, input, output);
+      });
+      BOOST_CHECK_EQUAL(handleSize, chainSize);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(UnwrapChain)
+{
+  constexpr size_t N_ITERATIONS = 50;
+
+  // CK data references the KEK, which determines KDK name and the KDK key name in the internal KeyChain
+  Data ckData(data.encryptorPackets.at(0));
+  auto ckName = ckData.getName().getPrefix(5);
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  auto [kdkPrefix, kdkIdentity, kdkKeyName] = extractKdkInfoFromCkName(ckData.getName(), ckName, onFailure);
+
+  Name kdkName = kdkPrefix;
+  kdkName
+    .append(ENCRYPTED_BY)
+    .append(m_keyChain.getPib().getIdentity("/first/user").getDefaultKey().getName());
+
+  std::optional<Data> kdkData;
+  for (const auto& block : data.managerPackets) {
+    Data packet(block);
+    if (packet.getName() == kdkName) {
+      kdkData = packet;
+    }
+  }
+  BOOST_REQUIRE(kdkData);
+
+  auto ck = BenchmarkAccess::getCks(*decryptor).emplace(ckName, BenchmarkAccess::ContentKey{}).first;
+  auto& internalKeyChain = BenchmarkAccess::getInternalKeyChain(*decryptor);
+
+  std::vector<std::chrono::nanoseconds> kdkSamples;
+  std::vector<std::chrono::nanoseconds> ckSamples;
+  std::vector<std::chrono::nanoseconds> chainSamples;
+  for (size_t i = 0; i < N_ITERATIONS; ++i) {
+    // each round starts without the KDK in the internal KeyChain
+    if (internalKeyChain.getPib().getIdentities().find(kdkIdentity) !=
+        internalKeyChain.getPib().getIdentities().end()) {
+      internalKeyChain.deleteIdentity(internalKeyChain.getPib().getIdentity(kdkIdentity));
+    }
+    ck->second.isRetrieved = false;
+
+    auto t1 = BenchmarkReport::Clock::now();
+    BOOST_REQUIRE(BenchmarkAccess::decryptAndImportKdk(*decryptor, *kdkData, onFailure));
+    auto t2 = BenchmarkReport::Clock::now();
+    BenchmarkAccess::decryptCk(*decryptor, ck, ckData, kdkKeyName, onFailure);
+    auto t3 = BenchmarkReport::Clock::now();
+    BOOST_REQUIRE(ck->second.isRetrieved);
+
+    kdkSamples.push_back(t2 - t1);
+    ckSamples.push_back(t3 - t2);
+    chainSamples.push_back(t3 - t1);
+  }
+
+  BenchmarkReport::get().add("Decryptor::decryptAndImportKdk", {}, std::move(kdkSamples));
+  BenchmarkReport::get().add("Decryptor::decryptCk", {}, std::move(ckSamples));
+  BenchmarkReport::get().add("Decryptor::unwrapChain", {}, std::move(chainSamples));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // DecryptorBench
+
+} // namespace ndn::nac::tests
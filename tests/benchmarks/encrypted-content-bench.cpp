@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "encrypted-content.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/benchmarks/benchmark-report.hpp"
+
+namespace ndn::nac::tests {
+
+BOOST_AUTO_TEST_SUITE(EncryptedContentBench)
+
+const std::vector<size_t> PAYLOAD_SIZES{64, 1024, 8192, 65536};
+constexpr size_t N_ITERATIONS = 100000;
+const Name CK_NAME("/some/fairly/long/ck/prefix/for/the/benchmark/CK/%FD%00%00%01%49%9D%59%8C%AA");
+
+BOOST_AUTO_TEST_CASE(Encode)
+{
+  auto iv = std::make_shared<Buffer>(AES_IV_SIZE);
+  for (size_t size : PAYLOAD_SIZES) {
+    auto payload = std::make_shared<Buffer>(size);
+
+    size_t totalSize = 0;
+    measure("EncryptedContent::wireEncode", {{"payload_size", size}}, N_ITERATIONS, [&] {
+      EncryptedContent content;
+      content.setIv(iv);
+      content.setPayload(payload);
+      content.setKeyLocator(CK_NAME);
+      totalSize += content.wireEncode().size();
+    });
+    BOOST_CHECK_GT(totalSize, size * N_ITERATIONS);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EncodeWithKeyLocatorWire)
+{
+  // as done by Encryptor, which encodes the name of its current CK only once
+  auto iv = std::make_shared<Buffer>(AES_IV_SIZE);
+  const Block ckNameWire = CK_NAME.wireEncode();
+  for (size_t size : PAYLOAD_SIZES) {
+    auto payload = std::make_shared<Buffer>(size);
+
+    size_t totalSize = 0;
+    measure("EncryptedContent::wireEncode(KeyLocatorWire)", {{"payload_size", size}}, N_ITERATIONS, [&] {
+      EncryptedContent content;
+      content.setIv(iv);
+      content.setPayload(payload);
+      content.setKeyLocator(ckNameWire);
+      totalSize += content.wireEncode().size();
+    });
+    BOOST_CHECK_GT(totalSize, size * N_ITERATIONS);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Decode)
+{
+  for (size_t size : PAYLOAD_SIZES) {
+    EncryptedContent original;
+    original.setIv(std::make_shared<Buffer>(AES_IV_SIZE));
+    original.setPayload(std::make_shared<Buffer>(size));
+    original.setKeyLocator(CK_NAME);
+    const Block wire = original.wireEncode();
+
+    size_t nDecoded = 0;
+    measure("EncryptedContent::wireDecode", {{"payload_size", size}}, N_ITERATIONS, [&] {
+      // `wire` itself is never parsed, so each iteration decodes all sub-elements again
+      EncryptedContent content(wire);
+      nDecoded += content.hasKeyLocator();
+    });
+    BOOST_CHECK_EQUAL(nDecoded, N_ITERATIONS);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END() // EncryptedContentBench
+
+} // namespace ndn::nac::tests
@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "encryptor.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+#include "tests/benchmarks/benchmark-access.hpp"
+#include "tests/benchmarks/benchmark-report.hpp"
+#include "tests/unit/static-data.hpp"
+
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/validator-null.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+namespace ndn::nac::tests {
+
+class EncryptorBenchFixture : public KeyChainFixture
+{
+public:
+  EncryptorBenchFixture()
+  {
+    // the last packet published by AccessManager is the KEK
+    StaticData data;
+    BenchmarkAccess::setKek(encryptor, Data(data.managerPackets.at(2)));
+  }
+
+public:
+  boost::asio::io_context io; // the KEK is installed directly, only polled to refill the CK pool
+  DummyClientFace face{io, m_keyChain, {false, false}};
+  security::ValidatorNull validator;
+  Identity producerIdentity = m_keyChain.createIdentity("/producer");
+  Encryptor encryptor{"/access/policy/identity/NAC/dataset", "/some/ck/prefix",
+                      signingByIdentity(producerIdentity),
+                      [] (auto&&...) { BOOST_ERROR("unexpected failure"); },
+                      validator, m_keyChain, face};
+};
+
+BOOST_FIXTURE_TEST_SUITE(EncryptorBench, EncryptorBenchFixture)
+
+BOOST_AUTO_TEST_CASE(Encrypt)
+{
+  const std::vector<size_t> payloadSizes{64, 1024, 8192, 65536};
+  constexpr size_t N_ITERATIONS = 20000;
+
+  for (size_t size : payloadSizes) {
+    Buffer plaintext(size);
+
+    size_t totalSize = 0;
+    measure("Encryptor::encrypt", {{"payload_size", size}}, N_ITERATIONS, [&] {
+      totalSize += encryptor.encrypt(plaintext).getPayload().value_size();
+    });
+    BOOST_CHECK_GT(totalSize, size * N_ITERATIONS);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MakeAndPublishCkData)
+{
+  constexpr size_t N_ITERATIONS = 200;
+
+  size_t nFailures = 0;
+  measure("Encryptor::makeAndPublishCkData", {}, N_ITERATIONS, [&] {
+    BenchmarkAccess::makeAndPublishCkData(encryptor, [&] (auto&&...) { ++nFailures; });
+  });
+  BOOST_CHECK_EQUAL(nFailures, 0);
+}
+
+BOOST_AUTO_TEST_CASE(RegenerateCk)
+{
+  constexpr size_t N_ITERATIONS = 200;
+
+  measure("Encryptor::regenerateCk", {{"pool_size", 0}}, N_ITERATIONS, [&] {
+    encryptor.regenerateCk();
+  });
+
+  // refill the pool between rotations, as the Face's event loop would
+  constexpr size_t POOL_SIZE = 8;
+  encryptor.setCkPoolSize(POOL_SIZE);
+  std::vector<std::chrono::nanoseconds> samples;
+  for (size_t i = 0; i < N_ITERATIONS / POOL_SIZE; ++i) {
+    while (BenchmarkAccess::getCkPoolSize(encryptor) < POOL_SIZE) {
+      io.restart();
+      io.poll();
+    }
+
+    // burst of rotations served from the pool
+    for (size_t j = 0; j < POOL_SIZE; ++j) {
+      auto before = BenchmarkReport::Clock::now();
+      encryptor.regenerateCk();
+      samples.push_back(BenchmarkReport::Clock::now() - before);
+    }
+  }
+  BenchmarkReport::get().add("Encryptor::regenerateCk", {{"pool_size", POOL_SIZE}}, std::move(samples));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // EncryptorBench
+
+} // namespace ndn::nac::tests
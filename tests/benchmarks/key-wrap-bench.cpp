@@ -0,0 +1,132 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "access-manager.hpp"
+#include "detail/ecies.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/key-chain-fixture.hpp"
+#include "tests/benchmarks/benchmark-report.hpp"
+
+#include <ndn-cxx/security/transform/private-key.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/asio/io_context.hpp>
+
+namespace ndn::nac::tests {
+
+/**
+ * Compares the cost of the RSA-OAEP and the ECDH-based key wrapping schemes: generation of
+ * the KEK/KDK key pair, wrapping of a CK (by Encryptor), unwrapping of a CK (by Decryptor),
+ * and creation of a KDK (by AccessManager).  The sizes of the wrapped CK and of the KDK
+ * are reported as parameters.
+ */
+class KeyWrapBenchFixture : public KeyChainFixture
+{
+public:
+  KeyWrapBenchFixture()
+  {
+    random::generateSecureBytes(ck);
+  }
+
+  void
+  run(const std::string& scheme, const BenchmarkReport::Parameters& params, const KeyParams& keyParams)
+  {
+    constexpr size_t N_KEYGEN_ITERATIONS = 10;
+    constexpr size_t N_ITERATIONS = 1000;
+    constexpr size_t N_ADD_MEMBER_ITERATIONS = 100;
+
+    size_t i = 0;
+    measure("KeyWrap::generateKey", params, N_KEYGEN_ITERATIONS, [&] {
+      m_keyChain.createIdentity(Name("/keygen").append(scheme).appendNumber(i++), keyParams);
+    });
+
+    auto key = m_keyChain.createIdentity(Name("/member").append(scheme), keyParams).getDefaultKey();
+    auto publicKey = key.getPublicKey();
+    bool isEcies = detail::isEciesKey(publicKey);
+
+    auto wrap = [&] {
+      if (isEcies) {
+        return detail::eciesWrap(publicKey, ck);
+      }
+      PublicKey rsaKey;
+      rsaKey.loadPkcs8(publicKey);
+      return rsaKey.encrypt(ck);
+    };
+
+    auto wrapped = wrap();
+    auto wrapParams = params;
+    wrapParams.emplace_back("wrapped_size", wrapped->size());
+    measure("KeyWrap::wrap", wrapParams, N_ITERATIONS, [&] {
+      wrapped = wrap();
+    });
+
+    // same as Decryptor: ECDH in memory, RSA decryption through the TPM
+    std::unique_ptr<detail::EciesPrivateKey> eciesKey;
+    if (isEcies) {
+      std::string password = "password";
+      auto safeBag = m_keyChain.exportSafeBag(key.getDefaultCertificate(), password.data(), password.size());
+      security::transform::PrivateKey privateKey;
+      privateKey.loadPkcs8(safeBag->getEncryptedKey(), password.data(), password.size());
+      eciesKey = std::make_unique<detail::EciesPrivateKey>(privateKey);
+    }
+
+    Buffer unwrapped;
+    measure("KeyWrap::unwrap", wrapParams, N_ITERATIONS, [&] {
+      if (isEcies) {
+        auto secret = eciesKey->unwrap(*wrapped);
+        unwrapped.assign(secret.begin(), secret.end());
+      }
+      else {
+        unwrapped = *m_keyChain.getTpm().decrypt(*wrapped, key.getName());
+      }
+    });
+    BOOST_CHECK(unwrapped == ck);
+
+    AccessManager manager(owner, Name("/dataset").append(scheme), m_keyChain, face, keyParams);
+    auto kdkParams = params;
+    kdkParams.emplace_back("kdk_size", manager.addMember(key.getDefaultCertificate()).wireEncode().size());
+    measure("AccessManager::addMember", kdkParams, N_ADD_MEMBER_ITERATIONS, [&] {
+      manager.addMember(key.getDefaultCertificate());
+    });
+  }
+
+public:
+  Buffer ck = Buffer(AES_KEY_SIZE);
+  boost::asio::io_context io; // never run, KDKs are returned directly by addMember
+  DummyClientFace face{io, m_keyChain, {false, true}};
+  Identity owner = m_keyChain.createIdentity("/access/policy/identity");
+};
+
+BOOST_FIXTURE_TEST_SUITE(KeyWrapBench, KeyWrapBenchFixture)
+
+BOOST_AUTO_TEST_CASE(Rsa2048)
+{
+  run("rsa", {{"rsa_bits", 2048}}, RsaKeyParams(2048));
+}
+
+BOOST_AUTO_TEST_CASE(EcP256)
+{
+  run("ec", {{"ec_bits", 256}}, EcKeyParams(256));
+}
+
+BOOST_AUTO_TEST_SUITE_END() // KeyWrapBench
+
+} // namespace ndn::nac::tests
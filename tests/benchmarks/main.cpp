@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#define BOOST_TEST_MODULE NAC Benchmarks
+#include "tests/boost-test.hpp"
+
+#include "tests/benchmarks/benchmark-report.hpp"
+
+#include <fstream>
+#include <iostream>
+
+namespace ndn::nac::tests {
+
+/**
+ * @brief Writes the collected results as JSON after all benchmarks have run.
+ *
+ * The results are written to stdout, unless a file is specified after the Boost.Test
+ * arguments, e.g.: `./build/benchmarks -- --output=results.json`
+ */
+class BenchmarkReportWriter
+{
+public:
+  BenchmarkReportWriter()
+  {
+    const std::string option = "--output=";
+    auto& suite = ut::framework::master_test_suite();
+    for (int i = 1; i < suite.argc; ++i) {
+      std::string arg = suite.argv[i];
+      if (arg.compare(0, option.size(), option) == 0) {
+        m_output = arg.substr(option.size());
+      }
+    }
+  }
+
+  ~BenchmarkReportWriter()
+  {
+    if (m_output.empty() || m_output == "-") {
+      BenchmarkReport::get().writeJson(std::cout);
+    }
+    else {
+      std::ofstream os(m_output);
+      BenchmarkReport::get().writeJson(os);
+    }
+  }
+
+private:
+  std::string m_output;
+};
+
+BOOST_TEST_GLOBAL_FIXTURE(BenchmarkReportWriter);
+
+} // namespace ndn::nac::tests
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -18,13 +18,16 @@
  */
 
 #include "access-manager.hpp"
+#include "detail/merkle-batch.hpp"
 
 #include "tests/boost-test.hpp"
 #include "tests/io-key-chain-fixture.hpp"
 
+#include <ndn-cxx/security/verification-helpers.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 #include <ndn-cxx/util/string-helper.hpp>
 
+#include <array>
 #include <iostream>
 
 namespace ndn::nac::tests {
@@ -85,6 +88,48 @@ BOOST_AUTO_TEST_CASE(PublishedKdks)
   }
 }
 
+BOOST_AUTO_TEST_CASE(ExactMatchAndNack)
+{
+  manager.setNackUnpublished(true);
+  Name kdk("/access/policy/identity/NAC/dataset/KDK");
+  kdk
+    .append(nacIdentity.getDefaultKey().getName().get(-1))
+    .append("ENCRYPTED-BY")
+    .append(userIdentities.at(0).getDefaultKey().getName());
+
+  face.receive(Interest(kdk));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentData.at(0).getName(), kdk);
+
+  auto fullName = face.sentData.at(0).getFullName();
+  face.receive(Interest(fullName));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 2);
+  BOOST_CHECK_EQUAL(face.sentData.at(1).getFullName(), fullName);
+
+  // neither a prefix of the KDK name without CanBePrefix, nor a different digest, is answered
+  // with the KDK, but with an application-level NACK
+  face.sentData.clear();
+  std::array<uint8_t, 32> otherDigest{};
+  face.receive(Interest(kdk.getPrefix(-1)));
+  face.receive(Interest(Name(kdk).appendImplicitSha256Digest(otherDigest)));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 2);
+  BOOST_CHECK_EQUAL(face.sentData.at(0).getName(), kdk.getPrefix(-1));
+  for (const auto& nack : face.sentData) {
+    BOOST_CHECK_EQUAL(nack.getContentType(), tlv::ContentType_Nack);
+    BOOST_CHECK_EQUAL(nack.getFreshnessPeriod(), NACK_FRESHNESS_PERIOD);
+  }
+
+  // without NACKs, such Interests are left unanswered
+  face.sentData.clear();
+  manager.setNackUnpublished(false);
+  face.receive(Interest(kdk.getPrefix(-1)));
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
 {
   BOOST_CHECK_EQUAL(manager.size(), 3);
@@ -92,6 +137,8 @@ BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
   size_t nKdk = 0;
   for (const auto& data : manager) {
     BOOST_TEST_MESSAGE(data.getName());
+    // served without being encoded again
+    BOOST_CHECK(data.hasWire());
     if (data.getName().at(5) == KEK) {
       ++nKek;
     }
@@ -103,6 +150,262 @@ BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
   BOOST_CHECK_EQUAL(nKdk, 2);
 }
 
+BOOST_AUTO_TEST_CASE(ExistingNacKey)
+{
+  auto nacKey = nacIdentity.getDefaultKey();
+  auto nKeys = nacIdentity.getKeys().size();
+
+  DummyClientFace otherFace(m_io, m_keyChain, {true, true});
+  AccessManager other(accessIdentity, nacKey, m_keyChain, otherFace);
+  BOOST_CHECK_EQUAL(nacIdentity.getKeys().size(), nKeys);
+  BOOST_REQUIRE_EQUAL(other.size(), 1);
+  BOOST_CHECK_EQUAL(other.begin()->getName(),
+                    Name("/access/policy/identity/NAC/dataset/KEK").append(nacKey.getName().get(-1)));
+
+  // the key is re-used rather than regenerated
+  BOOST_CHECK_EQUAL(AccessManager::getOrCreateNacKey(accessIdentity, "/dataset", m_keyChain).getName(),
+                    nacKey.getName());
+  BOOST_CHECK_EQUAL(nacIdentity.getKeys().size(), nKeys);
+}
+
+BOOST_AUTO_TEST_CASE(StaticOperations)
+{
+  auto nacKey = nacIdentity.getDefaultKey();
+  auto memberCert = userIdentities.at(0).getDefaultKey().getDefaultCertificate();
+
+  auto kek = AccessManager::makeKek(accessIdentity, nacKey, m_keyChain);
+  BOOST_CHECK_EQUAL(kek.getName(),
+                    Name("/access/policy/identity/NAC/dataset/KEK").append(nacKey.getName().get(-1)));
+  BOOST_CHECK(kek.getContent() == nacKey.getDefaultCertificate().getContent());
+
+  auto kdk = AccessManager::makeKdk(accessIdentity, nacKey, memberCert, m_keyChain);
+  BOOST_CHECK_EQUAL(kdk.getName(),
+                    Name("/access/policy/identity/NAC/dataset/KDK")
+                      .append(nacKey.getName().get(-1))
+                      .append(ENCRYPTED_BY)
+                      .append(memberCert.getKeyName()));
+  BOOST_CHECK_EQUAL(kdk.getSignatureInfo().getKeyLocator().getName(),
+                    accessIdentity.getDefaultKey().getDefaultCertificate().getName());
+
+  // nothing is published by the static operations
+  BOOST_CHECK_EQUAL(manager.size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(MemberIndex)
+{
+  auto firstKey = userIdentities.at(0).getDefaultKey();
+  auto secondKey = m_keyChain.createKey(userIdentities.at(0), RsaKeyParams());
+  auto thirdKey = userIdentities.at(1).getDefaultKey();
+  manager.addMember(secondKey.getDefaultCertificate());
+
+  BOOST_CHECK_EQUAL(manager.getNMembers(), 2);
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 3);
+  BOOST_CHECK_EQUAL(manager.size(), 4);
+  BOOST_CHECK(manager.getMembers() == (std::vector<Name>{"/first/user", "/second/user"}));
+  BOOST_CHECK_EQUAL(manager.getMemberKeys("/first/user").size(), 2);
+  BOOST_CHECK(manager.hasMember("/second/user"));
+  BOOST_CHECK(!manager.hasMember("/third/user"));
+
+  Name kdkName("/access/policy/identity/NAC/dataset/KDK");
+  kdkName
+    .append(nacIdentity.getDefaultKey().getName().get(-1))
+    .append(ENCRYPTED_BY)
+    .append(thirdKey.getName());
+  BOOST_REQUIRE(manager.findKdk(thirdKey.getName()) != nullptr);
+  BOOST_CHECK_EQUAL(*manager.findKdk(thirdKey.getName()), kdkName);
+  BOOST_CHECK(manager.findKdk("/first/user") == nullptr);
+
+  // re-adding a member key replaces its KDK
+  manager.addMember(thirdKey.getDefaultCertificate());
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 3);
+  BOOST_CHECK_EQUAL(manager.size(), 4);
+
+  BOOST_CHECK(manager.removeMemberKey(secondKey.getName()));
+  BOOST_CHECK(!manager.removeMemberKey(secondKey.getName()));
+  BOOST_CHECK(!manager.removeMemberKey("/not/a/key/name"));
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 2);
+  BOOST_CHECK_EQUAL(manager.size(), 3);
+
+  // removing an identity erases the KDKs of all its keys, which are then no longer served
+  manager.addMember(secondKey.getDefaultCertificate());
+  BOOST_CHECK_EQUAL(manager.removeMember("/first/user"), 2);
+  BOOST_CHECK_EQUAL(manager.removeMember("/first/user"), 0);
+  BOOST_CHECK(!manager.hasMember("/first/user"));
+  BOOST_CHECK_EQUAL(manager.getNMembers(), 1);
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 1);
+  BOOST_CHECK_EQUAL(manager.size(), 2);
+
+  face.receive(Interest(Name("/access/policy/identity/NAC/dataset/KDK")
+                          .append(nacIdentity.getDefaultKey().getName().get(-1))
+                          .append(ENCRYPTED_BY)
+                          .append(firstKey.getName()))
+               .setCanBePrefix(true).setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(KeyTree)
+{
+  auto& registry = MetricsRegistry::getDefault();
+  AccessManager treeManager(accessIdentity, Name("/tree-dataset"), m_keyChain, face, EcKeyParams());
+  treeManager.setKdkDistribution(KdkDistribution::KeyTree);
+  BOOST_CHECK(treeManager.getKdkDistribution() == KdkDistribution::KeyTree);
+  BOOST_CHECK_EQUAL(treeManager.size(), 1);
+
+  std::vector<Identity> members;
+  for (int i = 0; i < 4; ++i) {
+    members.push_back(m_keyChain.createIdentity(Name("/member").appendNumber(i), EcKeyParams()));
+    treeManager.addMember(members.back().getDefaultKey().getDefaultCertificate());
+  }
+  // KEK, KDK, 4 leaf node keys for the members, and 6 node keys wrapping their parent
+  BOOST_CHECK_EQUAL(treeManager.size(), 12);
+  BOOST_CHECK_EQUAL(treeManager.getNMemberKeys(), 4);
+  BOOST_CHECK_THROW(treeManager.setKdkDistribution(KdkDistribution::Direct), AccessManager::Error);
+
+  Name nodePrefix("/access/policy/identity/NAC/tree-dataset/NODE/ENCRYPTED-BY");
+  const Name* grant = treeManager.findKdk(members.at(0).getDefaultKey().getName());
+  BOOST_REQUIRE(grant != nullptr);
+  BOOST_CHECK(nodePrefix.isPrefixOf(*grant));
+
+  auto nacId = m_keyChain.getPib().getIdentity("/access/policy/identity/NAC/tree-dataset");
+  auto oldKeyId = nacId.getDefaultKey().getName().get(-1);
+  auto before = registry.getSnapshot();
+
+  // replaces the leaf's parent and the root, which are wrapped by their 3 remaining children
+  BOOST_CHECK_EQUAL(treeManager.removeMember(members.at(0).getName()), 1);
+  auto after = registry.getSnapshot();
+  auto delta = [&] (const std::string& name) {
+    return after.counters.at("nac.AccessManager." + name) - before.counters.at("nac.AccessManager." + name);
+  };
+  BOOST_CHECK_EQUAL(delta("nNodeKeysPublished"), 3);
+  BOOST_CHECK_EQUAL(delta("nNacKeyRotations"), 1);
+  BOOST_CHECK_NE(nacId.getDefaultKey().getName().get(-1), oldKeyId);
+  BOOST_CHECK_EQUAL(nacId.getDefaultKey().getKeyType(), KeyType::EC);
+  // the previous key pair is kept, and its KDK is wrapped by the new root key as well
+  BOOST_CHECK_NO_THROW(nacId.getKey(Name(nacId.getName()).append("KEY").append(oldKeyId)));
+  BOOST_CHECK_EQUAL(treeManager.size(), 11);
+
+  face.receive(Interest(Name(nodePrefix).append(members.at(0).getDefaultKey().getName()))
+               .setCanBePrefix(true).setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(face.sentData.size(), 0);
+  // the previous, the current, and the next key pair, which is generated in advance
+  BOOST_CHECK_EQUAL(nacId.getKeys().size(), 3);
+
+  face.receive(Interest(Name(nodePrefix).append(members.at(1).getDefaultKey().getName()))
+               .setCanBePrefix(true).setMustBeFresh(true));
+  face.receive(Interest(Name("/access/policy/identity/NAC/tree-dataset/KDK")
+                          .append(nacId.getDefaultKey().getName().get(-1))
+                          .append(ENCRYPTED_BY))
+               .setCanBePrefix(true).setMustBeFresh(true));
+  face.receive(Interest(Name("/access/policy/identity/NAC/tree-dataset/KDK")
+                          .append(oldKeyId)
+                          .append(ENCRYPTED_BY))
+               .setCanBePrefix(true).setMustBeFresh(true));
+  // the previous KEK is no longer offered to producers
+  face.receive(Interest(Name("/access/policy/identity/NAC/tree-dataset/KEK").append(oldKeyId))
+               .setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 3);
+  BOOST_CHECK_EQUAL(face.sentData.at(2).getName().get(6), oldKeyId);
+
+  // removing the last member withdraws the KDKs
+  for (size_t i = 1; i < members.size(); ++i) {
+    treeManager.removeMember(members.at(i).getName());
+  }
+  BOOST_CHECK_EQUAL(treeManager.size(), 1);
+
+  // the previous key pairs are deleted once no CK can be encrypted with them anymore
+  advanceClocks(DEFAULT_KEK_FRESHNESS_PERIOD + DEFAULT_CK_FRESHNESS_PERIOD);
+  BOOST_CHECK_THROW(nacId.getKey(Name(nacId.getName()).append("KEY").append(oldKeyId)), security::Pib::Error);
+  BOOST_CHECK_EQUAL(nacId.getKeys().size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(BatchSigning)
+{
+  std::vector<Certificate> certs;
+  for (int i = 0; i < 5; ++i) {
+    certs.push_back(m_keyChain.createIdentity(Name("/batch/member").appendNumber(i), EcKeyParams())
+                    .getDefaultKey().getDefaultCertificate());
+  }
+
+  manager.setBatchSigning(true);
+  auto kdks = manager.addMembers(certs);
+  BOOST_REQUIRE_EQUAL(kdks.size(), 5);
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 7);
+  BOOST_CHECK_EQUAL(manager.size(), 8);
+
+  std::optional<Data> root;
+  for (size_t i = 0; i < kdks.size(); ++i) {
+    BOOST_CHECK_EQUAL(*manager.findKdk(certs[i].getKeyName()), kdks[i].getName());
+    BOOST_REQUIRE(detail::isBatchSigned(kdks[i]));
+    auto batchRoot = detail::verifyBatchProof(kdks[i]);
+    if (root) {
+      BOOST_CHECK_EQUAL(batchRoot.getFullName(), root->getFullName());
+    }
+    root = batchRoot;
+  }
+  // named after the longest common prefix of the KDKs, i.e., up to /batch/member
+  BOOST_CHECK_EQUAL(root->getName().getPrefix(-2), kdks.at(0).getName().getPrefix(-3));
+  BOOST_CHECK_EQUAL(root->getName().get(-2), BATCH);
+  BOOST_CHECK(security::verifySignature(*root, accessIdentity.getDefaultKey()));
+
+  // the proof does not match a modified packet
+  Data tampered(kdks.at(2));
+  tampered.setFreshnessPeriod(1_s);
+  BOOST_CHECK_THROW(detail::verifyBatchProof(tampered), Error);
+
+  // a single packet is signed directly
+  auto single = manager.addMembers({certs.at(0)});
+  BOOST_REQUIRE_EQUAL(single.size(), 1);
+  BOOST_CHECK(!detail::isBatchSigned(single.at(0)));
+  BOOST_CHECK(security::verifySignature(single.at(0), accessIdentity.getDefaultKey()));
+  BOOST_CHECK_EQUAL(manager.getNMemberKeys(), 7);
+
+  // node keys and KDK published after a change of the key tree form one batch
+  AccessManager treeManager(accessIdentity, Name("/tree-dataset"), m_keyChain, face, EcKeyParams());
+  treeManager.setKdkDistribution(KdkDistribution::KeyTree);
+  treeManager.setBatchSigning(true);
+  treeManager.addMembers({certs.at(0), certs.at(1)});
+  size_t nBatchSigned = 0;
+  for (const auto& data : treeManager) {
+    nBatchSigned += detail::isBatchSigned(data) ? 1 : 0;
+  }
+  // the 2 node keys and the KDK published when the tree grows for the second member
+  BOOST_CHECK_EQUAL(nBatchSigned, 3);
+}
+
+BOOST_AUTO_TEST_CASE(Metrics)
+{
+  // the default registry is shared by all AccessManager instances in the process
+  auto& registry = MetricsRegistry::getDefault();
+  auto before = registry.getSnapshot();
+
+  Name kdk("/access/policy/identity/NAC/dataset/KDK");
+  kdk
+    .append(nacIdentity.getDefaultKey().getName().get(-1))
+    .append("ENCRYPTED-BY")
+    .append(userIdentities.at(0).getDefaultKey().getName());
+  face.receive(Interest(kdk).setCanBePrefix(true).setMustBeFresh(true));
+  face.receive(Interest(Name(kdk).append("non-existent")).setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+
+  auto newMember = m_keyChain.createIdentity("/third/user", RsaKeyParams());
+  manager.addMember(newMember.getDefaultKey().getDefaultCertificate());
+  manager.removeMember(userIdentities.at(0).getName());
+
+  auto after = registry.getSnapshot();
+  auto delta = [&] (const std::string& name) {
+    return after.counters.at("nac.AccessManager." + name) - before.counters.at("nac.AccessManager." + name);
+  };
+  BOOST_CHECK_EQUAL(delta("nKdkServed"), 1);
+  BOOST_CHECK_EQUAL(delta("nNotFound"), 1);
+  BOOST_CHECK_EQUAL(delta("nMembersRemoved"), 1);
+  BOOST_CHECK_EQUAL(delta("nMembersAdded"), 1);
+  BOOST_CHECK_GT(after.gauges.at("nac.AccessManager.imsBytes"), before.gauges.at("nac.AccessManager.imsBytes"));
+  BOOST_CHECK_GE(after.histograms.at("nac.AccessManager.addMemberLatency").count, 3);
+}
+
 BOOST_AUTO_TEST_CASE(GenerateTestData,
   * ut::description("regenerates the static test data used by other test cases")
   * ut::disabled()
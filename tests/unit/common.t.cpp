@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * This file is part of NAC (Name-Based Access Control for NDN).
  * See AUTHORS.md for complete list of NAC authors and contributors.
@@ -56,6 +56,47 @@ BOOST_AUTO_TEST_CASE(Helpers)
                              Name("/ck/prefix/stuff"), onFailed);
   BOOST_CHECK(hasFailed);
   BOOST_CHECK(kdkPrefix.empty());
+
+  // KEK derived for a sub-dataset
+  hasFailed = false;
+  std::tie(kdkPrefix, kdkIdentity, kdkKeyName) =
+    extractKdkInfoFromCkName(Name("/ck/prefix/stuff/ENCRYPTED-BY/access/prefix/NAC/dataset/KEK/id/DERIVED/a/b"),
+                             Name("/ck/prefix/stuff"), onFailed);
+  BOOST_CHECK(!hasFailed);
+  BOOST_CHECK_EQUAL(kdkPrefix, Name("/access/prefix/NAC/dataset/KDK/id"));
+  BOOST_CHECK_EQUAL(kdkKeyName, Name("/access/prefix/NAC/dataset/KEY/id"));
+}
+
+BOOST_AUTO_TEST_CASE(DerivedKekName)
+{
+  auto [kekName, subDataset] = splitDerivedKekName("/access/prefix/NAC/dataset/KEK/id/DERIVED/a/b");
+  BOOST_CHECK_EQUAL(kekName, "/access/prefix/NAC/dataset/KEK/id");
+  BOOST_CHECK_EQUAL(subDataset, "/a/b");
+
+  std::tie(kekName, subDataset) = splitDerivedKekName("/access/prefix/NAC/dataset/KEK/id");
+  BOOST_CHECK_EQUAL(kekName, "/access/prefix/NAC/dataset/KEK/id");
+  BOOST_CHECK(subDataset.empty());
+}
+
+BOOST_AUTO_TEST_CASE(RetryDelays)
+{
+  RetryPolicy policy{100_ms, 1_s, 2.0, 0.0};
+  BOOST_CHECK_EQUAL(policy.getDelay(1), 100_ms);
+  BOOST_CHECK_EQUAL(policy.getDelay(2), 200_ms);
+  BOOST_CHECK_EQUAL(policy.getDelay(4), 800_ms);
+  BOOST_CHECK_EQUAL(policy.getDelay(5), 1_s);
+  BOOST_CHECK_EQUAL(policy.getDelay(1000), 1_s);
+
+  policy.jitter = 0.5;
+  for (int i = 0; i < 100; ++i) {
+    auto delay = policy.getDelay(3);
+    BOOST_CHECK_GE(delay, 200_ms);
+    BOOST_CHECK_LE(delay, 400_ms);
+  }
+
+  auto fixed = RetryPolicy::fixed(60_s);
+  BOOST_CHECK_EQUAL(fixed.getDelay(1), 60_s);
+  BOOST_CHECK_EQUAL(fixed.getDelay(10), 60_s);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -20,6 +20,7 @@
 #include "decryptor.hpp"
 
 #include "access-manager.hpp"
+#include "detail/merkle-batch.hpp"
 #include "encrypted-content.hpp"
 #include "encryptor.hpp"
 
@@ -27,6 +28,9 @@
 #include "tests/io-key-chain-fixture.hpp"
 #include "tests/unit/static-data.hpp"
 
+#include <ndn-cxx/security/certificate-fetcher-offline.hpp>
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/validation-policy-simple-hierarchy.hpp>
 #include <ndn-cxx/security/validator-null.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 
@@ -127,6 +131,593 @@ BOOST_FIXTURE_TEST_CASE_TEMPLATE(DecryptSuccess, T, Identities, DecryptorFixture
   BOOST_CHECK_EQUAL(nFailures, T().expectToSucceed ? 0 : 1);
 }
 
+BOOST_FIXTURE_TEST_CASE(Metrics, DecryptorFixture<Valid>)
+{
+  StaticData data;
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (auto&&...) { ++nSuccesses; };
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nPendingDecrypts, 1);
+  advanceClocks(2_s, 10);
+
+  auto metrics = decryptor.getMetrics();
+  BOOST_CHECK_EQUAL(nSuccesses, 1);
+  BOOST_CHECK_EQUAL(metrics.nPendingDecrypts, 0);
+  BOOST_CHECK_EQUAL(metrics.nCkFetches, 1);
+  BOOST_CHECK_EQUAL(metrics.nKdkFetches, 1);
+  BOOST_CHECK_EQUAL(metrics.nCkCacheMisses, 1);
+  BOOST_CHECK_EQUAL(metrics.nCkCacheHits, 0);
+  BOOST_CHECK_EQUAL(metrics.nKdkCacheMisses, 1);
+  BOOST_CHECK_EQUAL(metrics.ckFetchLatency.count, 1);
+  BOOST_CHECK_EQUAL(metrics.kdkFetchLatency.count, 1);
+  BOOST_CHECK_EQUAL(metrics.kdkUnwrapLatency.count, 1);
+  BOOST_CHECK_EQUAL(metrics.ckUnwrapLatency.count, 1);
+  BOOST_CHECK_EQUAL(metrics.decryptLatency.count, 1);
+
+  // CK is cached
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  metrics = decryptor.getMetrics();
+  BOOST_CHECK_EQUAL(nSuccesses, 2);
+  BOOST_CHECK_EQUAL(metrics.nCkCacheHits, 1);
+  BOOST_CHECK_EQUAL(metrics.nCkFetches, 1);
+  BOOST_CHECK_EQUAL(metrics.decryptLatency.count, 2);
+
+  // new CK, but the KDK has already been imported
+  decryptor.decrypt(data.encryptedBlobs.at(1), onSuccess, onFailure);
+  advanceClocks(2_s, 10);
+  metrics = decryptor.getMetrics();
+  BOOST_CHECK_EQUAL(nSuccesses, 3);
+  BOOST_CHECK_EQUAL(metrics.nCkFetches, 2);
+  BOOST_CHECK_EQUAL(metrics.nKdkFetches, 1);
+  BOOST_CHECK_EQUAL(metrics.nKdkCacheHits, 1);
+  BOOST_CHECK_EQUAL(metrics.nCkNacks + metrics.nCkTimeouts + metrics.nKdkNacks + metrics.nKdkTimeouts, 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(PendingDecryptLimits, DecryptorFixture<Valid>)
+{
+  StaticData data;
+  EncryptedContent blob0(data.encryptedBlobs.at(0));
+  EncryptedContent blob1(data.encryptedBlobs.at(1));
+  size_t size0 = blob0.getPayload().value_size();
+  size_t size1 = blob1.getPayload().value_size();
+
+  size_t nSuccesses = 0;
+  size_t nFailures = 0;
+  auto onSuccess = [&] (auto&&...) { ++nSuccesses; };
+  auto onFailure = [&] (const ErrorCode& code, const std::string&) {
+    BOOST_CHECK(code == ErrorCode::PendingDecryptsOverflow);
+    ++nFailures;
+  };
+
+  Decryptor::PendingDecryptLimits limits;
+  limits.maxEntriesPerCk = 2;
+  limits.maxEntries = 3;
+  decryptor.setPendingDecryptLimits(limits);
+
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure); // over per-CK limit
+  BOOST_CHECK_EQUAL(nFailures, 1);
+  decryptor.decrypt(data.encryptedBlobs.at(1), onSuccess, onFailure);
+  decryptor.decrypt(data.encryptedBlobs.at(1), onSuccess, onFailure); // over global limit
+  BOOST_CHECK_EQUAL(nFailures, 2);
+
+  auto depth = decryptor.getPendingDecryptDepth();
+  BOOST_CHECK_EQUAL(depth.nEntries, 3);
+  BOOST_CHECK_EQUAL(depth.nBytes, 2 * size0 + size1);
+  depth = decryptor.getPendingDecryptDepth(blob0.getKeyLocator());
+  BOOST_CHECK_EQUAL(depth.nEntries, 2);
+  BOOST_CHECK_EQUAL(depth.nBytes, 2 * size0);
+  BOOST_CHECK_EQUAL(decryptor.getPendingDecryptDepth("/unknown/ck").nEntries, 0);
+
+  // the oldest decrypt (of the first CK) makes room for the new one
+  limits.overflowPolicy = Decryptor::PendingDecryptLimits::OverflowPolicy::DropOldest;
+  decryptor.setPendingDecryptLimits(limits);
+  decryptor.decrypt(data.encryptedBlobs.at(1), onSuccess, onFailure);
+  BOOST_CHECK_EQUAL(nFailures, 3);
+  BOOST_CHECK_EQUAL(decryptor.getPendingDecryptDepth().nEntries, 3);
+  BOOST_CHECK_EQUAL(decryptor.getPendingDecryptDepth(blob0.getKeyLocator()).nEntries, 1);
+  BOOST_CHECK_EQUAL(decryptor.getPendingDecryptDepth(blob1.getKeyLocator()).nEntries, 2);
+
+  advanceClocks(2_s, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 3);
+  BOOST_CHECK_EQUAL(nFailures, 3);
+  depth = decryptor.getPendingDecryptDepth();
+  BOOST_CHECK_EQUAL(depth.nEntries, 0);
+  BOOST_CHECK_EQUAL(depth.nBytes, 0);
+
+  auto metrics = decryptor.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nPendingDecrypts, 0);
+  BOOST_CHECK_EQUAL(metrics.nPendingDecryptOverflows, 3);
+}
+
+BOOST_FIXTURE_TEST_CASE(NegativeCache, DecryptorFixture<Invalid>)
+{
+  StaticData data;
+  decryptor.setRetryPolicy(RetryPolicy::fixed(30_s));
+
+  std::vector<ErrorCode> errors;
+  auto onSuccess = [] (auto&&...) { BOOST_ERROR("Unexpected decrypt success"); };
+  auto onFailure = [&] (const ErrorCode& code, const std::string&) { errors.push_back(code); };
+
+  // all pending decrypts fail when the KDK cannot be retrieved
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  advanceClocks(2_s, 10);
+  BOOST_REQUIRE_EQUAL(errors.size(), 2);
+  BOOST_CHECK(errors.at(0) == ErrorCode::KdkRetrievalTimeout);
+  BOOST_CHECK(errors.at(1) == ErrorCode::KdkRetrievalTimeout);
+  BOOST_CHECK_EQUAL(decryptor.getPendingDecryptDepth().nEntries, 0);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nCkFetches, 1);
+
+  // the failure is remembered
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  BOOST_REQUIRE_EQUAL(errors.size(), 3);
+  BOOST_CHECK(errors.at(2) == ErrorCode::KdkRetrievalTimeout);
+  advanceClocks(1_s, 5);
+  auto metrics = decryptor.getMetrics();
+  BOOST_CHECK_EQUAL(metrics.nCkFetches, 1);
+  BOOST_CHECK_EQUAL(metrics.nCkNegativeCacheHits, 1);
+
+  // and retried once it expires
+  advanceClocks(1_s, 30);
+  decryptor.decrypt(data.encryptedBlobs.at(0), onSuccess, onFailure);
+  BOOST_CHECK_EQUAL(errors.size(), 3);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nCkFetches, 2);
+  advanceClocks(2_s, 10);
+  BOOST_CHECK_EQUAL(errors.size(), 4);
+}
+
+BOOST_FIXTURE_TEST_CASE(TryDecrypt, DecryptorFixture<Valid>)
+{
+  StaticData data;
+  std::array<uint8_t, 64> plaintext{};
+
+  // CK has not been retrieved, and tryDecrypt does not retrieve it
+  BOOST_CHECK(!decryptor.tryDecrypt(data.encryptedBlobs.at(0), plaintext));
+  BOOST_CHECK(decryptor.tryDecrypt(data.encryptedBlobs.at(0)) == nullptr);
+  advanceClocks(2_s, 10);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nCkFetches, 0);
+
+  decryptor.decrypt(data.encryptedBlobs.at(0), [] (auto&&...) {},
+                    [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); });
+  advanceClocks(2_s, 10);
+
+  auto size = decryptor.tryDecrypt(data.encryptedBlobs.at(0), plaintext);
+  BOOST_REQUIRE(size);
+  BOOST_CHECK_EQUAL(std::string(reinterpret_cast<const char*>(plaintext.data()), *size), "Data to encrypt");
+  // same CK again, through the cached lookup
+  size = decryptor.tryDecrypt(data.encryptedBlobs.at(0), plaintext);
+  BOOST_CHECK_EQUAL(size.value_or(0), 15);
+
+  auto buffer = decryptor.tryDecrypt(data.encryptedBlobs.at(0));
+  BOOST_REQUIRE(buffer != nullptr);
+  BOOST_CHECK_EQUAL(std::string(buffer->get<char>(), buffer->size()), "Data to encrypt");
+
+  // a different CK
+  BOOST_CHECK(!decryptor.tryDecrypt(data.encryptedBlobs.at(1), plaintext));
+
+  std::array<uint8_t, 4> tooSmall{};
+  BOOST_CHECK_THROW(decryptor.tryDecrypt(data.encryptedBlobs.at(0), tooSmall), Error);
+  BOOST_CHECK_THROW(decryptor.tryDecrypt(Block(tlv::EncryptedContent)), Error);
+  BOOST_CHECK_THROW(decryptor.tryDecrypt(makeStringBlock(tlv::Content, "x")), Error);
+}
+
+BOOST_FIXTURE_TEST_CASE(CorruptedContent, DecryptorFixture<Valid>)
+{
+  StaticData data;
+  EncryptedContent corrupted(data.encryptedBlobs.at(0));
+  auto payload = corrupted.getPayload().value_bytes();
+  // AES-CBC ciphertext must be a multiple of the block size
+  corrupted.setPayload(std::make_shared<Buffer>(payload.begin(), payload.end() - 1));
+  Block corruptedBlock = corrupted.wireEncode();
+
+  std::vector<boost::system::error_code> errors;
+  auto handler = [&] (const boost::system::error_code& ec, ConstBufferPtr) { errors.push_back(ec); };
+
+  // the corrupted decrypt fails once the CK is retrieved, without affecting the other pending one
+  size_t nSuccesses = 0;
+  decryptor.decrypt(corruptedBlock, handler);
+  decryptor.decrypt(data.encryptedBlobs.at(0), [&] (auto&&...) { ++nSuccesses; },
+                    [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); });
+  advanceClocks(2_s, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 1);
+  BOOST_REQUIRE_EQUAL(errors.size(), 1);
+  BOOST_CHECK(errors.at(0) == ErrorCode::PayloadDecryptionFailure);
+
+  // with the CK already retrieved, the error still goes to the handler
+  BOOST_CHECK_THROW(decryptor.tryDecrypt(corruptedBlock), Error);
+  BOOST_CHECK_NO_THROW(decryptor.decrypt(corruptedBlock, handler));
+  BOOST_CHECK_EQUAL(errors.size(), 1);
+  advanceClocks(1_ms);
+  BOOST_REQUIRE_EQUAL(errors.size(), 2);
+  BOOST_CHECK(errors.at(1) == ErrorCode::PayloadDecryptionFailure);
+
+  BOOST_CHECK_NO_THROW(decryptor.decrypt(makeStringBlock(tlv::Content, "x"), handler));
+  advanceClocks(1_ms);
+  BOOST_REQUIRE_EQUAL(errors.size(), 3);
+  BOOST_CHECK(errors.at(2) == ErrorCode::MalformedEncryptedContent);
+}
+
+BOOST_FIXTURE_TEST_CASE_TEMPLATE(CompletionToken, T, Identities, DecryptorFixture<T>)
+{
+  StaticData data;
+  std::vector<boost::system::error_code> errors;
+  std::vector<std::string> plaintexts;
+  auto handler = [&] (const boost::system::error_code& ec, ConstBufferPtr plaintext) {
+    errors.push_back(ec);
+    if (plaintext != nullptr) {
+      plaintexts.emplace_back(plaintext->template get<char>(), plaintext->size());
+    }
+  };
+
+  this->decryptor.setRetryPolicy(RetryPolicy::fixed(1_min));
+  this->decryptor.decrypt(data.encryptedBlobs.at(0), handler);
+  this->decryptor.decrypt(data.encryptedBlobs.at(0), handler);
+  BOOST_CHECK(errors.empty());
+  this->advanceClocks(2_s, 10);
+
+  BOOST_REQUIRE_EQUAL(errors.size(), 2);
+  if (T().expectToSucceed) {
+    BOOST_CHECK(!errors.at(0) && !errors.at(1));
+    BOOST_CHECK(plaintexts == std::vector<std::string>(2, "Data to encrypt"));
+
+    // CK is retrieved, but the handler is still not invoked from within decrypt()
+    this->decryptor.decrypt(data.encryptedBlobs.at(0), handler);
+    BOOST_CHECK_EQUAL(errors.size(), 2);
+    this->advanceClocks(1_ms);
+    BOOST_REQUIRE_EQUAL(errors.size(), 3);
+    BOOST_CHECK(!errors.at(2));
+    BOOST_CHECK_EQUAL(plaintexts.size(), 3);
+  }
+  else {
+    BOOST_CHECK(errors.at(0) == ErrorCode::KdkRetrievalTimeout);
+    BOOST_CHECK(errors.at(1) == ErrorCode::KdkRetrievalTimeout);
+    BOOST_CHECK(plaintexts.empty());
+
+    // failure is negatively cached, but the handler is still not invoked from within decrypt()
+    this->decryptor.decrypt(data.encryptedBlobs.at(0), handler);
+    BOOST_CHECK_EQUAL(errors.size(), 2);
+    this->advanceClocks(1_ms);
+    BOOST_REQUIRE_EQUAL(errors.size(), 3);
+    BOOST_CHECK(errors.at(2) == ErrorCode::KdkRetrievalTimeout);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(EllipticCurveKeys, IoKeyChainFixture)
+{
+  // no static data for EC keys, as ECDH uses ephemeral keys; run all parties instead
+  DummyClientFace managerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace producerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace consumerFace(m_io, m_keyChain, {true, true});
+  producerFace.linkTo(managerFace);
+  consumerFace.linkTo(managerFace);
+  security::ValidatorNull validator;
+
+  auto owner = m_keyChain.createIdentity("/access/policy/identity");
+  auto member = m_keyChain.createIdentity("/first/user", EcKeyParams());
+  auto producer = m_keyChain.createIdentity("/producer");
+
+  AccessManager manager(owner, "/dataset", m_keyChain, managerFace, EcKeyParams());
+  auto kdk = manager.addMember(member.getDefaultKey().getDefaultCertificate());
+  // much smaller than the 256-octet RSA-2048 ciphertext
+  BOOST_CHECK_LT(EncryptedContent(kdk.getContent().blockFromValue()).getPayloadKey().value_size(), 256);
+  advanceClocks(1_ms, 10);
+
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  Encryptor encryptor("/access/policy/identity/NAC/dataset", "/producer/data",
+                      signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+
+  std::string plaintext = "Data to encrypt";
+  auto block = encryptor.encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+               .wireEncode();
+
+  Decryptor decryptor(member.getDefaultKey(), validator, m_keyChain, consumerFace);
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (ConstBufferPtr buffer) {
+    ++nSuccesses;
+    BOOST_CHECK_EQUAL(std::string(buffer->get<char>(), buffer->size()), plaintext);
+  };
+  decryptor.decrypt(block, onSuccess, onFailure);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 1);
+  BOOST_CHECK_EQUAL(decryptor.m_eciesKdks.size(), 1);
+
+  // new CK, decrypted with the already unwrapped KDK
+  encryptor.regenerateCk();
+  advanceClocks(1_ms, 10);
+  decryptor.decrypt(encryptor.encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+                    .wireEncode(), onSuccess, onFailure);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 2);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nKdkCacheHits, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(Validation, IoKeyChainFixture)
+{
+  DummyClientFace managerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace producerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace consumerFace(m_io, m_keyChain, {true, true});
+  producerFace.linkTo(managerFace);
+  consumerFace.linkTo(managerFace);
+
+  auto owner = m_keyChain.createIdentity("/access/policy/identity");
+  auto member = m_keyChain.createIdentity("/first/user", EcKeyParams());
+  auto producer = m_keyChain.createIdentity("/producer");
+  auto rogue = m_keyChain.createIdentity("/rogue");
+
+  // only the data owner and the producer are trusted
+  security::Validator validator(std::make_unique<security::ValidationPolicySimpleHierarchy>(),
+                                std::make_unique<security::CertificateFetcherOffline>());
+  validator.loadAnchor("owner", Certificate(owner.getDefaultKey().getDefaultCertificate()));
+  validator.loadAnchor("producer", Certificate(producer.getDefaultKey().getDefaultCertificate()));
+
+  AccessManager manager(owner, "/dataset", m_keyChain, managerFace, EcKeyParams());
+  manager.addMember(member.getDefaultKey().getDefaultCertificate());
+  advanceClocks(1_ms, 10);
+
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  Encryptor encryptor("/access/policy/identity/NAC/dataset", "/producer/data",
+                      signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+
+  std::string plaintext = "Data to encrypt";
+  auto encrypt = [&] (Encryptor& encryptor) {
+    return encryptor.encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+           .wireEncode();
+  };
+
+  Decryptor decryptor(member.getDefaultKey(), validator, m_keyChain, consumerFace);
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (auto&&...) { ++nSuccesses; };
+  decryptor.decrypt(encrypt(encryptor), onSuccess, onFailure);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 1);
+  // CK and KDK
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidations, 2);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidationCacheHits, 0);
+
+  // a new CK under the same KEK and signer still goes through the trust policy
+  encryptor.regenerateCk();
+  advanceClocks(1_ms, 10);
+  decryptor.decrypt(encrypt(encryptor), onSuccess, onFailure);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 2);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidations, 3);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidationCacheHits, 0);
+
+  // CKs of an untrusted producer are rejected
+  security::ValidatorNull acceptAll;
+  Encryptor rogueEncryptor("/access/policy/identity/NAC/dataset", "/rogue/data",
+                           signingByIdentity(rogue), onFailure, acceptAll, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+
+  std::vector<ErrorCode> errors;
+  decryptor.decrypt(encrypt(rogueEncryptor), onSuccess,
+                    [&] (const ErrorCode& code, const std::string&) { errors.push_back(code); });
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 2);
+  BOOST_REQUIRE_EQUAL(errors.size(), 1);
+  BOOST_CHECK(errors.at(0) == ErrorCode::CkValidationFailure);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidationFailures, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(BatchSigning, IoKeyChainFixture)
+{
+  DummyClientFace managerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace producerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace consumerFace(m_io, m_keyChain, {true, true});
+  producerFace.linkTo(managerFace);
+  consumerFace.linkTo(managerFace);
+
+  auto owner = m_keyChain.createIdentity("/access/policy/identity");
+  auto producer = m_keyChain.createIdentity("/producer");
+  std::vector<Identity> members;
+  std::vector<Certificate> memberCerts;
+  for (int i = 0; i < 3; ++i) {
+    members.push_back(m_keyChain.createIdentity(Name("/member").appendNumber(i), EcKeyParams()));
+    memberCerts.push_back(members.back().getDefaultKey().getDefaultCertificate());
+  }
+
+  security::Validator validator(std::make_unique<security::ValidationPolicySimpleHierarchy>(),
+                                std::make_unique<security::CertificateFetcherOffline>());
+  validator.loadAnchor("owner", Certificate(owner.getDefaultKey().getDefaultCertificate()));
+  validator.loadAnchor("producer", Certificate(producer.getDefaultKey().getDefaultCertificate()));
+
+  AccessManager manager(owner, "/dataset", m_keyChain, managerFace, EcKeyParams());
+  manager.setBatchSigning(true);
+  manager.addMembers(memberCerts);
+  advanceClocks(1_ms, 10);
+
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  Encryptor encryptor("/access/policy/identity/NAC/dataset", "/producer/data",
+                      signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  encryptor.setBatchSigning(true);
+  encryptor.setCkPoolSize(3);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(encryptor.m_ckPool.size(), 3);
+  BOOST_CHECK(detail::isBatchSigned(*encryptor.m_ckPool.front().ckData));
+
+  std::string plaintext = "Data to encrypt";
+  Decryptor decryptor(members.at(1).getDefaultKey(), validator, m_keyChain, consumerFace);
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (ConstBufferPtr buffer) {
+    ++nSuccesses;
+    BOOST_CHECK_EQUAL(std::string(buffer->get<char>(), buffer->size()), plaintext);
+  };
+  for (int i = 0; i < 2; ++i) {
+    encryptor.regenerateCk(); // takes the next prepared CK
+    decryptor.decrypt(encryptor.encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+                      .wireEncode(), onSuccess, onFailure);
+    advanceClocks(1_ms, 10);
+  }
+  BOOST_CHECK_EQUAL(nSuccesses, 2);
+  // only the batch roots of the CKs and of the KDKs
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidations, 2);
+  // the second CK belongs to the same batch as the first one
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nValidationCacheHits, 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(SubDatasets, IoKeyChainFixture)
+{
+  DummyClientFace managerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace producerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace consumerFace(m_io, m_keyChain, {true, true});
+  producerFace.linkTo(managerFace);
+  consumerFace.linkTo(managerFace);
+  security::ValidatorNull validator;
+
+  auto owner = m_keyChain.createIdentity("/access/policy/identity");
+  auto member = m_keyChain.createIdentity("/first/user", EcKeyParams());
+  auto producer = m_keyChain.createIdentity("/producer");
+
+  AccessManager manager(owner, "/dataset", m_keyChain, managerFace, EcKeyParams());
+  manager.addMember(member.getDefaultKey().getDefaultCertificate());
+  advanceClocks(1_ms, 10);
+
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  std::vector<std::unique_ptr<Encryptor>> encryptors;
+  for (const auto& subDataset : {"/temperature", "/humidity/floor1", "/humidity/floor2"}) {
+    encryptors.push_back(std::make_unique<Encryptor>("/access/policy/identity/NAC/dataset", subDataset,
+                                                     Name("/producer").append(Name(subDataset)),
+                                                     signingByIdentity(producer), onFailure, validator,
+                                                     m_keyChain, producerFace));
+  }
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(encryptors.at(1)->m_kek.has_value());
+  BOOST_CHECK_EQUAL(splitDerivedKekName(encryptors.at(1)->m_kek->getName()).second, "/humidity/floor1");
+
+  std::string plaintext = "Data to encrypt";
+  Decryptor decryptor(member.getDefaultKey(), validator, m_keyChain, consumerFace);
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (ConstBufferPtr buffer) {
+    ++nSuccesses;
+    BOOST_CHECK_EQUAL(std::string(buffer->get<char>(), buffer->size()), plaintext);
+  };
+  for (auto& encryptor : encryptors) {
+    decryptor.decrypt(encryptor->encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+                      .wireEncode(), onSuccess, onFailure);
+    advanceClocks(1_ms, 10);
+  }
+  BOOST_CHECK_EQUAL(nSuccesses, 3);
+  // a single KDK for all sub-datasets
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nKdkFetches, 1);
+  BOOST_CHECK_EQUAL(decryptor.getMetrics().nKdkDerivations, 3);
+
+  // the KEK of a sub-dataset is not that of the dataset
+  Encryptor encryptor("/access/policy/identity/NAC/dataset", "/producer/data",
+                      signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+  BOOST_CHECK(encryptor.m_kek->getContent() != encryptors.at(0)->m_kek->getContent());
+}
+
+BOOST_FIXTURE_TEST_CASE(KeyTree, IoKeyChainFixture)
+{
+  DummyClientFace managerFace(m_io, m_keyChain, {true, true});
+  DummyClientFace producerFace(m_io, m_keyChain, {true, true});
+  producerFace.linkTo(managerFace);
+  security::ValidatorNull validator;
+
+  auto owner = m_keyChain.createIdentity("/access/policy/identity");
+  auto producer = m_keyChain.createIdentity("/producer");
+  AccessManager manager(owner, "/dataset", m_keyChain, managerFace, EcKeyParams());
+  manager.setKdkDistribution(KdkDistribution::KeyTree);
+  manager.setNackUnpublished(true);
+
+  std::vector<Identity> members;
+  std::vector<std::unique_ptr<DummyClientFace>> consumerFaces;
+  std::vector<std::unique_ptr<Decryptor>> decryptors;
+  for (int i = 0; i < 3; ++i) {
+    members.push_back(m_keyChain.createIdentity(Name("/member").appendNumber(i), EcKeyParams()));
+    manager.addMember(members.back().getDefaultKey().getDefaultCertificate());
+    consumerFaces.push_back(std::make_unique<DummyClientFace>(m_io, m_keyChain, DummyClientFace::Options{true, true}));
+    consumerFaces.back()->linkTo(managerFace);
+    decryptors.push_back(std::make_unique<Decryptor>(members.back().getDefaultKey(), validator,
+                                                     m_keyChain, *consumerFaces.back()));
+    decryptors.back()->setKdkDistribution(KdkDistribution::KeyTree);
+  }
+  advanceClocks(1_ms, 10);
+
+  auto onFailure = [] (const ErrorCode&, const std::string& msg) { BOOST_ERROR(msg); };
+  std::string plaintext = "Data to encrypt";
+  auto encrypt = [&] (Encryptor& encryptor) {
+    return encryptor.encrypt({reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size()})
+           .wireEncode();
+  };
+
+  Encryptor encryptor("/access/policy/identity/NAC/dataset", "/producer/data",
+                      signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+  auto block = encrypt(encryptor);
+
+  size_t nSuccesses = 0;
+  auto onSuccess = [&] (ConstBufferPtr buffer) {
+    ++nSuccesses;
+    BOOST_CHECK_EQUAL(std::string(buffer->get<char>(), buffer->size()), plaintext);
+  };
+  for (auto& decryptor : decryptors) {
+    decryptor->decrypt(block, onSuccess, onFailure);
+  }
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 3);
+  // the grant of the leaf node key, and the 2 node keys above it
+  BOOST_CHECK_EQUAL(decryptors.at(1)->getMetrics().nNodeKeyFetches, 3);
+  BOOST_CHECK_EQUAL(decryptors.at(1)->m_leafKeys.size(), 1);
+  auto blockBeforeRemoval = block;
+
+  // the new KEK is only used by producers that retrieve it after the removal
+  manager.removeMember(members.at(0).getName());
+  Encryptor newEncryptor("/access/policy/identity/NAC/dataset", "/producer/new-data",
+                         signingByIdentity(producer), onFailure, validator, m_keyChain, producerFace);
+  advanceClocks(1_ms, 10);
+  block = encrypt(newEncryptor);
+
+  std::vector<ErrorCode> errors;
+  decryptors.at(0)->decrypt(block, onSuccess,
+                            [&] (const ErrorCode& code, const std::string&) { errors.push_back(code); });
+  decryptors.at(1)->decrypt(block, onSuccess, onFailure);
+  decryptors.at(2)->decrypt(block, onSuccess, onFailure);
+  advanceClocks(1_s, 20);
+  BOOST_CHECK_EQUAL(nSuccesses, 5);
+  BOOST_REQUIRE_EQUAL(errors.size(), 1);
+  // the AccessManager does not have a node key wrapped by the removed leaf and says so right away
+  BOOST_CHECK(errors.at(0) == ErrorCode::KdkRetrievalFailure);
+  // starting from the cached leaf node key, only the 2 replaced node keys are retrieved
+  BOOST_CHECK_EQUAL(decryptors.at(1)->getMetrics().nNodeKeyFetches, 5);
+  BOOST_CHECK_EQUAL(decryptors.at(0)->m_leafKeys.size(), 0);
+
+  // the Encryptor created before the removal moves to the new KEK, and to a new CK, once its
+  // KEK is no longer fresh
+  advanceClocks(1_min, 61);
+  block = encrypt(encryptor);
+  BOOST_CHECK_NE(EncryptedContent(block).getKeyLocator(), EncryptedContent(blockBeforeRemoval).getKeyLocator());
+  errors.clear();
+  decryptors.at(0)->decrypt(block, onSuccess,
+                            [&] (const ErrorCode& code, const std::string&) { errors.push_back(code); });
+  decryptors.at(1)->decrypt(block, onSuccess, onFailure);
+  decryptors.at(2)->decrypt(block, onSuccess, onFailure);
+  advanceClocks(1_s, 20);
+  BOOST_CHECK_EQUAL(nSuccesses, 7);
+  BOOST_REQUIRE_EQUAL(errors.size(), 1);
+  BOOST_CHECK(errors.at(0) == ErrorCode::KdkRetrievalFailure);
+
+  // data encrypted before the removal remains accessible to the remaining members, as the KDK
+  // of the previous NAC key pair is wrapped by the new root key as well
+  DummyClientFace newConsumerFace(m_io, m_keyChain, {true, true});
+  newConsumerFace.linkTo(managerFace);
+  Decryptor newDecryptor(members.at(2).getDefaultKey(), validator, m_keyChain, newConsumerFace);
+  newDecryptor.setKdkDistribution(KdkDistribution::KeyTree);
+  newDecryptor.decrypt(blockBeforeRemoval, onSuccess, onFailure);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(nSuccesses, 8);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 } // namespace ndn::nac::tests
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * This file is part of NAC (Name-Based Access Control for NDN).
  * See AUTHORS.md for complete list of NAC authors and contributors.
@@ -152,6 +152,27 @@ BOOST_AUTO_TEST_CASE(KeyLocator)
   BOOST_CHECK_EQUAL(content.getKeyLocator(), "/random/name");
 }
 
+BOOST_AUTO_TEST_CASE(KeyLocatorWire)
+{
+  content.setPayload(randomBlock);
+
+  Block nameWire = Name("/random/name").wireEncode();
+  content.setKeyLocator(nameWire);
+  BOOST_REQUIRE(content.hasKeyLocator());
+  BOOST_CHECK_EQUAL(content.getKeyLocator(), "/random/name");
+  BOOST_CHECK_EQUAL(content.wireEncode(), "82[17]=84050103000000070E080672616E646F6D08046E616D65"_block);
+  // the encoded name is shared, not copied
+  BOOST_CHECK_EQUAL(content.getKeyLocatorWire().data(), nameWire.data());
+
+  BOOST_CHECK_THROW(content.setKeyLocator("0803616263"_block), EncryptedContent::Error);
+  BOOST_CHECK_THROW(content.setKeyLocator(Block(tlv::Name)), EncryptedContent::Error);
+  BOOST_CHECK_EQUAL(content.getKeyLocator(), "/random/name");
+
+  content.unsetKeyLocator();
+  BOOST_CHECK(!content.hasKeyLocator());
+  BOOST_CHECK_EQUAL(content.getKeyLocator(), Name());
+}
+
 BOOST_AUTO_TEST_SUITE_END() // SetterGetter
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2024, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -23,12 +23,17 @@
 #include "tests/io-key-chain-fixture.hpp"
 #include "tests/unit/static-data.hpp"
 
+#include <ndn-cxx/security/certificate-fetcher-offline.hpp>
 #include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/validation-policy-simple-hierarchy.hpp>
 #include <ndn-cxx/security/validator-null.hpp>
 #include <ndn-cxx/util/dummy-client-face.hpp>
 #include <ndn-cxx/util/string-helper.hpp>
 
+#include <boost/asio/post.hpp>
+
 #include <iostream>
+#include <set>
 
 namespace ndn::nac::tests {
 
@@ -177,6 +182,75 @@ BOOST_FIXTURE_TEST_CASE(KekRetrievalFailure, EncryptorFixture<false>)
   BOOST_CHECK_EQUAL(kek.getName().size(), 7);
 }
 
+BOOST_FIXTURE_TEST_CASE(KekRetryBackoff, EncryptorFixture<false>)
+{
+  size_t nErrors = 0;
+  onFailure.connect([&] (auto&&...) { ++nErrors; });
+  encryptor.setRetryPolicy({10_s, 40_s, 2.0, 0.0});
+
+  // each attempt takes 12 seconds (3 x 4_s Interest lifetime), followed by 10, 20, 40, 40 seconds
+  advanceClocks(1_s, 120);
+  BOOST_CHECK_EQUAL(nErrors, 4);
+  advanceClocks(1_s, 52);
+  BOOST_CHECK_EQUAL(nErrors, 5);
+}
+
+BOOST_AUTO_TEST_CASE(KekValidationFailure)
+{
+  // without trust anchors, the KEK cannot be validated
+  security::Validator untrusted(std::make_unique<security::ValidationPolicySimpleHierarchy>(),
+                                std::make_unique<security::CertificateFetcherOffline>());
+  DummyClientFace otherFace(m_io, m_keyChain, {true, true});
+  otherFace.linkTo(m_imsFace);
+
+  std::vector<ErrorCode> errors;
+  Encryptor otherEncryptor("/access/policy/identity/NAC/dataset", "/other/ck/prefix", signingWithSha256(),
+                           [&] (const ErrorCode& code, const std::string&) { errors.push_back(code); },
+                           untrusted, m_keyChain, otherFace);
+  advanceClocks(1_ms, 10);
+
+  BOOST_REQUIRE_EQUAL(errors.size(), 1);
+  BOOST_CHECK(errors.at(0) == ErrorCode::KekValidationFailure);
+  BOOST_CHECK(!otherEncryptor.m_kek.has_value());
+  BOOST_CHECK_EQUAL(otherEncryptor.size(), 0);
+
+  // retried after the delay given by the retry policy
+  advanceClocks(1_s, 61);
+  BOOST_CHECK_EQUAL(errors.size(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(Ready)
+{
+  std::vector<boost::system::error_code> results;
+  auto handler = [&] (const boost::system::error_code& ec) { results.push_back(ec); };
+
+  // KEK has been retrieved by the fixture
+  encryptor.ready(handler);
+  BOOST_CHECK(results.empty());
+  advanceClocks(1_ms);
+  BOOST_REQUIRE_EQUAL(results.size(), 1);
+  BOOST_CHECK(!results.at(0));
+
+  encryptor.m_kek.reset();
+  encryptor.ready(handler);
+  encryptor.ready(handler);
+  BOOST_CHECK_EQUAL(encryptor.m_isKekRetrievalInProgress, true);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(results.size(), 3);
+  BOOST_CHECK(!results.at(1) && !results.at(2));
+}
+
+BOOST_FIXTURE_TEST_CASE(ReadyFailure, EncryptorFixture<false>)
+{
+  std::vector<boost::system::error_code> results;
+  encryptor.ready([&] (const boost::system::error_code& ec) { results.push_back(ec); });
+
+  advanceClocks(1_s, 13); // 4_s default interest lifetime x 3
+  BOOST_REQUIRE_EQUAL(results.size(), 1);
+  BOOST_CHECK(results.at(0) == ErrorCode::KekRetrievalTimeout);
+  BOOST_CHECK_EQUAL(results.at(0).category().name(), std::string("ndn-nac"));
+}
+
 BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
 {
   encryptor.regenerateCk();
@@ -189,6 +263,7 @@ BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
   size_t nCk = 0;
   for (const auto& data : encryptor) {
     BOOST_TEST_MESSAGE(data.getName());
+    BOOST_CHECK(data.hasWire());
     if (data.getName().getPrefix(4) == Name("/some/ck/prefix/CK")) {
       ++nCk;
     }
@@ -196,6 +271,183 @@ BOOST_AUTO_TEST_CASE(EnumerateDataFromIms)
   BOOST_CHECK_EQUAL(nCk, 3);
 }
 
+BOOST_AUTO_TEST_CASE(UniqueCkVersions)
+{
+  // several rotations within the same millisecond
+  std::set<Name> ckNames{encryptor.m_ckName};
+  for (int i = 0; i < 5; ++i) {
+    auto previous = encryptor.m_ckName;
+    encryptor.regenerateCk();
+    BOOST_CHECK_GT(encryptor.m_ckName.at(-1).toVersion(), previous.at(-1).toVersion());
+    ckNames.insert(encryptor.m_ckName);
+  }
+  BOOST_CHECK_EQUAL(ckNames.size(), 6);
+}
+
+BOOST_AUTO_TEST_CASE(CkPool)
+{
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+  auto nPublished = encryptor.size();
+
+  encryptor.setCkPoolSize(3);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 0); // filled asynchronously
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 3);
+  // prepared CKs are not published
+  BOOST_CHECK_EQUAL(encryptor.size(), nPublished);
+
+  auto preparedCkName = encryptor.m_ckPool.front().ckName;
+  encryptor.regenerateCk();
+  BOOST_CHECK_EQUAL(encryptor.m_ckName, preparedCkName);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 2);
+  BOOST_CHECK_EQUAL(encryptor.size(), nPublished + 1);
+
+  face.sentData.clear();
+  face.receive(Interest(encryptor.m_ckName).setCanBePrefix(true).setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentData.at(0).getName().getPrefix(encryptor.m_ckName.size()), encryptor.m_ckName);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 3); // refilled
+
+  // CKs prepared for a different KEK are not used
+  Data newKek(*encryptor.m_kek);
+  newKek.setName(Name(newKek.getName().getPrefix(-1)).append("new-key-id"));
+  encryptor.m_kek = newKek;
+  encryptor.regenerateCk();
+  BOOST_CHECK(encryptor.m_ckPool.empty());
+  BOOST_CHECK_EQUAL(encryptor.size(), nPublished + 2);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 3);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.front().kekName, newKek.getName());
+
+  encryptor.setCkPoolSize(1);
+  BOOST_CHECK_EQUAL(encryptor.m_ckPool.size(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(KekRefresh)
+{
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+  auto& registry = MetricsRegistry::getDefault();
+  auto nPublished = encryptor.size();
+  auto before = registry.getSnapshot();
+  face.sentInterests.clear();
+
+  // the KEK is retrieved again once it is no longer fresh; as it has not changed, the CK data of
+  // the current CK is neither encrypted nor signed again
+  advanceClocks(DEFAULT_KEK_FRESHNESS_PERIOD);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentInterests.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentInterests.at(0).getName(), "/access/policy/identity/NAC/dataset/KEK");
+  auto after = registry.getSnapshot();
+  BOOST_CHECK_EQUAL(after.counters.at("nac.Encryptor.nCkDataPublished"),
+                    before.counters.at("nac.Encryptor.nCkDataPublished"));
+  BOOST_CHECK_EQUAL(encryptor.size(), nPublished);
+}
+
+BOOST_AUTO_TEST_CASE(RepublishCkData)
+{
+  auto& registry = MetricsRegistry::getDefault();
+  auto nPublished = encryptor.size();
+  auto nBytes = encryptor.m_imsBytes.get();
+  auto before = registry.getSnapshot();
+
+  // once the KEK is retrieved anew, the CK data of the current CK is encrypted again and
+  // replaces the previous packet with the same name, but a different digest
+  encryptor.m_kek.reset();
+  encryptor.ready([] (auto) {});
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(encryptor.m_kek.has_value());
+  auto after = registry.getSnapshot();
+  BOOST_CHECK_EQUAL(after.counters.at("nac.Encryptor.nCkDataPublished"),
+                    before.counters.at("nac.Encryptor.nCkDataPublished") + 1);
+
+  BOOST_CHECK_EQUAL(encryptor.size(), nPublished);
+  BOOST_CHECK_EQUAL(encryptor.m_imsBytes.get(), nBytes);
+  size_t nCkData = 0;
+  for (const auto& data : encryptor) {
+    if (encryptor.m_ckName.isPrefixOf(data.getName())) {
+      ++nCkData;
+    }
+  }
+  BOOST_CHECK_EQUAL(nCkData, 1);
+
+  face.sentData.clear();
+  face.receive(Interest(encryptor.m_ckName).setCanBePrefix(true).setMustBeFresh(true));
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE_EQUAL(face.sentData.size(), 1);
+  BOOST_CHECK_EQUAL(face.sentData.at(0).getFullName(),
+                    encryptor.m_ims.find(encryptor.m_ckName)->getFullName());
+}
+
+BOOST_AUTO_TEST_CASE(SharedCkPrefixThroughCache)
+{
+  // a second Encryptor with the same CK prefix on the same Face
+  Encryptor other("/access/policy/identity/NAC/dataset", "/some/ck/prefix", signingWithSha256(),
+                  [] (auto...) {}, validator, m_keyChain, face);
+  advanceClocks(1_ms, 10);
+  BOOST_REQUIRE(other.m_kek.has_value());
+
+  // the consumer reaches the Face through a forwarder that caches every Data packet
+  DummyClientFace consumerFace(m_io, m_keyChain, {true, true});
+  InMemoryStoragePersistent cache(m_io);
+  size_t nForwarded = 0;
+  consumerFace.onSendInterest.connect([&] (const Interest& interest) {
+    boost::asio::post(m_io, [&, interest] {
+      auto cached = cache.find(interest);
+      if (cached != nullptr) {
+        consumerFace.receive(*cached);
+      }
+      else {
+        ++nForwarded;
+        face.receive(interest);
+      }
+    });
+  });
+  signal::ScopedConnection toConsumer = face.onSendData.connect([&] (const Data& data) {
+    boost::asio::post(m_io, [&, data] {
+      cache.insert(data, data.getFreshnessPeriod());
+      consumerFace.receive(data);
+    });
+  });
+
+  std::vector<Data> received;
+  auto fetch = [&] (const Name& name) {
+    received.clear();
+    consumerFace.expressInterest(Interest(name).setCanBePrefix(true).setMustBeFresh(true),
+                                 [&] (const auto&, const Data& data) { received.push_back(data); },
+                                 [] (auto...) {}, [] (auto...) {});
+    advanceClocks(1_ms, 10);
+  };
+
+  // each Encryptor answers for its own CK only, and the other one does not pre-empt it with a
+  // NACK, neither at the consumer nor in the cache
+  for (const auto* e : {&encryptor, &other}) {
+    fetch(e->m_ckName);
+    BOOST_REQUIRE_EQUAL(received.size(), 1);
+    BOOST_CHECK(e->m_ckName.isPrefixOf(received.at(0).getName()));
+    BOOST_CHECK_NE(received.at(0).getContentType(), tlv::ContentType_Nack);
+  }
+  BOOST_CHECK_EQUAL(cache.size(), 2);
+  BOOST_CHECK_EQUAL(nForwarded, 2);
+  fetch(encryptor.m_ckName);
+  BOOST_CHECK_EQUAL(received.size(), 1);
+  BOOST_CHECK_EQUAL(nForwarded, 2);
+
+  // with NACKs enabled, a cached NACK no longer answers the Interests of a Decryptor, which carry
+  // MustBeFresh, once it is stale
+  encryptor.setNackUnpublished(true);
+  Name unknown("/some/ck/prefix/CK/unknown");
+  fetch(unknown);
+  BOOST_REQUIRE_EQUAL(received.size(), 1);
+  BOOST_CHECK_EQUAL(received.at(0).getContentType(), tlv::ContentType_Nack);
+  BOOST_CHECK_EQUAL(nForwarded, 3);
+  fetch(unknown);
+  BOOST_CHECK_EQUAL(nForwarded, 3); // from the cache
+  advanceClocks(NACK_FRESHNESS_PERIOD);
+  fetch(unknown);
+  BOOST_CHECK_EQUAL(nForwarded, 4);
+}
+
 BOOST_AUTO_TEST_CASE(GenerateTestData,
   * ut::description("regenerates the static test data used by other test cases")
   * ut::disabled()
@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "kdk-server.hpp"
+#include "access-manager.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/io-key-chain-fixture.hpp"
+
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace ndn::nac::tests {
+
+namespace fs = std::filesystem;
+
+class KdkServerFixture : public IoKeyChainFixture
+{
+public:
+  KdkServerFixture()
+    : managerFace(m_io, m_keyChain, {true, true})
+    , serverFace(m_io, m_keyChain, {true, true})
+    , accessIdentity(m_keyChain.createIdentity("/access/policy/identity"))
+    , userIdentities{m_keyChain.createIdentity("/first/user", RsaKeyParams()),
+                     m_keyChain.createIdentity("/second/user", RsaKeyParams())}
+    , manager(accessIdentity, Name("/dataset"), m_keyChain, managerFace)
+    , bundleFile(fs::temp_directory_path() / ("nac-test-" + std::to_string(random::generateWord64()) + ".bundle"))
+  {
+  }
+
+  ~KdkServerFixture()
+  {
+    std::error_code ec;
+    fs::remove(bundleFile, ec);
+  }
+
+  void
+  addMembers()
+  {
+    for (auto& user : userIdentities) {
+      manager.addMember(user.getDefaultKey().getDefaultCertificate());
+    }
+    advanceClocks(1_ms, 10);
+  }
+
+  void
+  writeFile(const std::string& contents)
+  {
+    std::ofstream file(bundleFile, std::ios::binary);
+    file << contents;
+  }
+
+  void
+  exportBundle()
+  {
+    std::ostringstream os;
+    manager.exportBundle(os);
+    writeFile(os.str());
+  }
+
+  Data
+  fetch(const Interest& interest)
+  {
+    serverFace.sentData.clear();
+    serverFace.receive(interest);
+    advanceClocks(1_ms, 10);
+    BOOST_REQUIRE_EQUAL(serverFace.sentData.size(), 1);
+    return serverFace.sentData.front();
+  }
+
+  Name
+  getKdkName(const Identity& user) const
+  {
+    for (const auto& data : manager) {
+      if (data.getName().get(-2) == KEK) {
+        return Name(data.getName().getPrefix(-2))
+          .append(KDK)
+          .append(data.getName().get(-1)) // key-id
+          .append(ENCRYPTED_BY)
+          .append(user.getDefaultKey().getName());
+      }
+    }
+    BOOST_FAIL("AccessManager has not published a KEK");
+    return {};
+  }
+
+public:
+  DummyClientFace managerFace;
+  DummyClientFace serverFace;
+  Identity accessIdentity;
+  std::vector<Identity> userIdentities;
+  AccessManager manager;
+  fs::path bundleFile;
+};
+
+BOOST_FIXTURE_TEST_SUITE(TestKdkServer, KdkServerFixture)
+
+BOOST_AUTO_TEST_CASE(ServeExported)
+{
+  addMembers();
+  exportBundle();
+  KdkServer server(bundleFile.string(), serverFace);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(server.size(), 3);
+  BOOST_CHECK_EQUAL(server.getNacIdentity(), "/access/policy/identity/NAC/dataset");
+
+  // the served packets are the ones signed by the AccessManager, byte for byte, also once
+  // they have been decoded from the mapping
+  for (const auto& data : manager) {
+    BOOST_TEST_MESSAGE(data.getName());
+    auto served = fetch(Interest(data.getName()));
+    BOOST_CHECK_EQUAL(served.wireEncode(), data.wireEncode());
+    BOOST_CHECK_EQUAL(fetch(Interest(data.getName())).wireEncode(), data.wireEncode());
+  }
+
+  auto kek = fetch(Interest("/access/policy/identity/NAC/dataset/KEK").setCanBePrefix(true).setMustBeFresh(true));
+  BOOST_CHECK_EQUAL(kek.getName().getPrefix(-1), "/access/policy/identity/NAC/dataset/KEK");
+  BOOST_CHECK_EQUAL(kek.getContentType(), tlv::ContentType_Key);
+
+  auto kdkName = getKdkName(userIdentities.at(1));
+  auto kdk = fetch(Interest(kdkName).setMustBeFresh(true));
+  BOOST_CHECK_EQUAL(kdk.getName(), kdkName);
+  BOOST_CHECK_EQUAL(fetch(Interest(kdk.getFullName())).getFullName(), kdk.getFullName());
+  BOOST_CHECK_EQUAL(fetch(Interest(kdk.getFullName()).setCanBePrefix(true)).getFullName(), kdk.getFullName());
+}
+
+BOOST_AUTO_TEST_CASE(PrefixSkipsMalformed)
+{
+  addMembers();
+  std::ostringstream os;
+  manager.exportBundle(os);
+  auto bundle = os.str();
+
+  auto kdkPrefix = Name("/access/policy/identity/NAC/dataset").append(KDK);
+  std::vector<Name> kdkNames;
+  for (const auto& data : manager) {
+    if (kdkPrefix.isPrefixOf(data.getName())) {
+      kdkNames.push_back(data.getName());
+    }
+  }
+  std::sort(kdkNames.begin(), kdkNames.end());
+  BOOST_REQUIRE_EQUAL(kdkNames.size(), 2);
+
+  // the packet with the greatest name under the prefix no longer has the name in the index, whose
+  // copy of the name precedes that of the packet
+  const auto& wire = kdkNames.back().wireEncode();
+  auto pos = bundle.rfind(std::string(reinterpret_cast<const char*>(wire.data()), wire.size()));
+  BOOST_REQUIRE_NE(pos, std::string::npos);
+  bundle[pos + wire.size() - 1] ^= 0x01;
+  writeFile(bundle);
+
+  KdkServer server(bundleFile.string(), serverFace);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(fetch(Interest(kdkPrefix).setCanBePrefix(true)).getName(), kdkNames.front());
+}
+
+BOOST_AUTO_TEST_CASE(Nack)
+{
+  addMembers();
+  exportBundle();
+  KdkServer server(bundleFile.string(), serverFace);
+  server.setNackUnpublished(true);
+  advanceClocks(1_ms, 10);
+
+  auto kdkName = getKdkName(userIdentities.at(0));
+  std::array<uint8_t, 32> otherDigest{};
+  for (const auto& name : {kdkName.getPrefix(-1),
+                           Name(kdkName).appendImplicitSha256Digest(otherDigest),
+                           Name("/access/policy/identity/NAC/dataset/KDK/unknown")}) {
+    auto nack = fetch(Interest(name));
+    BOOST_CHECK_EQUAL(nack.getName(), name);
+    BOOST_CHECK_EQUAL(nack.getContentType(), tlv::ContentType_Nack);
+    BOOST_CHECK_EQUAL(nack.getFreshnessPeriod(), NACK_FRESHNESS_PERIOD);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(KeyTree)
+{
+  manager.setKdkDistribution(KdkDistribution::KeyTree);
+  addMembers();
+  exportBundle();
+  KdkServer server(bundleFile.string(), serverFace);
+  advanceClocks(1_ms, 10);
+  BOOST_CHECK_EQUAL(server.size(), manager.size());
+  auto& nNodeKeysServed = MetricsRegistry::getDefault().getCounter("nac.KdkServer.nNodeKeysServed");
+  auto& nKdkServed = MetricsRegistry::getDefault().getCounter("nac.KdkServer.nKdkServed");
+  auto nNodeKeysBefore = nNodeKeysServed.get();
+  auto nKdksBefore = nKdkServed.get();
+
+  for (const auto& user : userIdentities) {
+    Name nodePrefix = Name(server.getNacIdentity()).append(NODE).append(ENCRYPTED_BY)
+                        .append(user.getDefaultKey().getName());
+    auto nodeKey = fetch(Interest(nodePrefix).setCanBePrefix(true));
+    BOOST_CHECK(nodePrefix.isPrefixOf(nodeKey.getName()));
+    BOOST_CHECK_NE(nodeKey.getContentType(), tlv::ContentType_Nack);
+  }
+  BOOST_CHECK_EQUAL(nNodeKeysServed.get() - nNodeKeysBefore, userIdentities.size());
+  BOOST_CHECK_EQUAL(nKdkServed.get(), nKdksBefore);
+}
+
+BOOST_AUTO_TEST_CASE(WriteDuplicate)
+{
+  addMembers();
+  std::vector<Data> packets(manager.begin(), manager.end());
+  packets.push_back(packets.back());
+  std::ostringstream os;
+  BOOST_CHECK_THROW(KdkServer::writeBundle(packets, os), KdkServer::Error);
+}
+
+BOOST_AUTO_TEST_CASE(LoadMalformed)
+{
+  BOOST_CHECK_THROW(KdkServer(bundleFile.string(), serverFace), KdkServer::Error); // no such file
+
+  writeFile("");
+  BOOST_CHECK_THROW(KdkServer(bundleFile.string(), serverFace), KdkServer::Error);
+
+  writeFile("not a bundle");
+  BOOST_CHECK_THROW(KdkServer(bundleFile.string(), serverFace), KdkServer::Error);
+
+  addMembers();
+  std::ostringstream os;
+  manager.exportBundle(os);
+  auto bundle = os.str();
+
+  // the last packet is cut short
+  writeFile(bundle.substr(0, bundle.size() - 1));
+  BOOST_CHECK_THROW(KdkServer(bundleFile.string(), serverFace), KdkServer::Error);
+
+  // no KEK
+  std::vector<Data> kdks;
+  for (const auto& data : manager) {
+    if (data.getName().get(-2) != KEK) {
+      kdks.push_back(data);
+    }
+  }
+  std::ostringstream kdksOnly;
+  KdkServer::writeBundle(kdks, kdksOnly);
+  writeFile(kdksOnly.str());
+  BOOST_CHECK_THROW(KdkServer(bundleFile.string(), serverFace), KdkServer::Error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn::nac::tests
@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "metrics.hpp"
+#include "metrics-dumper.hpp"
+
+#include "tests/boost-test.hpp"
+#include "tests/io-key-chain-fixture.hpp"
+
+#include <ndn-cxx/util/random.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace ndn::nac::tests {
+
+BOOST_AUTO_TEST_SUITE(TestMetrics)
+
+BOOST_AUTO_TEST_CASE(CounterAndGauge)
+{
+  Counter counter;
+  BOOST_CHECK_EQUAL(counter.get(), 0);
+  counter.increment();
+  counter.increment(4);
+  BOOST_CHECK_EQUAL(counter.get(), 5);
+
+  Gauge gauge;
+  gauge.increment(3);
+  gauge.decrement();
+  BOOST_CHECK_EQUAL(gauge.get(), 2);
+  gauge.set(10);
+  BOOST_CHECK_EQUAL(gauge.get(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(Totals)
+{
+  Counter totalCounter;
+  Gauge totalGauge;
+  LatencyHistogram totalHistogram;
+  {
+    Counter counter(totalCounter);
+    counter.increment(2);
+    BOOST_CHECK_EQUAL(counter.get(), 2);
+
+    Gauge gauge(totalGauge);
+    Gauge other(totalGauge);
+    gauge.increment(5);
+    other.set(3);
+    other.set(1);
+    gauge.decrement(2);
+    BOOST_CHECK_EQUAL(gauge.get(), 3);
+    BOOST_CHECK_EQUAL(totalGauge.get(), 4);
+
+    LatencyHistogram histogram(totalHistogram);
+    histogram.record(1_ms);
+  }
+  BOOST_CHECK_EQUAL(totalCounter.get(), 2);
+  // destroyed gauges no longer contribute
+  BOOST_CHECK_EQUAL(totalGauge.get(), 0);
+  BOOST_CHECK_EQUAL(totalHistogram.getSnapshot().count, 1);
+}
+
+BOOST_AUTO_TEST_CASE(EmptyHistogram)
+{
+  LatencyHistogram histogram;
+  auto snapshot = histogram.getSnapshot();
+  BOOST_CHECK_EQUAL(snapshot.count, 0);
+  BOOST_CHECK_EQUAL(snapshot.getMean(), 0_ns);
+  BOOST_CHECK_EQUAL(snapshot.getQuantile(0.5), 0_ns);
+  BOOST_CHECK_EQUAL(snapshot.getQuantile(0.99), 0_ns);
+}
+
+BOOST_AUTO_TEST_CASE(Buckets)
+{
+  LatencyHistogram histogram;
+  histogram.record(0_ns);
+  histogram.record(1_ns);
+  histogram.record(2_ns);
+  histogram.record(3_ns);
+  histogram.record(1000_ns); // [512, 1024)
+  histogram.record(-5_ns);   // clamped to zero
+  histogram.record(time::days(365));
+
+  auto snapshot = histogram.getSnapshot();
+  BOOST_CHECK_EQUAL(snapshot.count, 7);
+  BOOST_CHECK_EQUAL(snapshot.buckets[0], 3);
+  BOOST_CHECK_EQUAL(snapshot.buckets[1], 2);
+  BOOST_CHECK_EQUAL(snapshot.buckets[9], 1);
+  BOOST_CHECK_EQUAL(snapshot.buckets[LatencyHistogram::N_BUCKETS - 1], 1);
+  BOOST_CHECK_EQUAL(snapshot.max, time::days(365));
+}
+
+BOOST_AUTO_TEST_CASE(Quantiles)
+{
+  LatencyHistogram histogram;
+  for (int i = 0; i < 99; ++i) {
+    histogram.record(100_us);
+  }
+  histogram.record(10_ms);
+
+  auto snapshot = histogram.getSnapshot();
+  BOOST_CHECK_EQUAL(snapshot.count, 100);
+  BOOST_CHECK_EQUAL(snapshot.getMean(), 199_us);
+  // 100us falls into [65536, 131072) ns
+  BOOST_CHECK_EQUAL(snapshot.getQuantile(0.5), 131072_ns);
+  BOOST_CHECK_EQUAL(snapshot.getQuantile(0.98), 131072_ns);
+  // the upper bound of the last non-empty bucket is capped by the maximum
+  BOOST_CHECK_EQUAL(snapshot.getQuantile(0.995), 10_ms);
+}
+
+BOOST_AUTO_TEST_CASE(Registry)
+{
+  MetricsRegistry registry;
+  auto& counter = registry.getCounter("test.counter");
+  BOOST_CHECK_EQUAL(&registry.getCounter("test.counter"), &counter);
+  counter.increment(3);
+  registry.getGauge("test.gauge").set(-7);
+  registry.getHistogram("test.histogram").record(100_us);
+
+  auto snapshot = registry.getSnapshot();
+  BOOST_CHECK_EQUAL(snapshot.counters.at("test.counter"), 3);
+  BOOST_CHECK_EQUAL(snapshot.gauges.at("test.gauge"), -7);
+  BOOST_CHECK_EQUAL(snapshot.histograms.at("test.histogram").count, 1);
+
+  std::stringstream ss;
+  snapshot.save(ss);
+  auto loaded = MetricsRegistry::Snapshot::load(ss);
+  BOOST_CHECK(loaded.counters == snapshot.counters);
+  BOOST_CHECK(loaded.gauges == snapshot.gauges);
+  const auto& histogram = loaded.histograms.at("test.histogram");
+  BOOST_CHECK_EQUAL(histogram.count, 1);
+  BOOST_CHECK_EQUAL(histogram.sum, 100_us);
+  BOOST_CHECK_EQUAL(histogram.max, 100_us);
+  BOOST_CHECK(histogram.buckets == snapshot.histograms.at("test.histogram").buckets);
+}
+
+BOOST_AUTO_TEST_CASE(LoadMalformed)
+{
+  std::istringstream unknownType("counter a 1\nmeter b 2\n");
+  BOOST_CHECK_THROW(MetricsRegistry::Snapshot::load(unknownType), Error);
+
+  std::istringstream truncatedHistogram("histogram h 1 2 3 4\n");
+  BOOST_CHECK_THROW(MetricsRegistry::Snapshot::load(truncatedHistogram), Error);
+}
+
+class MetricsDumperFixture : public IoKeyChainFixture
+{
+public:
+  ~MetricsDumperFixture()
+  {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+  }
+
+  MetricsRegistry::Snapshot
+  load() const
+  {
+    std::ifstream file(path);
+    BOOST_REQUIRE(file);
+    return MetricsRegistry::Snapshot::load(file);
+  }
+
+public:
+  std::string path = (std::filesystem::temp_directory_path() /
+                      ("nac-test-" + std::to_string(random::generateWord64()) + ".metrics")).string();
+  MetricsRegistry registry;
+  MetricsDumper dumper{m_io, path, registry};
+};
+
+BOOST_FIXTURE_TEST_CASE(Dumper, MetricsDumperFixture)
+{
+  auto& counter = registry.getCounter("test.counter");
+  counter.increment();
+  dumper.dump();
+  BOOST_CHECK_EQUAL(load().counters.at("test.counter"), 1);
+  BOOST_CHECK(!std::filesystem::exists(path + ".tmp"));
+
+  dumper.setInterval(1_s);
+  counter.increment();
+  advanceClocks(100_ms, 11);
+  BOOST_CHECK_EQUAL(load().counters.at("test.counter"), 2);
+
+  dumper.setInterval(0_s);
+  counter.increment();
+  advanceClocks(100_ms, 20);
+  BOOST_CHECK_EQUAL(load().counters.at("test.counter"), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn::nac::tests
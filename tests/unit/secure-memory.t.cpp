@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "secure-memory.hpp"
+
+#include "tests/boost-test.hpp"
+
+namespace ndn::nac::tests {
+
+BOOST_AUTO_TEST_SUITE(TestSecureMemory)
+
+BOOST_AUTO_TEST_CASE(Arena)
+{
+  SecureArena arena(1);
+  BOOST_CHECK_GE(arena.getSize(), 1);
+  auto nSlots = arena.getNSlots();
+  BOOST_REQUIRE_GE(nSlots, 2);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots);
+
+  auto p = arena.allocate(AES_KEY_SIZE);
+  std::fill_n(p, AES_KEY_SIZE, 0xAB);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots - 1);
+  arena.deallocate(p, AES_KEY_SIZE);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots);
+
+  // the most recently released slot is reused, and has been wiped
+  auto q = arena.allocate(AES_KEY_SIZE);
+  BOOST_CHECK_EQUAL(q, p);
+  BOOST_CHECK(std::all_of(q, q + SecureArena::SMALL_SLOT_SIZE, [] (uint8_t b) { return b == 0; }));
+  arena.deallocate(q, AES_KEY_SIZE);
+
+  // larger than a small slot
+  auto medium = arena.allocate(SecureArena::SMALL_SLOT_SIZE + 1);
+  BOOST_CHECK(medium != p);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots - 1);
+  arena.deallocate(medium, SecureArena::SMALL_SLOT_SIZE + 1);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots);
+
+  // larger than any slot
+  auto large = arena.allocate(SecureArena::LARGE_SLOT_SIZE + 1);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots);
+  arena.deallocate(large, SecureArena::LARGE_SLOT_SIZE + 1);
+  BOOST_CHECK_EQUAL(arena.getNExhaustions(), 0);
+
+  // exhausted, once small requests have used up the large slots too
+  std::vector<uint8_t*> slots;
+  for (size_t i = 0; i < nSlots; ++i) {
+    slots.push_back(arena.allocate(1));
+  }
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), 0);
+  BOOST_CHECK_EQUAL(arena.getNExhaustions(), 0);
+  auto fromHeap = arena.allocate(1);
+  BOOST_CHECK(fromHeap != nullptr);
+  arena.deallocate(fromHeap, 1);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), 0);
+  BOOST_CHECK_EQUAL(arena.getNExhaustions(), 1);
+  for (auto slot : slots) {
+    arena.deallocate(slot, 1);
+  }
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nSlots);
+}
+
+BOOST_AUTO_TEST_CASE(DefaultSize)
+{
+  auto& arena = SecureArena::getDefault();
+  BOOST_CHECK_GE(arena.getSize(), SecureArena::DEFAULT_SIZE);
+  BOOST_CHECK_THROW(SecureArena::setDefaultSize(2 * SecureArena::DEFAULT_SIZE), Error);
+}
+
+BOOST_AUTO_TEST_CASE(Buffers)
+{
+  auto& arena = SecureArena::getDefault();
+  auto nFreeSlots = arena.getNFreeSlots();
+
+  const std::vector<uint8_t> bytes{1, 2, 3, 4};
+  SecureBuffer buffer(bytes);
+  BOOST_CHECK_EQUAL_COLLECTIONS(buffer.begin(), buffer.end(), bytes.begin(), bytes.end());
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nFreeSlots - 1);
+
+  SecureBuffer moved(std::move(buffer));
+  BOOST_CHECK(buffer.empty());
+  BOOST_CHECK_EQUAL(moved.size(), 4);
+  moved.shrink(2);
+  BOOST_CHECK_EQUAL(moved.size(), 2);
+
+  buffer = SecureBuffer(AES_KEY_SIZE);
+  BOOST_CHECK_EQUAL(buffer.size(), AES_KEY_SIZE);
+  BOOST_CHECK(std::all_of(buffer.begin(), buffer.end(), [] (uint8_t b) { return b == 0; }));
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nFreeSlots - 2);
+
+  moved = std::move(buffer);
+  BOOST_CHECK_EQUAL(arena.getNFreeSlots(), nFreeSlots - 1);
+
+  BOOST_CHECK(SecureBuffer().empty());
+  BOOST_CHECK(SecureBuffer(0).data() == nullptr);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace ndn::nac::tests
@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2023, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -84,10 +84,8 @@ nac_add_member(int argc, char** argv)
 
     auto cert = loadCertificate(member);
 
-    DummyClientFace face(keyChain); // to avoid any real IO
-    AccessManager manager(id, datasetName, keyChain, face);
-
-    auto kdk = manager.addMember(cert);
+    auto nacKey = AccessManager::getOrCreateNacKey(id, datasetName, keyChain);
+    auto kdk = AccessManager::makeKdk(id, nacKey, cert, keyChain);
 
     if (output == "-")
       io::save(kdk, std::cout);
@@ -0,0 +1,349 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "ndn-nac.hpp"
+#include "access-manager.hpp"
+#include "kdk-server.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace ndn::nac {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct MemberInput
+{
+  std::string source; // file name, or position in the stream
+  Certificate cert;
+};
+
+/**
+ * @brief Load base64-encoded certificates from @p is, separated by empty lines
+ */
+void
+loadCertificateStream(std::istream& is, const std::string& streamName, std::vector<MemberInput>& members)
+{
+  std::string line;
+  std::string encoded;
+  size_t index = 0;
+  auto flush = [&] {
+    if (encoded.empty()) {
+      return;
+    }
+    auto source = streamName + "#" + std::to_string(index++);
+    std::istringstream iss(encoded);
+    try {
+      members.push_back({source, io::loadTlv<Certificate>(iss, io::BASE64)});
+    }
+    catch (const io::Error& e) {
+      NDN_THROW_NESTED(std::runtime_error("Cannot load certificate " + source + ": " + e.what()));
+    }
+    encoded.clear();
+  };
+
+  while (std::getline(is, line)) {
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      flush();
+    }
+    else {
+      encoded += line;
+      encoded += '\n';
+    }
+  }
+  flush();
+}
+
+/**
+ * @brief Load the certificate in file @p path, or all certificates in directory @p path
+ */
+void
+loadCertificates(const std::string& path, std::vector<MemberInput>& members)
+{
+  if (path == "-") {
+    return loadCertificateStream(std::cin, "stdin", members);
+  }
+
+  if (!fs::is_directory(path)) {
+    members.push_back({path, loadCertificate(path)});
+    return;
+  }
+
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::directory_iterator(path)) {
+    if (entry.is_regular_file()) {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  for (const auto& file : files) {
+    members.push_back({file.string(), loadCertificate(file.string())});
+  }
+}
+
+/**
+ * @brief Load the certificates listed in @p manifest, one file or directory per line
+ *
+ * Empty lines and lines starting with `#` are ignored.  Relative paths are relative to the
+ * directory of the manifest.
+ */
+void
+loadManifest(const std::string& manifest, std::vector<MemberInput>& members)
+{
+  std::ifstream file;
+  if (manifest != "-") {
+    file.open(manifest);
+    if (!file) {
+      NDN_THROW(std::runtime_error("Cannot open '" + manifest + "'"));
+    }
+  }
+  std::istream& is = manifest == "-" ? std::cin : file;
+  auto base = manifest == "-" ? fs::path() : fs::path(manifest).parent_path();
+
+  std::string line;
+  while (std::getline(is, line)) {
+    auto begin = line.find_first_not_of(" \t");
+    auto end = line.find_last_not_of(" \t\r");
+    if (begin == std::string::npos || line[begin] == '#') {
+      continue;
+    }
+    fs::path path(line.substr(begin, end - begin + 1));
+    loadCertificates((path.is_absolute() ? path : base / path).string(), members);
+  }
+}
+
+} // namespace
+
+int
+nac_add_members(int argc, char** argv)
+{
+  namespace po = boost::program_options;
+
+  Name identityName;
+  Name datasetName;
+  std::string outputDir;
+  std::string wireFile;
+  std::string bundleFile;
+  std::string manifest;
+  std::vector<std::string> inputs;
+  size_t nWorkers = std::max(std::thread::hardware_concurrency(), 1U);
+
+  po::options_description description("General Usage\n"
+                                      "  ndn-nac add-members [-h] [-d dataset] [-j workers] (-o dir | -w file | -b file)\n"
+                                      "                      [-i] identity [-f manifest] [member...]\n"
+                                      "General options");
+  description.add_options()
+    ("help,h", "Produce help message")
+    ("identity,i", po::value<Name>(&identityName), "Data owner's namespace identity")
+    ("dataset,d", po::value<Name>(&datasetName), "Name of dataset to control")
+    ("member,m", po::value<std::vector<std::string>>(&inputs),
+     "File with a member's certificate, or directory of such files; "
+     "'-' reads base64 certificates separated by empty lines from stdin")
+    ("manifest,f", po::value<std::string>(&manifest),
+     "File listing member certificate files or directories, one per line, stdin if '-'")
+    ("output-dir,o", po::value<std::string>(&outputDir),
+     "Directory to write each KDK into, as a base64 file named after the position of the member")
+    ("wire,w", po::value<std::string>(&wireFile),
+     "File to write all KDKs into, concatenated in TLV wire format, stdout if '-'")
+    ("bundle,b", po::value<std::string>(&bundleFile),
+     "File to write the KEK and all KDKs into, as a bundle for 'ndn-nac serve-bundle'; "
+     "an existing file is replaced, so that a running server keeps serving the previous bundle")
+    ("workers,j", po::value<size_t>(&nWorkers)->default_value(nWorkers), "Number of parallel workers")
+    ;
+
+  po::positional_options_description p;
+  p.add("identity", 1);
+  p.add("member", -1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(description).positional(p).run(), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (vm.count("help") != 0) {
+    std::cerr << description << std::endl;
+    return 0;
+  }
+
+  if (vm.count("identity") == 0) {
+    std::cerr << "ERROR: identity must be specified" << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (inputs.empty() && manifest.empty()) {
+    std::cerr << "ERROR: members or manifest must be specified" << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (!outputDir.empty() + !wireFile.empty() + !bundleFile.empty() != 1) {
+    std::cerr << "ERROR: exactly one of output-dir, wire, and bundle must be specified" << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (nWorkers == 0) {
+    std::cerr << "ERROR: workers must be positive" << std::endl;
+    return 1;
+  }
+
+  try {
+    // all certificates are loaded upfront, so that a malformed one aborts before any work is done
+    std::vector<MemberInput> members;
+    if (!manifest.empty()) {
+      loadManifest(manifest, members);
+    }
+    for (const auto& input : inputs) {
+      loadCertificates(input, members);
+    }
+
+    Name nacIdentityName;
+    Name nacKeyName;
+    std::optional<Data> kek;
+    {
+      KeyChain keyChain;
+      Identity id = keyChain.getPib().getIdentity(identityName);
+      auto nacKey = AccessManager::getOrCreateNacKey(id, datasetName, keyChain);
+      nacIdentityName = nacKey.getIdentity();
+      nacKeyName = nacKey.getName();
+      if (!bundleFile.empty()) {
+        kek = AccessManager::makeKek(id, nacKey, keyChain);
+      }
+    }
+
+    // KeyChain is not thread-safe, so every worker opens its own, and KDKs are generated with
+    // the stateless AccessManager::makeKdk()
+    std::vector<std::optional<Data>> kdks(members.size());
+    std::vector<std::string> errors(members.size());
+    std::vector<std::exception_ptr> workerErrors(std::min(nWorkers, members.size()));
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    for (size_t w = 0; w < workerErrors.size(); ++w) {
+      workers.emplace_back([&, w] {
+        try {
+          KeyChain keyChain;
+          Identity id = keyChain.getPib().getIdentity(identityName);
+          Key nacKey = keyChain.getPib().getIdentity(nacIdentityName).getKey(nacKeyName);
+          for (size_t i = next++; i < members.size(); i = next++) {
+            try {
+              kdks[i] = AccessManager::makeKdk(id, nacKey, members[i].cert, keyChain);
+            }
+            catch (const std::exception& e) {
+              errors[i] = e.what();
+            }
+          }
+        }
+        catch (const std::exception&) {
+          workerErrors[w] = std::current_exception();
+        }
+      });
+    }
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    for (const auto& error : workerErrors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+    bool isOk = true;
+    for (size_t i = 0; i < members.size(); ++i) {
+      if (!kdks[i]) {
+        std::cerr << "ERROR: Cannot create KDK for " << members[i].source << ": " << errors[i] << std::endl;
+        isOk = false;
+      }
+    }
+    if (!isOk) {
+      return 1;
+    }
+
+    if (!bundleFile.empty()) {
+      // the online host serves the bundle without access to the data owner's keys
+      std::vector<Data> packets{*kek};
+      for (const auto& kdk : kdks) {
+        packets.push_back(*kdk);
+      }
+      // a KdkServer may have the previous bundle mapped, so the file is replaced, not rewritten
+      auto tmpFile = bundleFile + ".tmp";
+      std::ofstream file(tmpFile, std::ios::binary);
+      if (!file) {
+        NDN_THROW(std::runtime_error("Cannot open '" + tmpFile + "'"));
+      }
+      KdkServer::writeBundle(std::move(packets), file);
+      file.close();
+      if (!file) {
+        NDN_THROW(std::runtime_error("Cannot write '" + tmpFile + "'"));
+      }
+      fs::rename(tmpFile, bundleFile);
+    }
+    else if (!wireFile.empty()) {
+      std::ofstream file;
+      if (wireFile != "-") {
+        file.open(wireFile, std::ios::binary);
+        if (!file) {
+          NDN_THROW(std::runtime_error("Cannot open '" + wireFile + "'"));
+        }
+      }
+      std::ostream& os = wireFile == "-" ? std::cout : file;
+      for (const auto& kdk : kdks) {
+        const auto& wire = kdk->wireEncode();
+        os.write(reinterpret_cast<const char*>(wire.data()), static_cast<std::streamsize>(wire.size()));
+      }
+      os.flush();
+      if (!os) {
+        NDN_THROW(std::runtime_error("Cannot write '" + wireFile + "'"));
+      }
+    }
+    else {
+      fs::create_directories(outputDir);
+      auto width = std::to_string(members.size()).size();
+      for (size_t i = 0; i < kdks.size(); ++i) {
+        std::ostringstream fileName;
+        fileName << std::setw(width) << std::setfill('0') << i << ".kdk";
+        auto path = (fs::path(outputDir) / fileName.str()).string();
+        io::save(*kdks[i], path);
+        // lets scripts map the input certificates to KDK files and names
+        std::cout << path << ' ' << members[i].source << ' ' << kdks[i]->getName() << '\n';
+      }
+    }
+
+    return 0;
+  }
+  catch (const std::runtime_error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+} // namespace ndn::nac
@@ -0,0 +1,550 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "ndn-nac.hpp"
+#include "access-manager.hpp"
+#include "decryptor.hpp"
+#include "encryptor.hpp"
+#include "version.hpp"
+
+#include <ndn-cxx/security/signing-helpers.hpp>
+#include <ndn-cxx/security/validator-null.hpp>
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/random.hpp>
+
+#include <boost/algorithm/string/split.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <thread>
+
+namespace ndn::nac {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Samples = std::vector<std::chrono::nanoseconds>;
+
+struct BenchResult
+{
+  std::string name;
+  std::string keyType; // empty if not applicable
+  size_t payloadSize = 0; // zero if not applicable
+  size_t nThreads = 1;
+  Samples samples; // latency of each operation, sorted
+  std::chrono::nanoseconds wallTime{0}; // of all operations, which may overlap
+
+  double
+  getOpsPerSec() const
+  {
+    return wallTime.count() > 0 ? static_cast<double>(samples.size()) * 1e9 / wallTime.count() : 0.0;
+  }
+
+  std::chrono::nanoseconds
+  getQuantile(double p) const
+  {
+    if (samples.empty()) {
+      return std::chrono::nanoseconds(0);
+    }
+    return samples[std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()))];
+  }
+
+  std::chrono::nanoseconds
+  getMean() const
+  {
+    if (samples.empty()) {
+      return std::chrono::nanoseconds(0);
+    }
+    return std::accumulate(samples.begin(), samples.end(), std::chrono::nanoseconds(0)) /
+           static_cast<int64_t>(samples.size());
+  }
+};
+
+template<typename F>
+void
+measure(Samples& samples, F&& f)
+{
+  auto before = Clock::now();
+  f();
+  samples.push_back(Clock::now() - before);
+}
+
+std::unique_ptr<KeyParams>
+makeKeyParams(const std::string& keyType)
+{
+  // rsa, rsa-3072, ec, ec-384, ...
+  auto dash = keyType.find('-');
+  auto type = keyType.substr(0, dash);
+  uint32_t size = 0;
+  if (dash != std::string::npos) {
+    size = boost::lexical_cast<uint32_t>(keyType.substr(dash + 1));
+  }
+
+  if (type == "rsa") {
+    return size == 0 ? std::make_unique<RsaKeyParams>() : std::make_unique<RsaKeyParams>(size);
+  }
+  if (type == "ec") {
+    return size == 0 ? std::make_unique<EcKeyParams>() : std::make_unique<EcKeyParams>(size);
+  }
+  NDN_THROW(std::invalid_argument("Unsupported key type '" + keyType + "'"));
+}
+
+std::vector<size_t>
+parseList(const std::string& list, const std::string& option)
+{
+  std::vector<std::string> items;
+  boost::algorithm::split(items, list, [] (char c) { return c == ','; });
+  std::vector<size_t> values;
+  for (const auto& item : items) {
+    try {
+      values.push_back(boost::lexical_cast<size_t>(item));
+    }
+    catch (const boost::bad_lexical_cast&) {
+      NDN_THROW(std::invalid_argument("Invalid value '" + item + "' of " + option));
+    }
+  }
+  return values;
+}
+
+/**
+ * @brief Data owner, producers, and consumers of one dataset, connected with DummyClientFaces
+ *        and using an in-memory KeyChain
+ */
+class BenchSetup
+{
+public:
+  BenchSetup(const std::string& keyType, size_t nPairs)
+    : m_keyParams(makeKeyParams(keyType))
+  {
+    m_producerFace.linkTo(m_managerFace);
+    m_consumerFace.linkTo(m_managerFace);
+
+    auto owner = m_keyChain.createIdentity("/owner", *m_keyParams);
+    m_manager.emplace(owner, "/dataset", m_keyChain, m_managerFace, *m_keyParams);
+    auto consumer = m_keyChain.createIdentity("/consumer", *m_keyParams);
+    m_manager->addMember(consumer.getDefaultKey().getDefaultCertificate());
+
+    // failures are reported through ready()
+    auto onFailure = [] (auto&&...) {};
+    auto producer = m_keyChain.createIdentity("/producer", *m_keyParams);
+    size_t nReady = 0;
+    boost::system::error_code error;
+    for (size_t i = 0; i < nPairs; ++i) {
+      encryptors.push_back(std::make_unique<Encryptor>("/owner/NAC/dataset", Name(producer.getName()).appendNumber(i),
+                                                       signingByIdentity(producer), onFailure,
+                                                       m_validator, m_keyChain, m_producerFace));
+      encryptors.back()->ready([&] (const boost::system::error_code& ec) {
+        ++nReady;
+        error = ec ? ec : error;
+      });
+      decryptors.push_back(std::make_unique<Decryptor>(consumer.getDefaultKey(), m_validator,
+                                                       m_keyChain, m_consumerFace));
+    }
+    poll([&] { return nReady == nPairs; });
+    if (nReady != nPairs || error) {
+      NDN_THROW(std::runtime_error("KEK could not be retrieved" + (error ? ": " + error.message() : "")));
+    }
+  }
+
+  AccessManager&
+  getManager()
+  {
+    return *m_manager;
+  }
+
+  KeyChain&
+  getKeyChain()
+  {
+    return m_keyChain;
+  }
+
+  const KeyParams&
+  getKeyParams() const
+  {
+    return *m_keyParams;
+  }
+
+  /**
+   * @brief Decrypt @p block asynchronously, retrieving the CK (and KDK) as needed
+   */
+  void
+  decrypt(Decryptor& decryptor, const Block& block)
+  {
+    bool isDone = false;
+    std::string error;
+    decryptor.decrypt(block,
+                      [&] (ConstBufferPtr) { isDone = true; },
+                      [&] (const ErrorCode&, const std::string& msg) { isDone = true; error = msg; });
+    poll([&] { return isDone; });
+    if (!isDone || !error.empty()) {
+      NDN_THROW(std::runtime_error("Decryption failed: " + (isDone ? error : "timed out")));
+    }
+  }
+
+private:
+  /**
+   * @brief Deliver packets between the faces until @p isDone or nothing is left to do
+   */
+  template<typename Predicate>
+  void
+  poll(const Predicate& isDone)
+  {
+    for (size_t n = 1; n > 0 && !isDone();) {
+      m_io.restart();
+      n = m_io.poll();
+    }
+  }
+
+private:
+  std::unique_ptr<KeyParams> m_keyParams;
+  boost::asio::io_context m_io;
+  KeyChain m_keyChain{"pib-memory:", "tpm-memory:"};
+  DummyClientFace m_managerFace{m_io, m_keyChain, {true, true}};
+  DummyClientFace m_producerFace{m_io, m_keyChain, {true, true}};
+  DummyClientFace m_consumerFace{m_io, m_keyChain, {true, true}};
+  security::ValidatorNull m_validator;
+  std::optional<AccessManager> m_manager;
+
+public: // destroyed before the faces they use
+  std::vector<std::unique_ptr<Encryptor>> encryptors;
+  std::vector<std::unique_ptr<Decryptor>> decryptors;
+};
+
+class Bench
+{
+public:
+  struct Options
+  {
+    std::vector<std::string> keyTypes;
+    std::vector<size_t> payloadSizes;
+    std::vector<size_t> threadCounts;
+    size_t nIterations = 0;
+    size_t nRotations = 0;
+    size_t nMembers = 0;
+  };
+
+  explicit
+  Bench(Options options)
+    : m_options(std::move(options))
+  {
+  }
+
+  void
+  run()
+  {
+    for (const auto& keyType : m_options.keyTypes) {
+      std::cerr << "Running " << keyType << " benchmarks..." << std::endl;
+      runKeyManagement(keyType);
+    }
+
+    // AES-CBC encryption and decryption do not depend on the type of KEK/KDK
+    for (auto nThreads : m_options.threadCounts) {
+      std::cerr << "Running encrypt/decrypt benchmarks with " << nThreads << " thread(s)..." << std::endl;
+      BenchSetup setup(m_options.keyTypes.front(), nThreads);
+      for (auto size : m_options.payloadSizes) {
+        runEncryptDecrypt(setup, size, nThreads);
+      }
+    }
+  }
+
+  void
+  printTable(std::ostream& os) const
+  {
+    auto us = [] (std::chrono::nanoseconds ns) {
+      return std::chrono::duration<double, std::micro>(ns).count();
+    };
+
+    os << std::left << std::setw(24) << "operation" << std::setw(10) << "key"
+       << std::right << std::setw(9) << "payload" << std::setw(8) << "threads"
+       << std::setw(9) << "ops" << std::setw(13) << "ops/s"
+       << std::setw(11) << "mean(us)" << std::setw(11) << "p50(us)" << std::setw(11) << "p90(us)"
+       << std::setw(11) << "p99(us)" << std::setw(11) << "max(us)" << '\n';
+    os << std::fixed << std::setprecision(1);
+    for (const auto& r : m_results) {
+      os << std::left << std::setw(24) << r.name << std::setw(10) << (r.keyType.empty() ? "-" : r.keyType)
+         << std::right << std::setw(9) << (r.payloadSize == 0 ? "-" : std::to_string(r.payloadSize))
+         << std::setw(8) << r.nThreads << std::setw(9) << r.samples.size()
+         << std::setw(13) << r.getOpsPerSec()
+         << std::setw(11) << us(r.getMean()) << std::setw(11) << us(r.getQuantile(0.5))
+         << std::setw(11) << us(r.getQuantile(0.9)) << std::setw(11) << us(r.getQuantile(0.99))
+         << std::setw(11) << us(r.getQuantile(1.0)) << '\n';
+    }
+  }
+
+  void
+  printJson(std::ostream& os) const
+  {
+    os << "{\n"
+       << "  \"library\": \"ndn-nac\",\n"
+       << "  \"version\": \"" << NDN_NAC_VERSION_BUILD_STRING << "\",\n"
+       << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n"
+       << "  \"benchmarks\": [";
+    bool isFirst = true;
+    for (const auto& r : m_results) {
+      os << (isFirst ? "\n" : ",\n");
+      isFirst = false;
+      os << "    {\"name\": \"" << r.name << "\""
+         << ", \"key_type\": \"" << r.keyType << "\""
+         << ", \"payload_size\": " << r.payloadSize
+         << ", \"threads\": " << r.nThreads
+         << ", \"operations\": " << r.samples.size()
+         << ", \"wall_ns\": " << r.wallTime.count()
+         << ", \"ops_per_sec\": " << r.getOpsPerSec()
+         << ", \"mean_ns\": " << r.getMean().count()
+         << ", \"p50_ns\": " << r.getQuantile(0.5).count()
+         << ", \"p90_ns\": " << r.getQuantile(0.9).count()
+         << ", \"p99_ns\": " << r.getQuantile(0.99).count()
+         << ", \"max_ns\": " << r.getQuantile(1.0).count()
+         << "}";
+    }
+    os << "\n  ]\n"
+       << "}\n";
+  }
+
+private:
+  void
+  runKeyManagement(const std::string& keyType)
+  {
+    BenchSetup setup(keyType, 1);
+    auto& keyChain = setup.getKeyChain();
+
+    // member keys are generated upfront, so that only the KDK creation is measured
+    std::vector<Certificate> memberCerts;
+    for (size_t i = 0; i < m_options.nMembers; ++i) {
+      auto member = keyChain.createIdentity(Name("/member").appendNumber(i), setup.getKeyParams());
+      memberCerts.push_back(member.getDefaultKey().getDefaultCertificate());
+    }
+
+    // KDK: SafeBag export of the NAC key, encryption of its password for the member, signing
+    auto owner = keyChain.getPib().getIdentity("/owner");
+    auto nacKey = AccessManager::getOrCreateNacKey(owner, "/dataset", keyChain, setup.getKeyParams());
+    addResult("kdk-wrap", keyType, [&] (Samples& samples) {
+      for (const auto& cert : memberCerts) {
+        measure(samples, [&] { AccessManager::makeKdk(owner, nacKey, cert, keyChain); });
+      }
+    });
+
+    // the same, plus publication and bookkeeping by the AccessManager
+    addResult("add-member", keyType, [&] (Samples& samples) {
+      for (const auto& cert : memberCerts) {
+        measure(samples, [&] { setup.getManager().addMember(cert); });
+      }
+    });
+
+    // CK rotation: generation of the CK, its encryption with the KEK, and signing of the CK data
+    auto& encryptor = *setup.encryptors.front();
+    auto& decryptor = *setup.decryptors.front();
+    std::vector<Block> blocks;
+    const uint8_t payload[16] = {};
+    addResult("ck-rotation", keyType, [&] (Samples& samples) {
+      for (size_t i = 0; i < m_options.nRotations; ++i) {
+        measure(samples, [&] { encryptor.regenerateCk(); });
+        blocks.push_back(encryptor.encrypt(payload).wireEncode());
+      }
+    });
+
+    // first decryption with every new CK: retrieval of the CK data and decryption of the CK with
+    // the KDK, which is retrieved and decrypted once beforehand
+    setup.decrypt(decryptor, blocks.front());
+    addResult("ck-unwrap", keyType, [&] (Samples& samples) {
+      for (size_t i = 1; i < blocks.size(); ++i) {
+        measure(samples, [&] { setup.decrypt(decryptor, blocks[i]); });
+      }
+    });
+  }
+
+  void
+  runEncryptDecrypt(BenchSetup& setup, size_t payloadSize, size_t nThreads)
+  {
+    std::vector<uint8_t> payload(payloadSize);
+    random::generateSecureBytes(payload);
+
+    // every thread uses its own Encryptor and Decryptor, which are not thread-safe
+    for (size_t i = 0; i < nThreads; ++i) {
+      setup.decrypt(*setup.decryptors[i], setup.encryptors[i]->encrypt(payload).wireEncode());
+    }
+
+    std::vector<Samples> encryptSamples(nThreads);
+    std::vector<Samples> decryptSamples(nThreads);
+    std::vector<std::exception_ptr> errors(nThreads);
+    std::vector<std::thread> threads;
+    auto startTime = Clock::now();
+    for (size_t t = 0; t < nThreads; ++t) {
+      threads.emplace_back([&, t] {
+        try {
+          auto& encryptor = *setup.encryptors[t];
+          auto& decryptor = *setup.decryptors[t];
+          std::vector<uint8_t> plaintext(payloadSize + AES_IV_SIZE);
+          encryptSamples[t].reserve(m_options.nIterations);
+          decryptSamples[t].reserve(m_options.nIterations);
+          for (size_t i = 0; i < m_options.nIterations; ++i) {
+            Block block;
+            measure(encryptSamples[t], [&] { block = encryptor.encrypt(payload).wireEncode(); });
+            measure(decryptSamples[t], [&] {
+              if (decryptor.tryDecrypt(block, plaintext) != payloadSize) {
+                NDN_THROW(std::runtime_error("Decryption failed"));
+              }
+            });
+          }
+        }
+        catch (const std::exception&) {
+          errors[t] = std::current_exception();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto wallTime = Clock::now() - startTime;
+    for (const auto& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+
+    // both operations run interleaved, so each is credited with its share of the wall time
+    auto addSamples = [&] (const std::string& name, std::vector<Samples>& perThread,
+                           const std::vector<Samples>& other) {
+      BenchResult result{name, "", payloadSize, nThreads};
+      std::chrono::nanoseconds busy(0), otherBusy(0);
+      for (size_t t = 0; t < nThreads; ++t) {
+        busy += std::accumulate(perThread[t].begin(), perThread[t].end(), std::chrono::nanoseconds(0));
+        otherBusy += std::accumulate(other[t].begin(), other[t].end(), std::chrono::nanoseconds(0));
+        result.samples.insert(result.samples.end(), perThread[t].begin(), perThread[t].end());
+      }
+      auto total = busy + otherBusy;
+      auto share = total.count() > 0 ? static_cast<double>(busy.count()) / total.count() : 1.0;
+      result.wallTime = std::chrono::nanoseconds(static_cast<int64_t>(wallTime.count() * share));
+      std::sort(result.samples.begin(), result.samples.end());
+      m_results.push_back(std::move(result));
+    };
+    addSamples("encrypt", encryptSamples, decryptSamples);
+    addSamples("decrypt", decryptSamples, encryptSamples);
+  }
+
+  template<typename F>
+  void
+  addResult(const std::string& name, const std::string& keyType, F&& run)
+  {
+    // operations run one after another, so the throughput follows from their total latency,
+    // which excludes the preparation work between them
+    BenchResult result{name, keyType};
+    run(result.samples);
+    result.wallTime = std::accumulate(result.samples.begin(), result.samples.end(), std::chrono::nanoseconds(0));
+    std::sort(result.samples.begin(), result.samples.end());
+    m_results.push_back(std::move(result));
+  }
+
+private:
+  Options m_options;
+  std::vector<BenchResult> m_results;
+};
+
+} // namespace
+
+int
+nac_bench(int argc, char** argv)
+{
+  namespace po = boost::program_options;
+
+  std::string keyTypes = "rsa,ec";
+  std::string payloadSizes = "64,1024,16384";
+  auto nCpus = std::max(std::thread::hardware_concurrency(), 1U);
+  std::string threadCounts = nCpus > 1 ? "1," + std::to_string(nCpus) : "1";
+  Bench::Options options;
+
+  po::options_description description("General Usage\n"
+                                      "  ndn-nac bench [-h] [-k key-types] [-s sizes] [-t threads] [-n iterations]\n"
+                                      "                [-r rotations] [-m members] [-j]\n"
+                                      "General options");
+  description.add_options()
+    ("help,h", "Produce help message")
+    ("key-types,k", po::value<std::string>(&keyTypes)->default_value(keyTypes),
+     "Comma-separated types of KEK/KDK and member keys: rsa, ec, or with key size, e.g., rsa-3072, ec-384")
+    ("payload-sizes,s", po::value<std::string>(&payloadSizes)->default_value(payloadSizes),
+     "Comma-separated payload sizes to encrypt and decrypt, in octets")
+    ("threads,t", po::value<std::string>(&threadCounts)->default_value(threadCounts),
+     "Comma-separated numbers of threads that encrypt and decrypt in parallel")
+    ("iterations,n", po::value<size_t>(&options.nIterations)->default_value(10000),
+     "Number of encryptions and decryptions per thread and payload size")
+    ("rotations,r", po::value<size_t>(&options.nRotations)->default_value(100),
+     "Number of CK rotations per key type")
+    ("members,m", po::value<size_t>(&options.nMembers)->default_value(20),
+     "Number of members to add per key type")
+    ("json,j", "Report in JSON instead of a table")
+    ;
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(description).run(), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (vm.count("help") != 0) {
+    std::cerr << description << std::endl;
+    return 0;
+  }
+
+  try {
+    boost::algorithm::split(options.keyTypes, keyTypes, [] (char c) { return c == ','; });
+    for (const auto& keyType : options.keyTypes) {
+      makeKeyParams(keyType); // validate before running anything
+    }
+    options.payloadSizes = parseList(payloadSizes, "payload-sizes");
+    options.threadCounts = parseList(threadCounts, "threads");
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (options.nRotations == 0 || options.nIterations == 0 ||
+      std::count(options.threadCounts.begin(), options.threadCounts.end(), 0) > 0) {
+    std::cerr << "ERROR: iterations, rotations, and threads must be positive" << std::endl;
+    return 1;
+  }
+
+  try {
+    Bench bench(std::move(options));
+    bench.run();
+    if (vm.count("json") != 0) {
+      bench.printJson(std::cout);
+    }
+    else {
+      bench.printTable(std::cout);
+    }
+    return 0;
+  }
+  catch (const std::runtime_error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+} // namespace ndn::nac
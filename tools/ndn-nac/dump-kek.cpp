@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2023, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -73,18 +73,13 @@ nac_dump_kek(int argc, char** argv)
     KeyChain keyChain;
     Identity id = keyChain.getPib().getIdentity(identityName);
 
-    DummyClientFace face(keyChain); // to avoid any real IO
-    AccessManager manager(id, datasetName, keyChain, face);
-
-    if (manager.size() != 1) {
-      std::cerr << "ERROR: Incorrect state of AccessManager instance (expect 1 KDK)" << std::endl;
-      return 2;
-    }
+    auto nacKey = AccessManager::getOrCreateNacKey(id, datasetName, keyChain);
+    auto kek = AccessManager::makeKek(id, nacKey, keyChain);
 
     if (output == "-")
-      io::save(*manager.begin(), std::cout);
+      io::save(kek, std::cout);
     else
-      io::save(*manager.begin(), output);
+      io::save(kek, output);
 
     return 0;
   }
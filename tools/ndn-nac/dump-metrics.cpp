@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "ndn-nac.hpp"
+#include "metrics.hpp"
+
+#include <fstream>
+
+namespace ndn::nac {
+
+int
+nac_dump_metrics(int argc, char** argv)
+{
+  namespace po = boost::program_options;
+
+  std::string input;
+
+  po::options_description description("General Usage\n"
+                                      "  ndn-nac dump-metrics [-h] [-f] file \n"
+                                      "General options");
+  description.add_options()
+    ("help,h", "Produce help message")
+    ("file,f", po::value<std::string>(&input),
+     "File with a metrics snapshot written by a running process with MetricsDumper (or saved with "
+     "MetricsRegistry::Snapshot::save()), stdin if '-' or not specified")
+    ;
+
+  po::positional_options_description p;
+  p.add("file", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(description).positional(p).run(), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (vm.count("help") != 0) {
+    std::cerr << description << std::endl;
+    return 0;
+  }
+
+  if (vm.count("file") == 0)
+    input = "-";
+
+  try {
+    MetricsRegistry::Snapshot snapshot;
+    if (input == "-") {
+      snapshot = MetricsRegistry::Snapshot::load(std::cin);
+    }
+    else {
+      std::ifstream file(input);
+      if (!file) {
+        std::cerr << "ERROR: Cannot open '" << input << "'" << std::endl;
+        return 1;
+      }
+      snapshot = MetricsRegistry::Snapshot::load(file);
+    }
+
+    std::cout << snapshot;
+    return 0;
+  }
+  catch (const Error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+} // namespace ndn::nac
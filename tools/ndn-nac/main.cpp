@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2020, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -31,6 +31,10 @@ const char NAC_HELP_TEXT[] = R"STR(
   version      Show version and exit
   dump-kek     Dump KEK
   add-member   Create KDK for the member
+  add-members  Create KDKs for many members at once
+  dump-metrics Print a saved metrics snapshot
+  bench        Measure the performance of NAC operations on this host
+  serve-bundle Serve the KEK and KDKs exported by an offline access manager
 )STR";
 
 int
@@ -49,6 +53,10 @@ main(int argc, char** argv)
     else if (command == "version")      { std::cout << NDN_NAC_VERSION_BUILD_STRING << std::endl; }
     else if (command == "dump-kek")     { return nac_dump_kek(argc - 1, argv + 1); }
     else if (command == "add-member")   { return nac_add_member(argc - 1, argv + 1); }
+    else if (command == "add-members")  { return nac_add_members(argc - 1, argv + 1); }
+    else if (command == "dump-metrics") { return nac_dump_metrics(argc - 1, argv + 1); }
+    else if (command == "bench")        { return nac_bench(argc - 1, argv + 1); }
+    else if (command == "serve-bundle") { return nac_serve_bundle(argc - 1, argv + 1); }
     else {
       std::cerr << "ERROR: Unknown command '" << command << "'\n"
                 << "\n"
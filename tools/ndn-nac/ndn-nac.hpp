@@ -1,6 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 /*
- * Copyright (c) 2014-2022, Regents of the University of California
+ * Copyright (c) 2014-2026, Regents of the University of California
  *
  * NAC library is free software: you can redistribute it and/or modify it under the
  * terms of the GNU Lesser General Public License as published by the Free Software
@@ -28,7 +28,6 @@
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 
-#include <ndn-cxx/util/dummy-client-face.hpp>
 #include <ndn-cxx/util/exception.hpp>
 #include <ndn-cxx/util/io.hpp>
 
@@ -40,6 +39,18 @@ nac_dump_kek(int argc, char** argv);
 int
 nac_add_member(int argc, char** argv);
 
+int
+nac_add_members(int argc, char** argv);
+
+int
+nac_dump_metrics(int argc, char** argv);
+
+int
+nac_bench(int argc, char** argv);
+
+int
+nac_serve_bundle(int argc, char** argv);
+
 inline Certificate
 loadCertificate(const std::string& fileName)
 {
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2014-2026, Regents of the University of California
+ *
+ * NAC library is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ * NAC library is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+ * PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ *
+ * You should have received copies of the GNU General Public License and GNU Lesser
+ * General Public License along with ndn-cxx, e.g., in COPYING.md file.  If not, see
+ * <http://www.gnu.org/licenses/>.
+ *
+ * See AUTHORS.md for complete list of NAC library authors and contributors.
+ */
+
+#include "ndn-nac.hpp"
+#include "kdk-server.hpp"
+
+namespace ndn::nac {
+
+int
+nac_serve_bundle(int argc, char** argv)
+{
+  namespace po = boost::program_options;
+
+  std::string bundleFile;
+
+  po::options_description description("General Usage\n"
+                                      "  ndn-nac serve-bundle [-h] [-n] [-f] file\n"
+                                      "General options");
+  description.add_options()
+    ("help,h", "Produce help message")
+    ("file,f", po::value<std::string>(&bundleFile),
+     "Bundle with the KEK and KDKs, written by 'ndn-nac add-members -b' or AccessManager::exportBundle()")
+    ("nack,n",
+     "Answer Interests for packets that are not in the bundle with an application-level NACK; "
+     "only if no other producer serves the same prefixes")
+    ;
+
+  po::positional_options_description p;
+  p.add("file", 1);
+
+  po::variables_map vm;
+  try {
+    po::store(po::command_line_parser(argc, argv).options(description).positional(p).run(), vm);
+    po::notify(vm);
+  }
+  catch (const std::exception& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  if (vm.count("help") != 0) {
+    std::cerr << description << std::endl;
+    return 0;
+  }
+
+  if (vm.count("file") == 0) {
+    std::cerr << "ERROR: file must be specified" << std::endl;
+    std::cerr << description << std::endl;
+    return 1;
+  }
+
+  try {
+    // the bundle has everything that is served, already signed, so the data owner's keys
+    // need not be in the KeyChain of this host
+    Face face;
+    KdkServer server(bundleFile, face);
+    server.setNackUnpublished(vm.count("nack") != 0);
+    std::cerr << "Serving " << server.size() << " packets of " << server.getNacIdentity() << std::endl;
+    face.processEvents();
+    return 0;
+  }
+  catch (const std::runtime_error& e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+}
+
+} // namespace ndn::nac